@@ -1,20 +1,70 @@
-QT += widgets
+QT += widgets network concurrent
 
 CONFIG += c++17
 
 SOURCES += main.cpp \
+    adminportclient.cpp \
+    bananaspackage.cpp \
+    benchmark.cpp \
+    buildconfiguration.cpp \
+    buildpool.cpp \
+    buildstatistics.cpp \
+    compileoverlay.cpp \
+    compilerbenchmark.cpp \
+    costanalyzer.cpp \
+    headlessbuild.cpp \
+    nmlcompiler.cpp \
     nmlproject.cpp \
+    paletteanimation.cpp \
+    palettequantizer.cpp \
+    preprocessor.cpp \
+    processsampler.cpp \
+    projectbuilder.cpp \
+    rastertools.cpp \
+    spritecache.cpp \
+    spritecachereader.cpp \
     spriteeditor.cpp \
+    spritehistory.cpp \
+    spriteloader.cpp \
+    spritepalette.cpp \
     syntaxhighlighter.cpp \
+    tablegenerator.cpp \
+    tarwriter.cpp \
     texteditor.cpp \
-    texteditorlist.cpp
+    texteditorlist.cpp \
+    thumbnailcache.cpp
 
 HEADERS += \
+    adminportclient.h \
+    bananaspackage.h \
+    benchmark.h \
+    buildconfiguration.h \
+    buildpool.h \
+    buildstatistics.h \
+    compileoverlay.h \
+    compilerbenchmark.h \
+    costanalyzer.h \
+    headlessbuild.h \
+    nmlcompiler.h \
     nmlproject.h \
+    paletteanimation.h \
+    palettequantizer.h \
+    preprocessor.h \
+    processsampler.h \
+    projectbuilder.h \
+    rastertools.h \
+    spritecache.h \
+    spritecachereader.h \
     spriteeditor.h \
+    spritehistory.h \
+    spriteloader.h \
+    spritepalette.h \
     syntaxhighlighter.h \
+    tablegenerator.h \
+    tarwriter.h \
     texteditor.h \
     texteditorlist.h \
+    thumbnailcache.h \
     version.h \
     windowwithclosesignal.hpp
 
@@ -22,3 +72,29 @@ RESOURCES += \
     resource.qrc
 
 win32:RC_FILE = resource.rc
+
+#liblzma compresses the BaNaNaS packages, without it they are written as uncompressed .tar files
+unix{
+    CONFIG += link_pkgconfig
+    packagesExist(liblzma){
+        PKGCONFIG += liblzma
+    }
+    else{
+        DEFINES += NO_LZMA
+    }
+}
+win32{
+    #Set LZMA_DIR to a folder containing include/lzma.h and lib/liblzma, for example qmake LZMA_DIR=C:/xz
+    isEmpty(LZMA_DIR): LZMA_DIR = $$(LZMA_DIR)
+    isEmpty(LZMA_DIR){
+        DEFINES += NO_LZMA
+    }
+    else{
+        INCLUDEPATH += $$LZMA_DIR/include
+        LIBS += -L$$LZMA_DIR/lib -llzma
+    }
+}
+!contains(DEFINES, NO_LZMA){
+    SOURCES += xzwriter.cpp
+    HEADERS += xzwriter.h
+}
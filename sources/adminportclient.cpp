@@ -0,0 +1,153 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include <QtEndian>
+#include "adminportclient.h"
+#include "version.h"
+
+const quint16 AdminPortClient::defaultPort = 3977;
+const quint16 AdminPortClient::errorColor = 3;
+
+AdminPortClient::AdminPortClient(QObject *parent):
+    QObject(parent),
+    _port(defaultPort),
+    _finished(false)
+{
+    this->_timeout.setSingleShot(true);
+    this->_timeout.setInterval(10000);
+    QObject::connect(&this->_timeout, &QTimer::timeout, this, [this](){
+        this->finish(false, QObject::tr("OpenTTD didn't answer in time."));
+    });
+
+    QObject::connect(&this->_socket, &QTcpSocket::connected, this, [this](){
+        this->_socket.write(packet(AdminJoin, string(this->_password) + string("NMLCreator") + string(PROGRAMVERSION)));
+    });
+    QObject::connect(&this->_socket, &QTcpSocket::readyRead, this, &AdminPortClient::readPackets);
+    QObject::connect(&this->_socket, &QAbstractSocket::errorOccurred, this, [this](QAbstractSocket::SocketError error){
+        if(error == QAbstractSocket::RemoteHostClosedError){
+            this->finish(false, QObject::tr("OpenTTD closed the connection. Make sure that the admin password is correct."));
+        }
+        else{
+            this->finish(false, QObject::tr("Could not connect to OpenTTD at %1:%2 (%3). Make sure that OpenTTD is running a multiplayer game and that its admin port is enabled.").arg(this->_host).arg(this->_port).arg(this->_socket.errorString()));
+        }
+    });
+}
+
+void AdminPortClient::runCommand(const QString &host, quint16 port, const QString &password, const QString &command){
+    this->_host = host;
+    this->_port = port;
+    this->_password = password;
+    this->_command = command;
+    this->_timeout.start();
+    this->_socket.connectToHost(host, port);
+}
+
+void AdminPortClient::reloadNewGRFs(){
+    const QSettings settings("OpenTTD", "NMLCreator");
+    this->runCommand(settings.value("openttd/adminHost", "localhost").toString(), settings.value("openttd/adminPort", defaultPort).toUInt(), settings.value("openttd/adminPassword", "").toString(), "reload_newgrfs");
+}
+
+QStringList AdminPortClient::output() const{
+    return this->_output;
+}
+
+QStringList AdminPortClient::errors() const{
+    return this->_errors;
+}
+
+QString AdminPortClient::serverName() const{
+    return this->_serverName;
+}
+
+QByteArray AdminPortClient::packet(PacketType type, const QByteArray &payload){
+    QByteArray packet(3, '\0');
+    qToLittleEndian<quint16>(payload.size() + 3, packet.data());
+    packet[2] = static_cast<char>(type);
+    return packet + payload;
+}
+
+QByteArray AdminPortClient::string(const QString &text){
+    return text.toUtf8() + '\0';
+}
+
+void AdminPortClient::readPackets(){
+    this->_buffer += this->_socket.readAll();
+    while(this->_buffer.size() >= 3){
+        const quint16 size = qFromLittleEndian<quint16>(this->_buffer.constData());
+        if(size < 3){
+            this->finish(false, QObject::tr("OpenTTD sent an invalid packet."));
+            return;
+        }
+        if(this->_buffer.size() < size){
+            return;    //Wait for the rest of the packet
+        }
+        const PacketType type = static_cast<PacketType>(static_cast<quint8>(this->_buffer[2]));
+        const QByteArray payload = this->_buffer.mid(3, size - 3);
+        this->_buffer.remove(0, size);
+        this->handlePacket(type, payload);
+        if(this->_finished){
+            return;
+        }
+    }
+}
+
+void AdminPortClient::handlePacket(PacketType type, const QByteArray &payload){
+    int position = 0;
+    switch(type){
+        case ServerFull:
+            this->finish(false, QObject::tr("OpenTTD doesn't accept any more admin connections."));
+            break;
+        case ServerBanned:
+            this->finish(false, QObject::tr("OpenTTD refused the connection because this computer is banned."));
+            break;
+        case ServerError:
+            this->finish(false, QObject::tr("OpenTTD refused the connection (error %1). Make sure that the admin password is correct.").arg(payload.isEmpty() ? -1 : static_cast<quint8>(payload[0])));
+            break;
+        case ServerProtocol:
+            break;    //Only tells which updates can be subscribed to, which isn't needed to run a command
+        case ServerWelcome:
+            //The server is ready to receive commands once it has welcomed the client
+            this->_serverName = readString(payload, &position);
+            this->_socket.write(packet(AdminRcon, string(this->_command)));
+            break;
+        case ServerRcon:{
+            //Each line starts with its color in 2 bytes, OpenTTD prints errors in red and older versions also start them with "ERROR:"
+            const quint16 color = (payload.size() >= 2) ? qFromLittleEndian<quint16>(payload.constData()) : 0;
+            position = 2;
+            const QString line = readString(payload, &position);
+            this->_output.append(line);
+            if(color == errorColor || line.startsWith("ERROR", Qt::CaseInsensitive)){
+                this->_errors.append(line);
+            }
+            break;
+        }
+        case ServerRconEnd:
+            this->_socket.write(packet(AdminQuit));
+            this->_socket.flush();
+            if(!this->_errors.isEmpty()){
+                this->finish(false, QObject::tr("OpenTTD refused to run %1: %2").arg(this->_command, this->_errors.join(" ")));
+                break;
+            }
+            this->finish(true, this->_serverName.isEmpty() ? QObject::tr("OpenTTD ran %1.").arg(this->_command) : QObject::tr("%1 ran %2.").arg(this->_serverName, this->_command));
+            break;
+        default:
+            break;    //Other packets, for example chat messages, are ignored
+    }
+}
+
+void AdminPortClient::finish(bool success, const QString &message){
+    if(this->_finished){
+        return;
+    }
+    this->_finished = true;
+    this->_timeout.stop();
+    this->_socket.disconnect(this);
+    this->_socket.disconnectFromHost();
+    emit this->finished(success, message);
+}
+
+QString AdminPortClient::readString(const QByteArray &payload, int *position){
+    const int end = payload.indexOf('\0', *position);
+    const QString text = QString::fromUtf8(payload.mid(*position, (end < 0) ? -1 : end - *position));
+    *position = (end < 0) ? payload.size() : end + 1;
+    return text;
+}
@@ -0,0 +1,61 @@
+#ifndef ADMINPORTCLIENT_H
+#define ADMINPORTCLIENT_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QTimer>
+
+//Connects to the admin port of a running OpenTTD server and runs a console command, for example to reload the NewGRFs after compiling
+//The admin port has to be enabled in OpenTTD by setting network.admin_password in openttd.cfg
+class AdminPortClient : public QObject{
+    Q_OBJECT
+
+public:
+    //The packet types of the admin protocol that are used, as defined in src/network/core/tcp_admin.h in the OpenTTD source code
+    enum PacketType : quint8{
+        AdminJoin = 0,
+        AdminQuit = 1,
+        AdminRcon = 5,
+        ServerFull = 100,
+        ServerBanned = 101,
+        ServerError = 102,
+        ServerProtocol = 103,
+        ServerWelcome = 104,
+        ServerRcon = 120,
+        ServerRconEnd = 125
+    };
+
+    AdminPortClient(QObject *parent = nullptr);
+
+    void runCommand(const QString &host, quint16 port, const QString &password, const QString &command);    //Emits finished when the command was run or if it failed
+    void reloadNewGRFs();    //Runs reload_newgrfs with the host, port and password in the settings
+
+    QStringList output() const;    //The lines printed in the console of OpenTTD by the command
+    QStringList errors() const;    //The lines of the output that OpenTTD printed as errors, the command failed if there are any
+    QString serverName() const;
+
+    static QByteArray packet(PacketType type, const QByteArray &payload = QByteArray());    //Each packet starts with its size in 2 bytes (little-endian, including the 3 bytes of the header) and its type in 1 byte
+    static QByteArray string(const QString &text);    //Strings are encoded in UTF-8 and terminated by a null byte
+
+    static const quint16 defaultPort;
+    static const quint16 errorColor;    //The color OpenTTD prints console errors in (TC_RED)
+
+signals:
+    void finished(bool success, const QString &message);
+
+private:
+    void readPackets();
+    void handlePacket(PacketType type, const QByteArray &payload);
+    void finish(bool success, const QString &message);
+    static QString readString(const QByteArray &payload, int *position);
+
+    QTcpSocket _socket;
+    QTimer _timeout;
+    QByteArray _buffer;
+    QString _host, _password, _command, _serverName;
+    quint16 _port;
+    QStringList _output, _errors;
+    bool _finished;
+};
+
+#endif // ADMINPORTCLIENT_H
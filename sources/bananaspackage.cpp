@@ -0,0 +1,156 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include "bananaspackage.h"
+#include "buildconfiguration.h"
+#include "tarwriter.h"
+#ifndef NO_LZMA
+    #include "xzwriter.h"
+#endif
+
+const QStringList BananasPackage::documentationFileNames = {"readme.txt", "changelog.txt", "license.txt"};
+
+bool BananasPackage::create(const QString &nmlFile, const QString &grfFile, Info *info, QString *error){
+    QFile grf(grfFile);
+    if(!grf.open(QFile::ReadOnly)){
+        *error = QObject::tr("Could not open the file %1. Please compile the project first.").arg(grfFile);
+        return false;
+    }
+
+    //The package is written to a temporary file first, so that a failed packaging doesn't overwrite the previous package
+    const QString package = packageFile(nmlFile);
+    QSaveFile file(package);
+#ifdef NO_LZMA
+    QIODevice &archive = file;
+    if(!file.open(QFile::WriteOnly)){
+#else
+    XzWriter xz(&file);
+    QIODevice &archive = xz;
+    if(!file.open(QFile::WriteOnly) || !xz.open(QIODevice::WriteOnly)){
+#endif
+        *error = QObject::tr("You do not have permission to create the file %1.").arg(package);
+        return false;
+    }
+
+    //The files are in a folder named after the project, like in the packages downloaded by OpenTTD
+    const QDir projectDir = QFileInfo(nmlFile).absoluteDir();
+    const QString folder = QFileInfo(nmlFile).completeBaseName();
+    TarWriter tar(&archive);
+    info->grfFile = grfFile;
+    info->packageFile = package;
+    info->files = QStringList(QFileInfo(grfFile).fileName());
+
+    //Only the beginning of the .grf file is kept to find the GRF ID, Action 8 is one of the first sprites
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    qint64 md5Remaining = md5Size(grf.peek(14), grf.size());
+    QByteArray grfStart;
+    const int grfStartSize = 64 * 1024;
+    bool written = tar.addDirectory(folder, QDateTime::currentDateTime()) && tar.addFile(folder + "/" + QFileInfo(grfFile).fileName(), &grf, grf.size(), QFileInfo(grfFile).lastModified(), [&md5, &md5Remaining, &grfStart, grfStartSize](const QByteArray &block){
+        if(md5Remaining > 0){
+            md5.addData(block.left(int(qMin<qint64>(md5Remaining, block.size()))));
+            md5Remaining -= block.size();
+        }
+        if(grfStart.size() < grfStartSize){
+            grfStart += block.left(grfStartSize - grfStart.size());
+        }
+    });
+    for(const QString &documentationFile: documentationFiles(nmlFile)){
+        if(!written){
+            break;
+        }
+        QFile documentation(documentationFile);
+        if(!documentation.open(QFile::ReadOnly)){
+            *error = QObject::tr("Could not open the file %1.").arg(documentationFile);
+            return false;
+        }
+        written = tar.addFile(folder + "/" + QFileInfo(documentationFile).fileName(), &documentation, documentation.size(), QFileInfo(documentationFile).lastModified());
+        info->files.append(projectDir.relativeFilePath(documentationFile));
+    }
+    written = written && tar.finish();
+#ifdef NO_LZMA
+    if(!written || !file.commit()){
+        *error = QObject::tr("Could not create the package %1.").arg(package) + " " + (tar.errorString().isEmpty() ? file.errorString() : tar.errorString());
+        return false;
+    }
+#else
+    if(!written || !xz.finish() || !file.commit()){
+        *error = QObject::tr("Could not create the package %1.").arg(package) + " " + (tar.errorString().isEmpty() ? xz.errorString() : tar.errorString());
+        return false;
+    }
+#endif
+
+    info->md5 = md5.result().toHex();
+    info->grfId = grfId(grfStart);
+    info->grfSize = grf.size();
+    info->packageSize = QFileInfo(package).size();
+    return true;
+}
+
+QString BananasPackage::grfFile(const QString &nmlFile){
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(nmlFile)){
+        if(configuration.enabled && configuration.outputType == "grf"){
+            return configuration.outputPath(nmlFile);
+        }
+    }
+    return "";
+}
+
+QString BananasPackage::packageFile(const QString &nmlFile){
+    //Not next to the .grf file, since OpenTTD also loads the NewGRFs in the .tar files of its newgrf folder
+#ifdef NO_LZMA
+    return QFileInfo(nmlFile).absolutePath() + "/" + QFileInfo(nmlFile).completeBaseName() + ".tar";
+#else
+    return QFileInfo(nmlFile).absolutePath() + "/" + QFileInfo(nmlFile).completeBaseName() + ".tar.xz";
+#endif
+}
+
+qint64 BananasPackage::md5Size(const QByteArray &grfHeader, qint64 fileSize){
+    //Like GRFGetSizeOfDataSection() in OpenTTD: for container version 2, only the signature, the offset of the sprite section and the data section are included, not the sprites
+    const QByteArray signature("\x00\x00GRF\x82\x0D\x0A\x1A\x0A", 10);
+    if(grfHeader.size() < 14 || !grfHeader.startsWith(signature)){
+        return fileSize;
+    }
+    const qint64 dataSize = qFromLittleEndian<quint32>(grfHeader.constData() + signature.size());
+    if(dataSize >= 1024 * 1024 * 1024){
+        return fileSize;    //OpenTTD doesn't trust such a large offset either and hashes the whole file
+    }
+    return qMin(fileSize, 14 + dataSize);
+}
+
+QStringList BananasPackage::documentationFiles(const QString &nmlFile){
+    const QDir projectDir = QFileInfo(nmlFile).absoluteDir();
+    QStringList files;
+    for(const QString &fileName: projectDir.entryList(QDir::Files)){
+        if(documentationFileNames.contains(fileName.toLower())){
+            files.append(projectDir.absoluteFilePath(fileName));
+        }
+    }
+    return files;
+}
+
+QString BananasPackage::grfId(const QByteArray &grfData){
+    //Container version 2 starts with a signature, the offset of the sprite section (4 bytes) and the compression (1 byte)
+    //In both versions, each sprite then starts with its size (4 bytes in version 2, 2 bytes in version 1) and its type, 0xFF for pseudo-sprites
+    const QByteArray signature("\x00\x00GRF\x82\x0D\x0A\x1A\x0A", 10);
+    const bool version2 = grfData.startsWith(signature);
+    const int sizeLength = version2 ? 4 : 2;
+    int position = version2 ? signature.size() + 5 : 0;
+    while(position + sizeLength + 1 <= grfData.size()){
+        const quint32 size = version2 ? qFromLittleEndian<quint32>(grfData.constData() + position) : qFromLittleEndian<quint16>(grfData.constData() + position);
+        const quint8 type = static_cast<quint8>(grfData[position + sizeLength]);
+        position += sizeLength + 1;
+        if(size == 0 || (type != 0xFF && !version2)){
+            return "";    //The end of the file, or a real sprite of container version 1 whose size can't be known without decoding it
+        }
+
+        //Action 8 contains the version of the GRF format (1 byte) followed by the GRF ID (4 bytes)
+        if(type == 0xFF && size >= 6 && position + 6 <= grfData.size() && static_cast<quint8>(grfData[position]) == 0x08){
+            return grfData.mid(position + 2, 4).toHex().toUpper();
+        }
+        position += size;
+    }
+    return "";
+}
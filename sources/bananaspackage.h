@@ -0,0 +1,33 @@
+#ifndef BANANASPACKAGE_H
+#define BANANASPACKAGE_H
+
+#include <QStringList>
+
+//Packages a compiled NewGRF with its documentation into a .tar.xz file that can be uploaded to BaNaNaS, the content service of OpenTTD
+//If NMLCreator was built without liblzma (NO_LZMA), the package is an uncompressed .tar file, which BaNaNaS accepts too
+class BananasPackage{
+public:
+    struct Info{
+        QString grfFile;
+        QString packageFile;
+        QStringList files;    //The files in the package, relative to the project folder
+        QString md5;    //The MD5 checksum OpenTTD uses to tell versions of a NewGRF apart, see md5Size()
+        QString grfId;    //As written in Action 8, for example "4E4D0101", empty if the .grf file doesn't contain an Action 8
+        qint64 grfSize;
+        qint64 packageSize;
+    };
+
+    //The .grf file is read only once: it is compressed, and its MD5 checksum and GRF ID are computed, while it is copied to the package
+    static bool create(const QString &nmlFile, const QString &grfFile, Info *info, QString *error);
+
+    static QString grfFile(const QString &nmlFile);    //Returns the output file of the first enabled build configuration that compiles a .grf file, or an empty string if there isn't any
+    static QString packageFile(const QString &nmlFile);    //Returns the package written next to the .nml file, for example "C:/MyProject/MyProject.tar.xz"
+    static qint64 md5Size(const QByteArray &grfHeader, qint64 fileSize);    //Returns how many bytes at the beginning of a .grf file OpenTTD includes in its MD5 checksum, grfHeader is at least the first 14 bytes of the file
+    static QStringList documentationFiles(const QString &nmlFile);    //Returns the readme.txt, changelog.txt and license.txt files of the project that exist
+
+    static QString grfId(const QByteArray &grfData);    //Returns the GRF ID from the first bytes of a .grf file, or an empty string if they don't contain an Action 8
+
+    static const QStringList documentationFileNames;
+};
+
+#endif // BANANASPACKAGE_H
@@ -0,0 +1,220 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSettings>
+#include "benchmark.h"
+#include "bananaspackage.h"
+
+const int Benchmark::maximumHistoryLength = 200;
+const int Benchmark::minimumTimeout = 120000;
+const int Benchmark::timeoutPerTick = 100;
+
+Benchmark::Result::Result():
+    date(QDateTime::currentDateTime()),
+    ticks(0),
+    success(false),
+    loadTime(-1),
+    runTime(-1),
+    cpuTime(-1),
+    peakMemory(-1),
+    msPerTick(-1)
+{}
+
+QJsonObject Benchmark::Result::toJson() const{
+    return QJsonObject({
+        {"date", this->date.toString(Qt::ISODate)},
+        {"savegame", this->savegame},
+        {"ticks", this->ticks},
+        {"grfMd5", this->grfMd5},
+        {"success", this->success},
+        {"error", this->error},
+        {"loadTime", this->loadTime},
+        {"runTime", this->runTime},
+        {"cpuTime", this->cpuTime},
+        {"peakMemory", this->peakMemory},
+        {"msPerTick", this->msPerTick}
+    });
+}
+
+Benchmark::Result Benchmark::Result::fromJson(const QJsonObject &object){
+    Result result;
+    result.date = QDateTime::fromString(object["date"].toString(), Qt::ISODate);
+    result.savegame = object["savegame"].toString();
+    result.ticks = object["ticks"].toInt();
+    result.grfMd5 = object["grfMd5"].toString();
+    result.success = object["success"].toBool();
+    result.error = object["error"].toString();
+    result.loadTime = object["loadTime"].toVariant().toLongLong();
+    result.runTime = object["runTime"].toVariant().toLongLong();
+    result.cpuTime = object["cpuTime"].toVariant().toLongLong();
+    result.peakMemory = object["peakMemory"].toVariant().toLongLong();
+    result.msPerTick = object["msPerTick"].toDouble(-1);
+    return result;
+}
+
+Benchmark::Benchmark(const QString &nmlFile, QObject *parent):
+    QObject(parent),
+    _nmlFile(nmlFile),
+    _loadCpuTime(-1),
+    _running(false)
+{
+    this->_process.setProcessChannelMode(QProcess::MergedChannels);
+    this->_timeout.setSingleShot(true);
+    QObject::connect(&this->_timeout, &QTimer::timeout, [this](){
+        this->finish(QObject::tr("OpenTTD didn't finish within %1 seconds and was stopped.").arg(this->_timeout.interval() / 1000));
+        this->_process.kill();
+        this->_process.waitForFinished(3000);
+    });
+    QObject::connect(&this->_process, &QProcess::started, [this](){
+        this->_sampler.start(this->_process.processId());
+    });
+    QObject::connect(&this->_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &Benchmark::processFinished);
+    QObject::connect(&this->_process, &QProcess::errorOccurred, [this](QProcess::ProcessError error){
+        if(error == QProcess::FailedToStart){
+            this->_sampler.stop();
+            this->finish(QObject::tr("Could not start OpenTTD (%1). Please specify the OpenTTD executable in the settings.").arg(executable()));
+        }
+    });
+}
+
+void Benchmark::start(const QString &savegame, int ticks){
+    if(this->_running){
+        return;
+    }
+    this->_running = true;
+    this->_result = Result();
+    this->_result.savegame = savegame;
+    this->_result.ticks = ticks;
+    this->_loadCpuTime = -1;
+
+    QFile grf(BananasPackage::grfFile(this->_nmlFile));
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    if(grf.open(QFile::ReadOnly) && md5.addData(&grf)){
+        this->_result.grfMd5 = md5.result().toHex();
+    }
+
+    if(ticks < 2){
+        this->finish(QObject::tr("The benchmark must run for at least 2 ticks."));
+        return;
+    }
+    if(!QFileInfo(savegame).isFile()){
+        this->finish(QObject::tr("Could not find the savegame %1.").arg(savegame));
+        return;
+    }
+
+    //Starting OpenTTD and loading the savegame takes much longer than a tick, so a run of a single tick is measured first and subtracted
+    this->runOpenTTD(1);
+}
+
+void Benchmark::cancel(){
+    if(!this->_running){
+        return;
+    }
+    this->finish(QObject::tr("The benchmark was cancelled."));
+    this->_process.kill();
+    this->_process.waitForFinished(3000);    //So that another benchmark can be started right away
+}
+
+bool Benchmark::isRunning() const{
+    return this->_running;
+}
+
+QString Benchmark::executable(){
+    return QSettings("OpenTTD", "NMLCreator").value("openttd/path", OPENTTD).toString();
+}
+
+QStringList Benchmark::arguments(const QString &savegame, int ticks){
+    return {"-v", "null:ticks=" + QString::number(ticks), "-s", "null", "-m", "null", "-g", savegame, "-x"};
+}
+
+QString Benchmark::compare(const Result &previous, const Result &current){
+    if(!previous.success || !current.success || previous.msPerTick <= 0 || current.msPerTick < 0){
+        return QObject::tr("no previous result to compare with");
+    }
+    const double change = (current.msPerTick - previous.msPerTick) / previous.msPerTick * 100;
+    QString text = QObject::tr("%1% compared to the previous run").arg((change >= 0 ? "+" : "") + QString::number(change, 'f', 1));
+    if(previous.savegame != current.savegame || previous.ticks != current.ticks){
+        text += ", " + QObject::tr("which used another savegame or number of ticks");
+    }
+    else if(!current.grfMd5.isEmpty() && previous.grfMd5 == current.grfMd5){
+        text += ", " + QObject::tr("with the same .grf file");
+    }
+    return text;
+}
+
+QList<Benchmark::Result> Benchmark::loadHistory(const QString &nmlFile){
+    QList<Result> history;
+    QFile file(QFileInfo(nmlFile).dir().path() + "/.nmlcreator/benchmarks.json");
+    if(!file.open(QFile::ReadOnly)){
+        return history;
+    }
+    const QJsonArray array = QJsonDocument::fromJson(file.readAll()).array();
+    for(const QJsonValue &value: array){
+        history.append(Result::fromJson(value.toObject()));
+    }
+    return history;
+}
+
+void Benchmark::saveHistory(const QString &nmlFile, const QList<Result> &history){
+    QDir(QFileInfo(nmlFile).dir().path() + "/.nmlcreator").mkpath(".");
+    QJsonArray array;
+    for(int i = qMax(0, history.length() - maximumHistoryLength); i < history.length(); i++){
+        array.append(history[i].toJson());
+    }
+    QSaveFile file(QFileInfo(nmlFile).dir().path() + "/.nmlcreator/benchmarks.json");
+    if(file.open(QFile::WriteOnly)){
+        file.write(QJsonDocument(array).toJson());
+        file.commit();
+    }
+}
+
+void Benchmark::runOpenTTD(int ticks){
+    this->_timer.start();
+    this->_timeout.start(qMax(minimumTimeout, ticks * timeoutPerTick));
+    this->_process.start(executable(), arguments(this->_result.savegame, ticks));
+}
+
+void Benchmark::processFinished(int exitCode, QProcess::ExitStatus exitStatus){
+    const qint64 wallTime = this->_timer.elapsed();
+    this->_sampler.stop();
+    if(!this->_running){
+        return;    //The benchmark was cancelled or timed out and OpenTTD was killed
+    }
+    const QStringList output = QString::fromLocal8Bit(this->_process.readAll()).split("\n", Qt::SkipEmptyParts);
+    if(exitCode != 0 || exitStatus != QProcess::NormalExit){
+        this->finish(QObject::tr("OpenTTD exited with code %1.").arg(exitCode) + (output.isEmpty() ? "" : " " + output.last().trimmed()));
+        return;
+    }
+
+    if(this->_result.loadTime < 0){
+        this->_result.loadTime = wallTime;
+        this->_loadCpuTime = this->_sampler.cpuTime();
+        this->runOpenTTD(this->_result.ticks);
+        return;
+    }
+
+    this->_result.runTime = wallTime;
+    this->_result.cpuTime = (this->_sampler.cpuTime() < 0 || this->_loadCpuTime < 0) ? -1 : qMax(0ll, this->_sampler.cpuTime() - this->_loadCpuTime);
+    this->_result.peakMemory = this->_sampler.peakMemory();
+    this->_result.msPerTick = qMax(0ll, this->_result.runTime - this->_result.loadTime) / double(this->_result.ticks - 1);
+    this->_result.success = true;
+    this->finish();
+}
+
+void Benchmark::finish(const QString &error){
+    this->_result.error = error;
+    this->_result.success = error.isEmpty();
+    this->_running = false;
+    this->_timeout.stop();
+
+    if(this->_result.success){
+        QList<Result> history = loadHistory(this->_nmlFile);
+        history.append(this->_result);
+        saveHistory(this->_nmlFile, history);
+    }
+    emit this->finished(this->_result);
+}
@@ -0,0 +1,80 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QTimer>
+#include "processsampler.h"
+
+#ifdef _WIN32
+    #define OPENTTD "C:/Program Files/OpenTTD/openttd.exe"
+#else
+    #define OPENTTD "openttd"
+#endif
+
+//Measures how much time OpenTTD spends per tick with the compiled NewGRF, by running a savegame without any window or sound for a number of ticks
+//OpenTTD loads the NewGRFs of the savegame from its newgrf folder, so the savegame must use the NewGRF of the project
+class Benchmark : public QObject{
+    Q_OBJECT
+
+public:
+    struct Result{
+        Result();
+
+        QDateTime date;
+        QString savegame;
+        int ticks;
+        QString grfMd5;    //The MD5 checksum of the .grf file that was benchmarked, so that results of the same build can be recognized
+        bool success;
+        QString error;
+
+        //All times are in milliseconds, memory is in kilobytes, -1 means that the value couldn't be measured
+        qint64 loadTime;    //Wall time of a run of a single tick, which is mostly the time needed to start OpenTTD and load the savegame
+        qint64 runTime;    //Wall time of the run of all the ticks
+        qint64 cpuTime;    //CPU time of the run of all the ticks, without the CPU time of the single tick run
+        qint64 peakMemory;
+        double msPerTick;    //(runTime - loadTime) / (ticks - 1)
+
+        QJsonObject toJson() const;
+        static Result fromJson(const QJsonObject &object);
+    };
+
+    Benchmark(const QString &nmlFile, QObject *parent = nullptr);
+
+    void start(const QString &savegame, int ticks);
+    void cancel();    //Kills OpenTTD, the benchmark finishes with an error
+    bool isRunning() const;
+
+    static QString executable();
+    static QStringList arguments(const QString &savegame, int ticks);    //Null video, sound and music drivers, and -x so that the configuration of the user isn't modified
+    static QString compare(const Result &previous, const Result &current);    //For example "+4.1% compared to the previous build"
+
+    static QList<Result> loadHistory(const QString &nmlFile);
+    static void saveHistory(const QString &nmlFile, const QList<Result> &history);
+
+    static const int maximumHistoryLength;
+    static const int minimumTimeout;    //In milliseconds, OpenTTD is stopped if a run takes longer than this or than timeoutPerTick for each tick
+    static const int timeoutPerTick;
+
+signals:
+    void finished(const Benchmark::Result &result);
+
+private:
+    void runOpenTTD(int ticks);
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void finish(const QString &error = QString());
+
+    const QString _nmlFile;
+    QProcess _process;
+    ProcessSampler _sampler;
+    QElapsedTimer _timer;
+    QTimer _timeout;
+    Result _result;
+    qint64 _loadCpuTime;
+    bool _running;
+};
+
+#endif // BENCHMARK_H
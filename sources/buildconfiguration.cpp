@@ -0,0 +1,82 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QRegularExpression>
+#include "buildconfiguration.h"
+
+const QStringList BuildConfiguration::outputTypes = {"grf", "nfo", "nml"};
+
+BuildConfiguration::BuildConfiguration(const QString &name, const QString &outputType, const QString &output, const QStringList &extraArguments, bool enabled):
+    name(name),
+    outputType(outputType),
+    output(output),
+    extraArguments(extraArguments),
+    enabled(enabled)
+{}
+
+QString BuildConfiguration::outputPath(const QString &nmlFile) const{
+    const QDir projectDir = QFileInfo(nmlFile).dir();
+    if(this->output.isEmpty()){
+        //GRF files go where OpenTTD looks for them, other files go in the project folder
+        if(this->outputType == "grf"){
+            return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/OpenTTD/newgrf/" + QFileInfo(nmlFile).baseName() + ".grf";
+        }
+        return projectDir.path() + "/" + QFileInfo(nmlFile).baseName() + "." + this->outputType;
+    }
+    return QDir::cleanPath(projectDir.absoluteFilePath(QString(this->output).replace("\\", "/")));
+}
+
+QString BuildConfiguration::cacheSubfolder() const{
+    //Each configuration gets its own cache so that compilers running at the same time never write to the same cache file
+    if(this->name == defaultConfiguration().name){
+        return "";
+    }
+    return QString(this->name).replace(QRegularExpression("[^\\w.-]"), "_");
+}
+
+QList<BuildConfiguration> BuildConfiguration::load(const QString &nmlFile){
+    QSettings settings(settingsFile(nmlFile), QSettings::IniFormat);
+    QList<BuildConfiguration> configurations;
+    const int size = settings.beginReadArray("buildConfigurations");
+    for(int i = 0; i < size; i++){
+        settings.setArrayIndex(i);
+        configurations.append(BuildConfiguration(
+            settings.value("name").toString(),
+            settings.value("outputType", "grf").toString(),
+            settings.value("output", "").toString(),
+            settings.value("extraArguments", QStringList()).toStringList(),
+            settings.value("enabled", true).toBool()
+        ));
+    }
+    settings.endArray();
+
+    if(configurations.isEmpty()){
+        configurations.append(defaultConfiguration());
+    }
+    return configurations;
+}
+
+void BuildConfiguration::save(const QString &nmlFile, const QList<BuildConfiguration> &configurations){
+    QFileInfo(settingsFile(nmlFile)).dir().mkpath(".");
+    QSettings settings(settingsFile(nmlFile), QSettings::IniFormat);
+    settings.remove("buildConfigurations");
+    settings.beginWriteArray("buildConfigurations", configurations.length());
+    for(int i = 0; i < configurations.length(); i++){
+        settings.setArrayIndex(i);
+        settings.setValue("name", configurations[i].name);
+        settings.setValue("outputType", configurations[i].outputType);
+        settings.setValue("output", configurations[i].output);
+        settings.setValue("extraArguments", configurations[i].extraArguments);
+        settings.setValue("enabled", configurations[i].enabled);
+    }
+    settings.endArray();
+}
+
+BuildConfiguration BuildConfiguration::defaultConfiguration(){
+    return BuildConfiguration("GRF", "grf");
+}
+
+QString BuildConfiguration::settingsFile(const QString &nmlFile){
+    return QFileInfo(nmlFile).dir().path() + "/.nmlcreator/project.ini";
+}
@@ -0,0 +1,29 @@
+#ifndef BUILDCONFIGURATION_H
+#define BUILDCONFIGURATION_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+class BuildConfiguration{
+public:
+    BuildConfiguration(const QString &name = "", const QString &outputType = "grf", const QString &output = "", const QStringList &extraArguments = {}, bool enabled = true);
+
+    QString outputPath(const QString &nmlFile) const;    //Returns the absolute path of the file that the compiler writes for this configuration
+    QString cacheSubfolder() const;    //Returns the folder inside the cache folder used by this configuration, or an empty string for the default configuration
+
+    static QList<BuildConfiguration> load(const QString &nmlFile);
+    static void save(const QString &nmlFile, const QList<BuildConfiguration> &configurations);
+    static BuildConfiguration defaultConfiguration();
+    static QString settingsFile(const QString &nmlFile);    //Returns the file where the project specific settings are stored, for example "C:/MyProject/.nmlcreator/project.ini"
+
+    static const QStringList outputTypes;
+
+    QString name;
+    QString outputType;    //Either "grf", "nfo" or "nml", this is passed to the compiler as --grf, --nfo or --nml
+    QString output;    //Can be empty (in which case a default location is used), an absolute path or a path relative to the project folder
+    QStringList extraArguments;    //Passed to the compiler as they are, for example "--default-lang=english.lng" or "--palette=DOS"
+    bool enabled;
+};
+
+#endif // BUILDCONFIGURATION_H
@@ -0,0 +1,124 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+#include "buildpool.h"
+
+BuildPool::BuildPool(int maximumJobs, QObject *parent):
+    QObject(parent),
+    _maximumJobs(1)
+{
+    this->setMaximumJobs(maximumJobs);
+}
+
+BuildPool *BuildPool::instance(){
+    static BuildPool *pool = new BuildPool(QSettings("OpenTTD", "NMLCreator").value("compiler/maximumJobs", 0).toInt(), qApp);
+    return pool;
+}
+
+int BuildPool::maximumJobs() const{
+    return this->_maximumJobs;
+}
+
+void BuildPool::setMaximumJobs(int maximumJobs){
+    this->_maximumJobs = (maximumJobs > 0) ? maximumJobs : qMax(1, QThread::idealThreadCount());
+    this->startNextJobs();
+}
+
+void BuildPool::enqueue(NMLCompiler *job, Priority priority){
+    QList<NMLCompiler*> cancelledJobs;
+    for(int i = this->_queue.length() - 1; i >= 0; i--){
+        const NMLCompiler *waitingJob = this->_queue[i].job;
+        if(QFileInfo(waitingJob->nmlFile()) == QFileInfo(job->nmlFile()) && waitingJob->configuration().name == job->configuration().name){
+            priority = qMax(priority, this->_queue[i].priority);
+            cancelledJobs.append(this->_queue.takeAt(i).job);
+        }
+    }
+
+    QObject::connect(job, &NMLCompiler::finished, this, [this](NMLCompiler *job){
+        QObject::disconnect(job, nullptr, this, nullptr);
+        this->_runningJobs.removeAll(job);
+        emit this->jobFinished(job);
+        this->startNextJobs();
+        emit this->queueChanged();
+        if(this->isIdle()){
+            emit this->allJobsFinished();
+        }
+    });
+    QObject::connect(job, &QObject::destroyed, this, [this, job](){
+        //The window that owns the job was closed before the job finished
+        this->_runningJobs.removeAll(job);
+        for(int i = this->_queue.length() - 1; i >= 0; i--){
+            if(this->_queue[i].job == job){
+                this->_queue.removeAt(i);
+            }
+        }
+        this->startNextJobs();
+        emit this->queueChanged();
+    });
+    this->_queue.append({job, priority});
+    for(NMLCompiler *cancelledJob: qAsConst(cancelledJobs)){
+        cancelledJob->cancel();
+    }
+    this->startNextJobs();
+    emit this->queueChanged();
+}
+
+void BuildPool::setPriority(QObject *owner, Priority priority){
+    for(WaitingJob &waitingJob: this->_queue){
+        if(waitingJob.job->parent() == owner){
+            waitingJob.priority = priority;
+        }
+    }
+    emit this->queueChanged();
+}
+
+bool BuildPool::isIdle() const{
+    return this->_queue.isEmpty() && this->_runningJobs.isEmpty();
+}
+
+int BuildPool::runningJobs() const{
+    return this->_runningJobs.length();
+}
+
+int BuildPool::waitingJobs() const{
+    return this->_queue.length();
+}
+
+int BuildPool::position(const NMLCompiler *job) const{
+    int index = -1;
+    for(int i = 0; i < this->_queue.length() && index < 0; i++){
+        index = (this->_queue[i].job == job) ? i : -1;
+    }
+    if(index < 0){
+        return -1;
+    }
+
+    //Jobs with a higher priority and jobs with the same priority that were queued earlier are started first
+    int position = 0;
+    for(int i = 0; i < this->_queue.length(); i++){
+        if(this->_queue[i].priority > this->_queue[index].priority || (this->_queue[i].priority == this->_queue[index].priority && i < index)){
+            position++;
+        }
+    }
+    return position;
+}
+
+void BuildPool::startNextJobs(){
+    while(!this->_queue.isEmpty() && this->_runningJobs.length() < this->_maximumJobs){
+        NMLCompiler *job = this->_queue.takeAt(this->nextJob()).job;
+        this->_runningJobs.append(job);
+        emit this->jobStarted(job);
+        job->start();
+    }
+}
+
+int BuildPool::nextJob() const{
+    int next = 0;
+    for(int i = 1; i < this->_queue.length(); i++){
+        if(this->_queue[i].priority > this->_queue[next].priority){
+            next = i;
+        }
+    }
+    return next;
+}
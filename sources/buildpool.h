@@ -0,0 +1,50 @@
+#ifndef BUILDPOOL_H
+#define BUILDPOOL_H
+
+#include <QObject>
+#include <QList>
+#include "nmlcompiler.h"
+
+class BuildPool : public QObject{
+    Q_OBJECT
+
+public:
+    enum Priority{Background, Normal, Foreground};
+
+    BuildPool(int maximumJobs = 0, QObject *parent = nullptr);    //If maximumJobs is 0, one job is run per processor core
+    static BuildPool *instance();    //The pool shared by all the windows of the application, so that they don't all run their compilers at the same time
+
+    int maximumJobs() const;
+    void setMaximumJobs(int maximumJobs);
+
+    //The pool doesn't take ownership of the job
+    //If the same build configuration of the same project is already waiting, the waiting job is cancelled since the new one compiles the same files
+    void enqueue(NMLCompiler *job, Priority priority = Normal);
+    void setPriority(QObject *owner, Priority priority);    //Changes the priority of the waiting jobs whose parent is owner, for example when a window gets the focus
+    bool isIdle() const;
+
+    int runningJobs() const;
+    int waitingJobs() const;
+    int position(const NMLCompiler *job) const;    //Returns how many jobs will be started before this one, or -1 if the job isn't waiting
+
+signals:
+    void jobStarted(NMLCompiler *job);
+    void jobFinished(NMLCompiler *job);
+    void allJobsFinished();
+    void queueChanged();
+
+private:
+    struct WaitingJob{
+        NMLCompiler *job;
+        Priority priority;
+    };
+
+    void startNextJobs();
+    int nextJob() const;    //Returns the index in the queue of the job with the highest priority that has been waiting the longest
+
+    QList<WaitingJob> _queue;
+    QList<NMLCompiler*> _runningJobs;
+    int _maximumJobs;
+};
+
+#endif // BUILDPOOL_H
@@ -0,0 +1,165 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QObject>
+#include <QSaveFile>
+#include "buildstatistics.h"
+
+const int BuildStatistics::maximumHistoryLength = 500;
+
+BuildStatistics::BuildStatistics():
+    date(QDateTime::currentDateTime()),
+    success(false),
+    saveTime(-1),
+    spawnTime(-1),
+    compilerTime(-1),
+    peakMemory(-1),
+    cpuTime(-1),
+    parseTime(-1),
+    populateTime(-1),
+    cacheHits(-1),
+    cacheMisses(-1),
+    cacheSize(-1)
+{}
+
+qint64 BuildStatistics::totalTime() const{
+    return qMax(0ll, this->saveTime) + qMax(0ll, this->spawnTime) + qMax(0ll, this->compilerTime) + qMax(0ll, this->parseTime) + qMax(0ll, this->populateTime);
+}
+
+double BuildStatistics::cacheHitRatio() const{
+    if(this->cacheHits < 0 || this->cacheMisses < 0 || this->cacheHits + this->cacheMisses == 0){
+        return -1;
+    }
+    return double(this->cacheHits) / (this->cacheHits + this->cacheMisses);
+}
+
+QJsonObject BuildStatistics::toJson() const{
+    return QJsonObject({
+        {"date", this->date.toString(Qt::ISODate)},
+        {"configuration", this->configuration},
+        {"success", this->success},
+        {"saveTime", this->saveTime},
+        {"spawnTime", this->spawnTime},
+        {"compilerTime", this->compilerTime},
+        {"peakMemory", this->peakMemory},
+        {"cpuTime", this->cpuTime},
+        {"parseTime", this->parseTime},
+        {"populateTime", this->populateTime},
+        {"totalTime", this->totalTime()},
+        {"cacheHits", this->cacheHits},
+        {"cacheMisses", this->cacheMisses},
+        {"cacheSize", this->cacheSize}
+    });
+}
+
+BuildStatistics BuildStatistics::fromJson(const QJsonObject &object){
+    BuildStatistics statistics;
+    statistics.date = QDateTime::fromString(object["date"].toString(), Qt::ISODate);
+    statistics.configuration = object["configuration"].toString();
+    statistics.success = object["success"].toBool();
+    statistics.saveTime = object["saveTime"].toVariant().toLongLong();
+    statistics.spawnTime = object["spawnTime"].toVariant().toLongLong();
+    statistics.compilerTime = object["compilerTime"].toVariant().toLongLong();
+    statistics.peakMemory = object["peakMemory"].toVariant().toLongLong();
+    statistics.cpuTime = object["cpuTime"].toVariant().toLongLong();
+    statistics.parseTime = object["parseTime"].toVariant().toLongLong();
+    statistics.populateTime = object["populateTime"].toVariant().toLongLong();
+    statistics.cacheHits = object["cacheHits"].toInt(-1);    //Older histories don't have any cache statistics
+    statistics.cacheMisses = object["cacheMisses"].toInt(-1);
+    statistics.cacheSize = object.contains("cacheSize") ? object["cacheSize"].toVariant().toLongLong() : -1;
+    return statistics;
+}
+
+QStringList BuildStatistics::toStringList() const{
+    const auto milliseconds = [](qint64 value){
+        return (value < 0) ? QObject::tr("n/a") : QObject::tr("%1 ms").arg(value);
+    };
+    return {
+        this->date.toString(Qt::ISODate),
+        this->configuration,
+        this->success ? QObject::tr("Success") : QObject::tr("Failed"),
+        milliseconds(this->saveTime),
+        milliseconds(this->spawnTime),
+        milliseconds(this->compilerTime),
+        (this->peakMemory < 0) ? QObject::tr("n/a") : QObject::tr("%1 MB").arg(this->peakMemory / 1024.0, 0, 'f', 1),
+        milliseconds(this->cpuTime),
+        milliseconds(this->parseTime),
+        milliseconds(this->populateTime),
+        milliseconds(this->totalTime()),
+        (this->cacheHitRatio() < 0) ? QObject::tr("n/a") : QObject::tr("%1% (%2/%3)").arg(qRound(this->cacheHitRatio() * 100)).arg(this->cacheHits).arg(this->cacheHits + this->cacheMisses),
+        (this->cacheSize < 0) ? QObject::tr("n/a") : QObject::tr("%1 MB").arg(this->cacheSize / 1048576.0, 0, 'f', 1)
+    };
+}
+
+QStringList BuildStatistics::columnNames(){
+    return {QObject::tr("Date"), QObject::tr("Configuration"), QObject::tr("Result"), QObject::tr("Overlay time"), QObject::tr("Process start"), QObject::tr("Compiler"), QObject::tr("Peak memory"), QObject::tr("CPU time"), QObject::tr("Output parsing"), QObject::tr("Log update"), QObject::tr("Total"), QObject::tr("Cache hits"), QObject::tr("Cache size")};
+}
+
+QList<BuildStatistics> BuildStatistics::loadHistory(const QString &nmlFile){
+    QList<BuildStatistics> history;
+    QFile file(QFileInfo(nmlFile).dir().path() + "/.nmlcreator/buildstatistics.json");
+    if(!file.open(QFile::ReadOnly)){
+        return history;
+    }
+    const QJsonArray array = QJsonDocument::fromJson(file.readAll()).array();
+    for(const QJsonValue &value: array){
+        history.append(fromJson(value.toObject()));
+    }
+    return history;
+}
+
+void BuildStatistics::saveHistory(const QString &nmlFile, const QList<BuildStatistics> &history){
+    QDir(QFileInfo(nmlFile).dir().path() + "/.nmlcreator").mkpath(".");
+    QJsonArray array;
+    for(int i = qMax(0, history.length() - maximumHistoryLength); i < history.length(); i++){
+        array.append(history[i].toJson());
+    }
+    QSaveFile file(QFileInfo(nmlFile).dir().path() + "/.nmlcreator/buildstatistics.json");
+    if(file.open(QFile::WriteOnly)){
+        file.write(QJsonDocument(array).toJson());
+        file.commit();
+    }
+}
+
+bool BuildStatistics::exportCsv(const QString &fileName, const QList<BuildStatistics> &history){
+    QSaveFile file(fileName);
+    if(!file.open(QFile::WriteOnly)){
+        return false;
+    }
+    file.write("date,configuration,success,saveTime,spawnTime,compilerTime,peakMemory,cpuTime,parseTime,populateTime,totalTime,cacheHits,cacheMisses,cacheSize\n");
+    for(const BuildStatistics &statistics: history){
+        const QStringList values = {
+            statistics.date.toString(Qt::ISODate),
+            "\"" + QString(statistics.configuration).replace("\"", "\"\"") + "\"",
+            statistics.success ? "1" : "0",
+            QString::number(statistics.saveTime),
+            QString::number(statistics.spawnTime),
+            QString::number(statistics.compilerTime),
+            QString::number(statistics.peakMemory),
+            QString::number(statistics.cpuTime),
+            QString::number(statistics.parseTime),
+            QString::number(statistics.populateTime),
+            QString::number(statistics.totalTime()),
+            QString::number(statistics.cacheHits),
+            QString::number(statistics.cacheMisses),
+            QString::number(statistics.cacheSize)
+        };
+        file.write((values.join(",") + "\n").toUtf8());
+    }
+    return file.commit();
+}
+
+bool BuildStatistics::exportJson(const QString &fileName, const QList<BuildStatistics> &history){
+    QSaveFile file(fileName);
+    if(!file.open(QFile::WriteOnly)){
+        return false;
+    }
+    QJsonArray array;
+    for(const BuildStatistics &statistics: history){
+        array.append(statistics.toJson());
+    }
+    file.write(QJsonDocument(array).toJson());
+    return file.commit();
+}
@@ -0,0 +1,46 @@
+#ifndef BUILDSTATISTICS_H
+#define BUILDSTATISTICS_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QStringList>
+
+class BuildStatistics{
+public:
+    BuildStatistics();
+
+    qint64 totalTime() const;
+    double cacheHitRatio() const;    //Between 0 and 1, -1 if the cache is disabled or empty
+
+    QJsonObject toJson() const;
+    static BuildStatistics fromJson(const QJsonObject &object);
+    QStringList toStringList() const;    //Returns the values in the same order as columnNames(), formatted to be displayed
+    static QStringList columnNames();
+
+    static QList<BuildStatistics> loadHistory(const QString &nmlFile);
+    static void saveHistory(const QString &nmlFile, const QList<BuildStatistics> &history);
+    static bool exportCsv(const QString &fileName, const QList<BuildStatistics> &history);
+    static bool exportJson(const QString &fileName, const QList<BuildStatistics> &history);
+
+    static const int maximumHistoryLength;
+
+    QDateTime date;
+    QString configuration;
+    bool success;
+
+    //All times are in milliseconds, memory is in kilobytes, -1 means that the value couldn't be measured
+    qint64 saveTime;    //Time spent writing the unsaved files to a temporary copy of the project before compiling
+    qint64 spawnTime;    //Time between asking to start the compiler and the compiler actually running
+    qint64 compilerTime;    //Wall time of the compiler process
+    qint64 peakMemory;
+    qint64 cpuTime;
+    qint64 parseTime;    //Time spent parsing the compiler output
+    qint64 populateTime;    //Time spent adding the messages to the log and to the text editors
+
+    //Sprites reused from the cache of the compiler and sprites that had to be encoded, -1 if the cache is disabled
+    int cacheHits;
+    int cacheMisses;
+    qint64 cacheSize;    //In bytes
+};
+
+#endif // BUILDSTATISTICS_H
@@ -0,0 +1,131 @@
+#include <QFile>
+#include <QFileInfo>
+#include "compileoverlay.h"
+#include "spritecache.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+CompileOverlay::CompileOverlay(const QString &nmlFile, QObject *parent):
+    QObject(parent),
+    _projectDir(QFileInfo(nmlFile).absoluteDir()),
+    _skippedDirectories({SpriteCache::rootDirectory(nmlFile)}),
+    _directory(overlayTemplate(nmlFile))
+{}
+
+void CompileOverlay::setFile(const QString &fileName, const QByteArray &contents){
+    this->_files.insert(QFileInfo(fileName).absoluteFilePath(), contents);
+}
+
+void CompileOverlay::setImage(const QString &fileName, const QImage &image){
+    this->_images.insert(QFileInfo(fileName).absoluteFilePath(), image);
+}
+
+bool CompileOverlay::isEmpty() const{
+    return this->_files.isEmpty() && this->_images.isEmpty();
+}
+
+bool CompileOverlay::create(){
+    if(!this->_directory.isValid()){
+        this->_errorString = QObject::tr("Could not create the folder %1.").arg(this->_directory.path());
+        return false;
+    }
+    if(!this->mirrorDirectory("")){
+        return false;
+    }
+
+    //Only now write the files with unsaved changes, the hard links were skipped for them so that the original files are never written through a link
+    for(auto i = this->_files.constBegin(); i != this->_files.constEnd(); i++){
+        const QString target = this->filePath(i.key());
+        QDir(QFileInfo(target).path()).mkpath(".");
+        QFile::remove(target);
+        QFile file(target);
+        if(!file.open(QFile::WriteOnly) || file.write(i.value()) < 0){
+            this->_errorString = QObject::tr("Could not create the file %1.").arg(target);
+            return false;
+        }
+    }
+    for(auto i = this->_images.constBegin(); i != this->_images.constEnd(); i++){
+        const QString target = this->filePath(i.key());
+        QDir(QFileInfo(target).path()).mkpath(".");
+        QFile::remove(target);
+        if(!i.value().save(target, "png")){
+            this->_errorString = QObject::tr("Could not create the file %1.").arg(target);
+            return false;
+        }
+    }
+    return true;
+}
+
+QString CompileOverlay::errorString() const{
+    return this->_errorString;
+}
+
+QString CompileOverlay::path() const{
+    return this->_directory.path();
+}
+
+QString CompileOverlay::filePath(const QString &originalFile) const{
+    const QString relativePath = this->_projectDir.relativeFilePath(QFileInfo(originalFile).absoluteFilePath());
+    if(relativePath.startsWith("../")){
+        return originalFile;    //Files outside of the project folder are read from the disk
+    }
+    return this->_directory.path() + "/" + relativePath;
+}
+
+bool CompileOverlay::mirrorDirectory(const QString &relativePath){
+    const QFileInfoList entries = QDir(this->_projectDir.filePath(relativePath)).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    for(const QFileInfo &entry: entries){
+        //Hidden folders such as .nmlcreator (which contains the overlay itself), .nmlcache and .git are never read by the compiler
+        //On Windows, they are not hidden by the file system, so they have to be skipped explicitly
+        if(entry.fileName().startsWith(".") || this->_skippedDirectories.contains(QDir::cleanPath(entry.absoluteFilePath()))){
+            continue;
+        }
+
+        const QString relativeEntry = relativePath.isEmpty() ? entry.fileName() : relativePath + "/" + entry.fileName();
+        const QString target = this->_directory.path() + "/" + relativeEntry;
+        if(entry.isSymLink()){
+            if(!QFile::link(entry.symLinkTarget(), target)){
+                this->_errorString = QObject::tr("Could not create the file %1.").arg(target);
+                return false;
+            }
+        }
+        else if(entry.isDir()){
+            if(!QDir().mkpath(target)){
+                this->_errorString = QObject::tr("Could not create the folder %1.").arg(target);
+                return false;
+            }
+            if(!this->mirrorDirectory(relativeEntry)){
+                return false;
+            }
+        }
+        else if(!this->_files.contains(entry.absoluteFilePath()) && !this->_images.contains(entry.absoluteFilePath())){
+            if(!linkFile(entry.absoluteFilePath(), target)){
+                this->_errorString = QObject::tr("Could not create the file %1.").arg(target);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+QString CompileOverlay::overlayTemplate(const QString &nmlFile){
+    //The overlay is in the project folder rather than in the temporary folder of the system, since hard links can't point to another drive
+    const QString metadataDir = QFileInfo(nmlFile).absoluteDir().filePath(".nmlcreator");
+    QDir(metadataDir).mkpath(".");
+    return metadataDir + "/overlay-XXXXXX";
+}
+
+bool CompileOverlay::linkFile(const QString &source, const QString &target){
+    #ifdef _WIN32
+        const bool linked = CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(target).utf16()), reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(source).utf16()), nullptr);
+    #else
+        const bool linked = (::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0);
+    #endif
+
+    //Some file systems, for example FAT32, don't support hard links
+    return linked || QFile::copy(source, target);
+}
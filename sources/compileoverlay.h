@@ -0,0 +1,40 @@
+#ifndef COMPILEOVERLAY_H
+#define COMPILEOVERLAY_H
+
+#include <QObject>
+#include <QDir>
+#include <QImage>
+#include <QMap>
+#include <QTemporaryDir>
+
+//A temporary copy of a project folder in which the files with unsaved changes replace the files on the disk, so that the project can be compiled without saving it
+//The other files are hard links to the original files, so creating the overlay only writes the files that actually changed
+//NMLCreator saves files with QSaveFile, which replaces them by new files, so saving a file while it's compiled doesn't change the file the link points to
+class CompileOverlay : public QObject{
+public:
+    CompileOverlay(const QString &nmlFile, QObject *parent = nullptr);    //The overlay is deleted from the disk together with this object
+
+    void setFile(const QString &fileName, const QByteArray &contents);    //fileName is the path of the original file
+    void setImage(const QString &fileName, const QImage &image);
+    bool isEmpty() const;    //Returns true if no file replaces a file on the disk, in which case the project can be compiled in its own folder
+
+    bool create();    //Returns false if the overlay couldn't be created, errorString() then contains the reason
+    QString errorString() const;
+
+    QString path() const;
+    QString filePath(const QString &originalFile) const;    //Returns the path of the file in the overlay, for example "C:/MyProject/.nmlcreator/overlay-a1B2c3/gfx/sprite.png" for "C:/MyProject/gfx/sprite.png"
+
+private:
+    bool mirrorDirectory(const QString &relativePath);
+    static QString overlayTemplate(const QString &nmlFile);
+    static bool linkFile(const QString &source, const QString &target);
+
+    const QDir _projectDir;
+    const QStringList _skippedDirectories;    //Folders inside the project folder that the compiler never reads, for example the sprite cache
+    QTemporaryDir _directory;
+    QMap<QString, QByteArray> _files;
+    QMap<QString, QImage> _images;
+    QString _errorString;
+};
+
+#endif // COMPILEOVERLAY_H
@@ -0,0 +1,284 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <cmath>
+#include "compilerbenchmark.h"
+#include "nmlcompiler.h"
+
+qint64 CompilerBenchmark::Summary::medianWallTime() const{
+    QList<qint64> values;
+    for(const Run &run: this->runs){
+        if(run.success){
+            values.append(run.wallTime);
+        }
+    }
+    return median(values);
+}
+
+qint64 CompilerBenchmark::Summary::p95WallTime() const{
+    QList<qint64> values;
+    for(const Run &run: this->runs){
+        if(run.success){
+            values.append(run.wallTime);
+        }
+    }
+    return percentile(values, 95);
+}
+
+qint64 CompilerBenchmark::Summary::medianCpuTime() const{
+    QList<qint64> values;
+    for(const Run &run: this->runs){
+        if(run.success && run.cpuTime >= 0){
+            values.append(run.cpuTime);
+        }
+    }
+    return median(values);
+}
+
+qint64 CompilerBenchmark::Summary::peakMemory() const{
+    qint64 peakMemory = -1;
+    for(const Run &run: this->runs){
+        if(run.success){
+            peakMemory = qMax(peakMemory, run.peakMemory);
+        }
+    }
+    return peakMemory;
+}
+
+QByteArray CompilerBenchmark::Summary::md5() const{
+    for(const Run &run: this->runs){
+        if(run.success){
+            return run.md5;
+        }
+    }
+    return QByteArray();
+}
+
+bool CompilerBenchmark::Summary::isDeterministic() const{
+    for(const Run &run: this->runs){
+        if(run.success && run.md5 != this->md5()){
+            return false;
+        }
+    }
+    return true;
+}
+
+int CompilerBenchmark::Summary::failures() const{
+    int failures = 0;
+    for(const Run &run: this->runs){
+        failures += !run.success;
+    }
+    return failures;
+}
+
+CompilerBenchmark::CompilerBenchmark(const QString &nmlFile, QObject *parent):
+    QObject(parent),
+    _nmlFile(nmlFile),
+    _directory(nullptr),
+    _next(0),
+    _cancelled(false)
+{
+    this->_process.setProcessChannelMode(QProcess::MergedChannels);
+    this->_process.setWorkingDirectory(QFileInfo(nmlFile).absolutePath());
+    QObject::connect(&this->_process, &QProcess::started, [this](){
+        this->_sampler.start(this->_process.processId());
+    });
+    QObject::connect(&this->_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &CompilerBenchmark::processFinished);
+    QObject::connect(&this->_process, &QProcess::errorOccurred, [this](QProcess::ProcessError error){
+        if(error == QProcess::FailedToStart && this->isRunning()){
+            this->_sampler.stop();
+            Summary &summary = this->_summaries[this->_schedule[this->_next].first];
+            summary.error = QObject::tr("Could not start the compiler %1.").arg(this->_process.program());
+            if(this->_schedule[this->_next].second){
+                summary.runs.append({false, this->_timer.elapsed(), -1, -1, QByteArray()});
+            }
+            this->_next++;
+            this->runNext();
+        }
+    });
+}
+
+bool CompilerBenchmark::start(const QString &inputFile, const BuildConfiguration &configuration, const QList<Variant> &variants, int runs, bool warmUp, QString *error){
+    if(this->isRunning()){
+        *error = QObject::tr("A compiler benchmark is already running.");
+        return false;
+    }
+    if(variants.isEmpty() || runs < 1){
+        *error = QObject::tr("The benchmark needs at least one variant and one run.");
+        return false;
+    }
+
+    const QString metadataDir = QFileInfo(this->_nmlFile).absoluteDir().filePath(".nmlcreator");
+    QDir(metadataDir).mkpath(".");
+    this->_directory = new QTemporaryDir(metadataDir + "/compilerbenchmark-XXXXXX");
+    if(!this->_directory->isValid()){
+        *error = QObject::tr("Could not create the folder %1.").arg(this->_directory->path());
+        delete this->_directory;
+        this->_directory = nullptr;
+        return false;
+    }
+
+    this->_inputFile = inputFile;
+    this->_configuration = configuration;
+    this->_summaries.clear();
+    this->_schedule.clear();
+    for(int i = 0; i < variants.length(); i++){
+        this->_summaries.append({variants[i], {}, ""});
+        if(warmUp){
+            this->_schedule.append({i, false});    //The warm-up runs fill the sprite caches, like a project that was already compiled before
+        }
+    }
+    for(int run = 0; run < runs; run++){
+        for(int i = 0; i < variants.length(); i++){
+            this->_schedule.append({i, true});
+        }
+    }
+    this->_next = 0;
+    this->_cancelled = false;
+    this->runNext();
+    return true;
+}
+
+void CompilerBenchmark::cancel(){
+    if(!this->isRunning()){
+        return;
+    }
+    this->_cancelled = true;
+    this->_process.kill();
+    this->_process.waitForFinished();
+    if(this->isRunning()){
+        this->_sampler.stop();
+        this->finish(true);
+    }
+}
+
+bool CompilerBenchmark::isRunning() const{
+    return this->_directory != nullptr;
+}
+
+QList<CompilerBenchmark::Summary> CompilerBenchmark::summaries() const{
+    return this->_summaries;
+}
+
+qint64 CompilerBenchmark::median(QList<qint64> values){
+    if(values.isEmpty()){
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    const int middle = values.length() / 2;
+    return (values.length() % 2 == 1) ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+qint64 CompilerBenchmark::percentile(QList<qint64> values, int percent){
+    if(values.isEmpty()){
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    const int rank = static_cast<int>(std::ceil(percent / 100.0 * values.length()));
+    return values[qBound(0, rank - 1, values.length() - 1)];
+}
+
+QList<CompilerBenchmark::Variant> CompilerBenchmark::loadVariants(const QString &nmlFile){
+    QSettings settings(BuildConfiguration::settingsFile(nmlFile), QSettings::IniFormat);
+    QList<Variant> variants;
+    const int size = settings.beginReadArray("compilerBenchmarkVariants");
+    for(int i = 0; i < size; i++){
+        settings.setArrayIndex(i);
+        variants.append({
+            settings.value("name").toString(),
+            settings.value("compiler", "").toString(),
+            settings.value("arguments", QStringList()).toStringList(),
+            settings.value("cache", true).toBool()
+        });
+    }
+    settings.endArray();
+
+    //By default, compare compiling with and without the sprite cache
+    if(variants.isEmpty()){
+        variants.append({QObject::tr("With cache"), "", {}, true});
+        variants.append({QObject::tr("Without cache"), "", {}, false});
+    }
+    return variants;
+}
+
+void CompilerBenchmark::saveVariants(const QString &nmlFile, const QList<Variant> &variants){
+    QFileInfo(BuildConfiguration::settingsFile(nmlFile)).dir().mkpath(".");
+    QSettings settings(BuildConfiguration::settingsFile(nmlFile), QSettings::IniFormat);
+    settings.remove("compilerBenchmarkVariants");
+    settings.beginWriteArray("compilerBenchmarkVariants", variants.length());
+    for(int i = 0; i < variants.length(); i++){
+        settings.setArrayIndex(i);
+        settings.setValue("name", variants[i].name);
+        settings.setValue("compiler", variants[i].compiler);
+        settings.setValue("arguments", variants[i].arguments);
+        settings.setValue("cache", variants[i].cache);
+    }
+    settings.endArray();
+}
+
+void CompilerBenchmark::runNext(){
+    emit this->progress(this->_next, this->_schedule.length());
+    if(this->_next >= this->_schedule.length()){
+        this->finish(false);
+        return;
+    }
+
+    const int index = this->_schedule[this->_next].first;
+    const Variant &variant = this->_summaries[index].variant;
+    const QString variantDir = this->_directory->filePath(QString::number(index));
+    QDir(variantDir).mkpath("cache");
+    QFile::remove(variantDir + "/output." + this->_configuration.outputType);
+
+    //The compiler command can contain arguments, for example "python3 nmlc"
+    QStringList command = QProcess::splitCommand(variant.compiler);
+    if(command.isEmpty()){
+        command.append(NMLCompiler::compilerPath());
+    }
+    QStringList arguments = command.mid(1);
+    arguments << "-c" << "--" + this->_configuration.outputType << variantDir + "/output." + this->_configuration.outputType << this->_inputFile << "--cache-dir=" + variantDir + "/cache";
+    if(!variant.cache){
+        arguments.append("--no-cache");
+    }
+    arguments.append(this->_configuration.extraArguments);
+    arguments.append(variant.arguments);
+
+    this->_timer.start();
+    this->_process.start(command.first(), arguments);
+}
+
+void CompilerBenchmark::processFinished(int exitCode, QProcess::ExitStatus exitStatus){
+    Run run = {exitCode == 0 && exitStatus == QProcess::NormalExit, this->_timer.elapsed(), -1, -1, QByteArray()};
+    this->_sampler.stop();
+    if(this->_cancelled){
+        this->finish(true);
+        return;
+    }
+    run.cpuTime = this->_sampler.cpuTime();
+    run.peakMemory = this->_sampler.peakMemory();
+
+    const int index = this->_schedule[this->_next].first;
+    Summary &summary = this->_summaries[index];
+    const QStringList output = QString::fromLocal8Bit(this->_process.readAll()).split("\n", Qt::SkipEmptyParts);
+    QFile outputFile(this->_directory->filePath(QString::number(index) + "/output." + this->_configuration.outputType));
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    if(run.success && outputFile.open(QFile::ReadOnly) && md5.addData(&outputFile)){
+        run.md5 = md5.result();
+    }
+    else if(!run.success){
+        summary.error = output.isEmpty() ? QObject::tr("The compiler exited with code %1.").arg(exitCode) : output.last().trimmed();
+    }
+
+    if(this->_schedule[this->_next].second){
+        summary.runs.append(run);
+    }
+    this->_next++;
+    this->runNext();
+}
+
+void CompilerBenchmark::finish(bool cancelled){
+    delete this->_directory;
+    this->_directory = nullptr;
+    emit this->finished(cancelled);
+}
@@ -0,0 +1,81 @@
+#ifndef COMPILERBENCHMARK_H
+#define COMPILERBENCHMARK_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "buildconfiguration.h"
+#include "processsampler.h"
+
+//Compiles the same project several times with different compilers or compiler arguments, to find out which one is the fastest and whether they produce the same file
+//The variants are compiled one after another and in turns (A, B, A, B...), so that a change in the load of the computer affects all of them in the same way
+class CompilerBenchmark : public QObject{
+    Q_OBJECT
+
+public:
+    struct Variant{
+        QString name;
+        QString compiler;    //The command that runs the compiler, for example "python3 nml-0.7.5/nmlc", empty for the compiler in the settings
+        QStringList arguments;    //Passed to the compiler after the arguments of the build configuration, for example "--clear-orphaned"
+        bool cache;    //Each variant has its own sprite cache, which is empty at the start of the benchmark
+    };
+    struct Run{
+        bool success;
+        qint64 wallTime;    //In milliseconds
+        qint64 cpuTime;    //In milliseconds, -1 if it couldn't be measured
+        qint64 peakMemory;    //In kilobytes, -1 if it couldn't be measured
+        QByteArray md5;    //The MD5 checksum of the output file
+    };
+    struct Summary{
+        Variant variant;
+        QList<Run> runs;    //Only the measured runs, without the warm-up run
+        QString error;    //The last line printed by the compiler if a run failed
+
+        //Only the runs that succeeded are taken into account
+        qint64 medianWallTime() const;
+        qint64 p95WallTime() const;
+        qint64 medianCpuTime() const;
+        qint64 peakMemory() const;
+        QByteArray md5() const;    //The MD5 checksum of the output file of the first run
+        bool isDeterministic() const;    //Returns true if all the runs produced the same file
+        int failures() const;
+    };
+
+    CompilerBenchmark(const QString &nmlFile, QObject *parent = nullptr);
+
+    //inputFile is the file passed to the compiler, for example the expanded file of a .pnml project, the output file of the build configuration is replaced by a temporary file
+    bool start(const QString &inputFile, const BuildConfiguration &configuration, const QList<Variant> &variants, int runs, bool warmUp, QString *error);
+    void cancel();
+    bool isRunning() const;
+    QList<Summary> summaries() const;
+
+    static qint64 median(QList<qint64> values);
+    static qint64 percentile(QList<qint64> values, int percent);    //Nearest-rank percentile, -1 if there are no values
+
+    static QList<Variant> loadVariants(const QString &nmlFile);
+    static void saveVariants(const QString &nmlFile, const QList<Variant> &variants);
+
+signals:
+    void progress(int done, int total);
+    void finished(bool cancelled);
+
+private:
+    void runNext();
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void finish(bool cancelled);
+
+    const QString _nmlFile;
+    QTemporaryDir *_directory;    //Contains the output files and sprite caches of the variants while the benchmark is running
+    QString _inputFile;
+    BuildConfiguration _configuration;
+    QList<Summary> _summaries;
+    QList<QPair<int, bool>> _schedule;    //The variant of each run, and whether the run is measured
+    int _next;
+    bool _cancelled;
+    QProcess _process;
+    ProcessSampler _sampler;
+    QElapsedTimer _timer;
+};
+
+#endif // COMPILERBENCHMARK_H
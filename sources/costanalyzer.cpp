@@ -0,0 +1,417 @@
+#include <QCryptographicHash>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QtConcurrent>
+#include <functional>
+#include "costanalyzer.h"
+
+const int CostAnalyzer::deepChain = 8;
+const int CostAnalyzer::manyExpensiveVariables = 4;
+
+CostAnalyzer::CostAnalyzer(QObject *parent):
+    QObject(parent),
+    _pending(false)
+{
+    this->_result.switches = 0;
+    QObject::connect(&this->_watcher, &QFutureWatcher<Analysis>::finished, [this](){
+        const Analysis analysis = this->_watcher.result();
+        this->_cache = analysis.cache;
+        this->_result = analysis.result;
+        if(this->_pending){
+            this->startAnalysis();
+        }
+        emit this->finished();
+    });
+}
+
+void CostAnalyzer::analyze(const QStringList &files, const QMap<QString, QString> &unsavedContents){
+    //Only the most recent request is kept, the ones in between are outdated anyway
+    this->_pendingFiles = files;
+    this->_pendingContents = unsavedContents;
+    this->_pending = true;
+    if(!this->isRunning()){
+        this->startAnalysis();
+    }
+}
+
+bool CostAnalyzer::isRunning() const{
+    return this->_watcher.isRunning();
+}
+
+CostAnalyzer::Result CostAnalyzer::result() const{
+    return this->_result;
+}
+
+bool CostAnalyzer::isExpensiveVariable(const QString &name){
+    //Variables 60+x of NML, which take a parameter and are written like functions
+    static const QStringList prefixes = {"nearby_tile_"};
+    static const QStringList names = {"industry_count", "industry_distance", "industry_town_count", "industry_layout_count", "object_count", "object_distance", "other_house_count", "other_house_count_town", "count_veh_id", "cargo_waiting_nearby"};
+    for(const QString &prefix: prefixes){
+        if(name.startsWith(prefix)){
+            return true;
+        }
+    }
+    return names.contains(name);
+}
+
+void CostAnalyzer::startAnalysis(){
+    this->_pending = false;
+    this->_watcher.setFuture(QtConcurrent::run(&CostAnalyzer::run, this->_pendingFiles, this->_pendingContents, this->_cache));
+}
+
+CostAnalyzer::Analysis CostAnalyzer::run(const QStringList &files, const QMap<QString, QString> &unsavedContents, const Cache &cache){
+    struct Definition{
+        QString file;
+        int line;
+        Node node;
+    };
+    QHash<QString, QList<Definition>> switches;
+    QList<QPair<QString, Definition>> callbacks;
+    Analysis analysis;
+
+    //Split each file into blocks, and parse the blocks that aren't in the cache
+    for(const QString &fileName: files){
+        QString content;
+        if(unsavedContents.contains(fileName)){
+            content = unsavedContents[fileName];
+        }
+        else{
+            QFile file(fileName);
+            if(!file.open(QFile::ReadOnly)){
+                continue;
+            }
+            content = QString::fromUtf8(file.readAll());
+        }
+        const QString text = stripCommentsAndStrings(content);
+
+        int depth = 0, line = 1;
+        for(int i = 0; i < text.length(); i++){
+            const QChar c = text[i];
+            if(c == '\n'){
+                line++;
+            }
+            else if(c == '{'){
+                depth++;
+            }
+            else if(c == '}'){
+                depth = qMax(0, depth - 1);
+            }
+            if(depth != 0 || !(c.isLetter() || c == '_') || (i > 0 && (text[i - 1].isLetterOrNumber() || text[i - 1] == '_'))){
+                continue;
+            }
+
+            int end = i;
+            while(end < text.length() && (text[end].isLetterOrNumber() || text[end] == '_')){
+                end++;
+            }
+            const QString keyword = text.mid(i, end - i);
+            if(keyword != "switch" && keyword != "random_switch" && keyword != "item"){
+                i = end - 1;
+                continue;
+            }
+            int open = end;
+            while(open < text.length() && text[open].isSpace()){
+                open++;
+            }
+            const int close = (open < text.length() && text[open] == '(') ? matchingBracket(text, open) : -1;
+            int bodyOpen = close + 1;
+            while(close >= 0 && bodyOpen < text.length() && text[bodyOpen].isSpace()){
+                bodyOpen++;
+            }
+            const int bodyClose = (close >= 0 && bodyOpen < text.length() && text[bodyOpen] == '{') ? matchingBracket(text, bodyOpen) : -1;
+            if(bodyClose < 0){
+                i = end - 1;
+                continue;
+            }
+
+            const QString block = text.mid(i, bodyClose + 1 - i);
+            const QByteArray key = QCryptographicHash::hash(block.toUtf8(), QCryptographicHash::Md5);
+            if(!analysis.cache.contains(key)){
+                const QString header = text.mid(open + 1, close - open - 1);
+                const int bodyLine = text.midRef(i, bodyOpen + 1 - i).count('\n');
+                analysis.cache.insert(key, cache.contains(key) ? cache[key] : parseBlock(keyword, header, text.mid(bodyOpen + 1, bodyClose - bodyOpen - 1), bodyLine));
+            }
+            const Block &parsed = analysis.cache[key];
+            for(const Node &node: parsed.nodes){
+                const Definition definition = {fileName, line + node.line, node};
+                if(parsed.isSwitch){
+                    switches[node.name].append(definition);
+                }
+                else{
+                    callbacks.append({parsed.item, definition});
+                }
+            }
+
+            line += block.count('\n');
+            i = bodyClose;
+        }
+    }
+
+    //Follow the chains of switches, a switch defined several times counts with its most expensive definition
+    struct Cost{
+        int depth;
+        int expensiveVariables;
+        QStringList chain;
+    };
+    QHash<QString, Cost> costs;
+    QSet<QString> visiting;    //NML doesn't allow a switch to use itself, but a chain that loops back must not recurse forever
+    std::function<Cost(const QString&)> cost = [&](const QString &name) -> Cost{
+        if(costs.contains(name)){
+            return costs[name];
+        }
+        Cost worst = {0, 0, {}};
+        if(visiting.contains(name)){
+            return worst;
+        }
+        visiting.insert(name);
+        const QList<Definition> definitions = switches.value(name);
+        for(const Definition &definition: definitions){
+            Cost current = {1, definition.node.expensiveVariables, {name}};
+            int nextExpensiveVariables = 0;
+            for(const QString &reference: definition.node.references){
+                if(reference == name || !switches.contains(reference)){
+                    continue;
+                }
+                const Cost next = cost(reference);
+                if(next.depth + 1 > current.depth){
+                    current.depth = next.depth + 1;
+                    current.chain = QStringList(name) + next.chain;
+                }
+                nextExpensiveVariables = qMax(nextExpensiveVariables, next.expensiveVariables);
+            }
+            current.expensiveVariables += nextExpensiveVariables;
+            if(current.depth > worst.depth){
+                worst.depth = current.depth;
+                worst.chain = current.chain;
+            }
+            worst.expensiveVariables = qMax(worst.expensiveVariables, current.expensiveVariables);
+        }
+        visiting.remove(name);
+        costs.insert(name, worst);
+        return worst;
+    };
+
+    Result &result = analysis.result;
+    result.switches = switches.size();
+    for(const QPair<QString, Definition> &itemCallback: qAsConst(callbacks)){
+        const Definition &definition = itemCallback.second;
+        Callback callback = {itemCallback.first, definition.node.name, definition.file, definition.line, 0, definition.node.expensiveVariables, {}};
+        int nextExpensiveVariables = 0;
+        for(const QString &reference: definition.node.references){
+            if(switches.contains(reference)){
+                const Cost next = cost(reference);
+                if(next.depth > callback.depth){
+                    callback.depth = next.depth;
+                    callback.chain = next.chain;
+                }
+                nextExpensiveVariables = qMax(nextExpensiveVariables, next.expensiveVariables);
+            }
+        }
+        callback.expensiveVariables += nextExpensiveVariables;
+        result.callbacks.append(callback);
+
+        if(callback.depth >= deepChain || callback.expensiveVariables >= manyExpensiveVariables){
+            QString &hotSpot = result.hotSpots[callback.file][callback.line];
+            hotSpot += (hotSpot.isEmpty() ? "" : "\n") + QObject::tr("Callback %1 of %2 goes through up to %n switch(es) and evaluates up to %3 expensive variable(s).", "", callback.depth).arg(callback.callback, callback.item).arg(callback.expensiveVariables);
+            if(!callback.chain.isEmpty()){
+                hotSpot += "\n" + QObject::tr("Longest chain: %1").arg(callback.chain.join(" > "));
+            }
+        }
+    }
+
+    //Switches that evaluate expensive variables themselves are also hot spots, since that's where the cost can be reduced
+    for(auto i = switches.constBegin(); i != switches.constEnd(); i++){
+        for(const Definition &definition: i.value()){
+            if(definition.node.expensiveVariables > 0){
+                QString &hotSpot = result.hotSpots[definition.file][definition.line];
+                hotSpot += (hotSpot.isEmpty() ? "" : "\n") + QObject::tr("Switch %1 evaluates %n expensive variable(s): %2.", "", definition.node.expensiveVariables).arg(i.key(), definition.node.expensiveNames.join(", "));
+            }
+        }
+    }
+
+    return analysis;
+}
+
+CostAnalyzer::Block CostAnalyzer::parseBlock(const QString &keyword, const QString &header, const QString &body, int bodyLine){
+    Block block;
+    const QList<QPair<int, QString>> arguments = split(header, ',');
+
+    //switch(feature, scope, name, expression){...} and random_switch(feature, scope, name[, triggers]){...}
+    block.isSwitch = (keyword != "item");
+    if(block.isSwitch){
+        if(arguments.length() < 3){
+            return block;
+        }
+        QString text = body;
+        for(int i = 3; i < arguments.length(); i++){
+            text += " " + arguments[i].second;
+        }
+        block.nodes.append(parseNode(arguments[2].second.trimmed(), text, 0));
+        return block;
+    }
+
+    //item(feature, name[, id]){... graphics{callback: target; default_target;} ...}
+    block.item = (arguments.length() >= 2) ? arguments[1].second.trimmed() : "";
+    const QRegularExpression graphicsRegex("\\bgraphics\\s*\\{");
+    QRegularExpressionMatchIterator matches = graphicsRegex.globalMatch(body);
+    while(matches.hasNext()){
+        const QRegularExpressionMatch match = matches.next();
+        const int open = match.capturedEnd() - 1;
+        const int close = matchingBracket(body, open);
+        if(close < 0){
+            break;
+        }
+        const QRegularExpression entryRegex("^\\s*([A-Za-z_]\\w*)\\s*:(.*)$", QRegularExpression::DotMatchesEverythingOption);
+        for(const QPair<int, QString> &entry: split(body.mid(open + 1, close - open - 1), ';')){
+            if(entry.second.trimmed().isEmpty()){
+                continue;
+            }
+            int start = 0;
+            while(entry.second[start].isSpace()){
+                start++;
+            }
+            const int line = bodyLine + body.leftRef(open + 1 + entry.first + start).count('\n');
+            const QRegularExpressionMatch entryMatch = entryRegex.match(entry.second);
+            block.nodes.append(entryMatch.hasMatch() ? parseNode(entryMatch.captured(1), entryMatch.captured(2), line) : parseNode("default", entry.second, line));
+        }
+    }
+    return block;
+}
+
+CostAnalyzer::Node CostAnalyzer::parseNode(const QString &name, const QString &text, int line){
+    Node node = {name, line, 0, {}, {}};
+
+    QSet<QString> references;
+    const QRegularExpression identifierRegex("\\b([A-Za-z_]\\w*)\\b(\\s*\\()?");
+    QRegularExpressionMatchIterator matches = identifierRegex.globalMatch(text);
+    while(matches.hasNext()){
+        const QRegularExpressionMatch match = matches.next();
+        const QString identifier = match.captured(1);
+        if(!match.captured(2).isEmpty() && isExpensiveVariable(identifier)){
+            node.expensiveVariables++;
+            if(!node.expensiveNames.contains(identifier)){
+                node.expensiveNames.append(identifier);
+            }
+        }
+        references.insert(identifier);
+    }
+    node.references = references.values();
+
+    //Variables accessed by number, for example var[0x61, 0, 0xFF, 0x01], only 60+x variables take a parameter
+    const QRegularExpression variableRegex("\\bvar\\s*\\[\\s*(0[xX][0-9A-Fa-f]+|[0-9]+)\\s*,");
+    matches = variableRegex.globalMatch(text);
+    while(matches.hasNext()){
+        const QString number = matches.next().captured(1);
+        bool ok;
+        const int variable = number.startsWith("0x", Qt::CaseInsensitive) ? number.mid(2).toInt(&ok, 16) : number.toInt(&ok);
+        if(ok && variable >= 0x60 && variable <= 0x7F){
+            node.expensiveVariables++;
+            const QString variableName = QString("var[0x%1]").arg(variable, 2, 16, QChar('0'));
+            if(!node.expensiveNames.contains(variableName)){
+                node.expensiveNames.append(variableName);
+            }
+        }
+    }
+    return node;
+}
+
+QString CostAnalyzer::stripCommentsAndStrings(const QString &text){
+    QString result = text;
+    enum{Code, LineComment, BlockComment, String, Directive} state = Code;
+    bool lineStart = true;
+    for(int i = 0; i < result.length(); i++){
+        const QChar c = result[i];
+        const QChar next = (i + 1 < result.length()) ? result[i + 1] : QChar();
+        if(c == '\n'){
+            if(state != BlockComment){
+                state = Code;
+            }
+            lineStart = true;
+            continue;
+        }
+        switch(state){
+        case Code:
+            if(c == '/' && next == '/'){
+                state = LineComment;
+            }
+            else if(c == '/' && next == '*'){
+                state = BlockComment;
+                result[i] = ' ';
+                i++;
+            }
+            else if(c == '"'){
+                state = String;
+            }
+            else if(c == '#' && lineStart){
+                state = Directive;    //#include, #define and the line markers of .pnml files
+            }
+            else{
+                lineStart = lineStart && c.isSpace();
+                continue;
+            }
+            result[i] = ' ';
+            break;
+        case BlockComment:
+            result[i] = ' ';
+            if(c == '*' && next == '/'){
+                state = Code;
+                result[i + 1] = ' ';
+                i++;
+            }
+            break;
+        case String:
+            if(c == '\\' && next != '\n'){
+                result[i + 1] = ' ';
+                result[i] = ' ';
+                i++;
+                continue;
+            }
+            if(c == '"'){
+                state = Code;
+            }
+            result[i] = ' ';
+            break;
+        default:
+            result[i] = ' ';
+            break;
+        }
+        lineStart = false;
+    }
+    return result;
+}
+
+int CostAnalyzer::matchingBracket(const QString &text, int open){
+    const QChar openBracket = text[open];
+    const QChar closeBracket = (openBracket == '(') ? ')' : (openBracket == '[') ? ']' : '}';
+    int depth = 0;
+    for(int i = open; i < text.length(); i++){
+        if(text[i] == openBracket){
+            depth++;
+        }
+        else if(text[i] == closeBracket && --depth == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+QList<QPair<int, QString>> CostAnalyzer::split(const QString &text, QChar separator){
+    QList<QPair<int, QString>> parts;
+    int depth = 0, start = 0;
+    for(int i = 0; i < text.length(); i++){
+        const QChar c = text[i];
+        if(c == '(' || c == '[' || c == '{'){
+            depth++;
+        }
+        else if(c == ')' || c == ']' || c == '}'){
+            depth--;
+        }
+        else if(c == separator && depth == 0){
+            parts.append({start, text.mid(start, i - start)});
+            start = i + 1;
+        }
+    }
+    parts.append({start, text.mid(start)});
+    return parts;
+}
@@ -0,0 +1,84 @@
+#ifndef COSTANALYZER_H
+#define COSTANALYZER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+
+//Estimates how much work OpenTTD does to evaluate the callbacks of the NewGRF, by following the chains of switches and random switches that each callback of each item goes through
+//Long chains and variables that take a parameter (such as nearby_tile_* or var[0x60, ...]) are what makes a NewGRF slow in the game
+//The analysis runs on another thread, and the switches and items that didn't change since the previous analysis aren't parsed again
+class CostAnalyzer : public QObject{
+    Q_OBJECT
+
+public:
+    struct Callback{
+        QString item;
+        QString callback;    //"default" for the graphics entry without a name
+        QString file;
+        int line;
+        int depth;    //The number of switches in the longest chain this callback can go through
+        int expensiveVariables;    //The number of expensive variables evaluated by the most expensive chain this callback can go through
+        QStringList chain;    //The switches in the longest chain
+    };
+    struct Result{
+        QList<Callback> callbacks;
+        QMap<QString, QMap<int, QString>> hotSpots;    //The description of each line that should be annotated, for each file
+        int switches;
+    };
+
+    CostAnalyzer(QObject *parent = nullptr);
+
+    void analyze(const QStringList &files, const QMap<QString, QString> &unsavedContents);    //If an analysis is already running, this one starts when it is finished
+    bool isRunning() const;
+    Result result() const;    //The result of the last analysis that finished
+
+    static bool isExpensiveVariable(const QString &name);
+
+    static const int deepChain;    //Callbacks going through at least this many switches are hot spots
+    static const int manyExpensiveVariables;    //Callbacks evaluating at least this many expensive variables are hot spots
+
+signals:
+    void finished();
+
+private:
+    //A switch, or a callback in the graphics block of an item
+    struct Node{
+        QString name;
+        int line;    //Relative to the start of the block
+        int expensiveVariables;
+        QStringList expensiveNames;
+        QStringList references;    //Every identifier used by the node, the ones that are names of switches are the next switches in the chain
+    };
+    //A switch, random switch or item, parsed only once as long as its text doesn't change
+    struct Block{
+        bool isSwitch;
+        QString item;
+        QList<Node> nodes;
+    };
+    typedef QHash<QByteArray, Block> Cache;
+    struct Analysis{
+        Result result;
+        Cache cache;    //Only contains the blocks of the files that were analyzed, so that it doesn't grow forever
+    };
+
+    void startAnalysis();
+
+    static Analysis run(const QStringList &files, const QMap<QString, QString> &unsavedContents, const Cache &cache);
+    static Block parseBlock(const QString &keyword, const QString &header, const QString &body, int bodyLine);
+    static Node parseNode(const QString &name, const QString &text, int line);
+    static QString stripCommentsAndStrings(const QString &text);    //Replaces comments, strings and preprocessor directives by spaces, without changing the line numbers
+    static int matchingBracket(const QString &text, int open);    //Returns the position of the bracket closing the one at open, or -1 if there is none
+    static QList<QPair<int, QString>> split(const QString &text, QChar separator);    //Splits at the separators that aren't between brackets, each part is returned with its position
+
+    QFutureWatcher<Analysis> _watcher;
+    Cache _cache;
+    Result _result;
+    QStringList _pendingFiles;
+    QMap<QString, QString> _pendingContents;
+    bool _pending;
+};
+
+#endif // COSTANALYZER_H
@@ -0,0 +1,383 @@
+#include <QCommandLineParser>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <functional>
+#include "headlessbuild.h"
+#include "bananaspackage.h"
+
+bool HeadlessBuild::isRequested(int argc, char **argv){
+    for(int i = 1; i < argc; i++){
+        const QString argument(argv[i]);
+        if(argument == "--build" || argument.startsWith("--build=") || argument == "--batch" || argument.startsWith("--batch=")){
+            return true;
+        }
+    }
+    return false;
+}
+
+int HeadlessBuild::run(const QStringList &arguments){
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("Builds NML projects without opening any window."));
+    parser.addHelpOption();
+    const QCommandLineOption buildOption("build", QObject::tr("Builds the NML project <project>, for example MyProject/MyProject.nml."), "project");
+    const QCommandLineOption batchOption("batch", QObject::tr("Builds every NML project in the folder <folder> and its subfolders."), "folder");
+    const QCommandLineOption outputOption("output", QObject::tr("Writes the compiled file to <output> instead of the location set in the build configuration. If several build configurations or projects are built, <output> is a folder."), "output");
+    const QCommandLineOption jobsOption("jobs", QObject::tr("Runs at most <n> compilers at the same time. With --batch, this is also the number of projects built at the same time. Defaults to the number of processor cores."), "n", "0");
+    const QCommandLineOption configurationOption("configuration", QObject::tr("Only builds the build configuration named <name>. Can be specified several times. Defaults to all the enabled build configurations."), "name");
+    const QCommandLineOption formatOption("format", QObject::tr("Prints the errors and warnings as <format>, either \"text\" (file:line: type: message) or \"json\" (one JSON object per line)."), "format", "text");
+    const QCommandLineOption summaryOption("summary", QObject::tr("With --batch, also writes the summary table to the CSV file <file>."), "file");
+    const QCommandLineOption packageOption("package", QObject::tr("After building, packages the .grf file of each project with its readme.txt, changelog.txt and license.txt into a .tar.xz file in the project folder, ready to be uploaded to BaNaNaS."));
+    parser.addOptions({buildOption, batchOption, outputOption, jobsOption, configurationOption, formatOption, summaryOption, packageOption});
+    if(!parser.parse(arguments)){
+        err << parser.errorText() << "\n" << parser.helpText();
+        return InvalidArguments;
+    }
+    if(parser.isSet("help")){
+        out << parser.helpText();
+        return Success;
+    }
+
+    bool jobsIsValid = false;
+    const int jobs = parser.value(jobsOption).toInt(&jobsIsValid);
+    const QString format = parser.value(formatOption);
+    if(!jobsIsValid || jobs < 0 || (format != "text" && format != "json") || parser.isSet(buildOption) == parser.isSet(batchOption)){
+        err << parser.helpText();
+        return InvalidArguments;
+    }
+    const bool json = (format == "json");
+    const QString output = parser.isSet(outputOption) ? QFileInfo(QString(parser.value(outputOption)).replace("\\", "/")).absoluteFilePath() : "";
+
+    //Find the projects to build
+    QStringList nmlFiles;
+    QString batchDirectory;
+    if(parser.isSet(buildOption)){
+        const QString nmlFile = QFileInfo(QString(parser.value(buildOption)).replace("\\", "/")).absoluteFilePath();
+        if(!QFileInfo(nmlFile).isFile()){
+            printError(err, json, nmlFile, QObject::tr("Could not find file %1.").arg(nmlFile));
+            return FileNotFound;
+        }
+        nmlFiles.append(nmlFile);
+    }
+    else{
+        batchDirectory = QFileInfo(QString(parser.value(batchOption)).replace("\\", "/")).absoluteFilePath();
+        if(!QFileInfo(batchDirectory).isDir()){
+            printError(err, json, batchDirectory, QObject::tr("Could not find folder %1.").arg(batchDirectory));
+            return PathNotFound;
+        }
+        nmlFiles = findProjects(batchDirectory);
+        if(nmlFiles.isEmpty()){
+            printError(err, json, batchDirectory, QObject::tr("The folder %1 does not contain any NML project.").arg(batchDirectory));
+            return PathNotFound;
+        }
+    }
+
+    //With --batch, each project writes to its own subfolder of --output, named after the folder of the project relative to the batch folder, so that projects with the same file names don't overwrite each other
+    QMap<QString, QList<BuildConfiguration>> projectConfigurations;
+    QSet<QString> outputFiles;
+    for(const QString &nmlFile: qAsConst(nmlFiles)){
+        QString projectOutput = output;
+        if(!batchDirectory.isEmpty() && !output.isEmpty()){
+            projectOutput = QDir::cleanPath(output + "/" + QDir(batchDirectory).relativeFilePath(QFileInfo(nmlFile).path()));
+        }
+        const QList<BuildConfiguration> configurations = selectConfigurations(nmlFile, parser.values(configurationOption), projectOutput, parser.isSet(batchOption));
+        for(const BuildConfiguration &configuration: configurations){
+            const QString outputFile = QFileInfo(configuration.outputPath(nmlFile)).absoluteFilePath();
+            if(outputFiles.contains(outputFile)){
+                printError(err, json, nmlFile, QObject::tr("Several build configurations would write to %1. Give them different output files, or use --output to write each project to its own folder.").arg(outputFile));
+                return InvalidArguments;
+            }
+            outputFiles.insert(outputFile);
+        }
+        projectConfigurations.insert(nmlFile, configurations);
+    }
+
+    //Create a builder for each project, all of them share the same pool of compilers
+    BuildPool pool(jobs);
+    QList<ProjectBuilder*> builders;
+    for(const QString &nmlFile: qAsConst(nmlFiles)){
+        ProjectBuilder *builder = new ProjectBuilder(nmlFile, projectConfigurations.value(nmlFile), &pool);
+        QObject::connect(builder, &ProjectBuilder::compilerFinished, [&out, json, builder](NMLCompiler *compiler){
+            for(const NMLCompiler::Message &message: compiler->messages()){
+                printMessage(out, json, builder, compiler, message);
+            }
+            out.flush();
+        });
+        builders.append(builder);
+    }
+
+    //Only start as many projects at the same time as there are compilers in the pool, so that the sprites of all the projects aren't converted at once
+    QEventLoop loop;
+    int nextBuilder = 0;
+    int finishedBuilders = 0;
+    int runningBuilders = 0;
+    std::function<void()> startNextBuilders = [&](){
+        while(runningBuilders < pool.maximumJobs() && nextBuilder < builders.length()){
+            runningBuilders++;
+            builders[nextBuilder++]->start();
+        }
+    };
+    for(ProjectBuilder *builder: qAsConst(builders)){
+        QObject::connect(builder, &ProjectBuilder::finished, [&](ProjectBuilder *finishedBuilder){
+            for(const QString &error: finishedBuilder->errors()){
+                printError(out, json, finishedBuilder->nmlFile(), error);
+            }
+            finishedBuilders++;
+            runningBuilders--;
+            if(builders.length() > 1){
+                err << "[" << finishedBuilders << "/" << builders.length() << "] " << finishedBuilder->nmlFile() << ": " << status(finishedBuilder) << "\n";
+                err.flush();
+            }
+            if(finishedBuilders == builders.length()){
+                loop.quit();
+            }
+            else{
+                startNextBuilders();
+            }
+        });
+    }
+    startNextBuilders();
+    if(finishedBuilders < builders.length()){
+        loop.exec();
+    }
+
+    //Now that no compiler is running anymore, remove the least recently used sprites from the caches that are too large
+    if(SpriteCache::isEnabled()){
+        QMap<QString, QStringList> cacheDirs;
+        for(ProjectBuilder *builder: qAsConst(builders)){
+            for(NMLCompiler *compiler: builder->compilers()){
+                cacheDirs[SpriteCache::budgetDirectory(builder->nmlFile())].append(SpriteCache::directory(builder->nmlFile(), compiler->configuration()));
+            }
+        }
+        for(auto i = cacheDirs.constBegin(); i != cacheDirs.constEnd(); i++){
+            SpriteCache::prune(i.key(), SpriteCache::budget(), i.value());
+        }
+    }
+
+    //Package the projects that were compiled successfully
+    bool packagingFailed = false;
+    if(parser.isSet(packageOption)){
+        for(ProjectBuilder *builder: qAsConst(builders)){
+            if(!builder->succeeded()){
+                continue;
+            }
+            QString grfFile;
+            for(NMLCompiler *compiler: builder->compilers()){
+                if(grfFile.isEmpty() && compiler->configuration().outputType == "grf"){
+                    grfFile = compiler->configuration().outputPath(builder->nmlFile());
+                }
+            }
+            BananasPackage::Info info;
+            QString error = QObject::tr("None of the build configurations that were built compiles a .grf file.");
+            if(grfFile.isEmpty() || !BananasPackage::create(builder->nmlFile(), grfFile, &info, &error)){
+                printError(err, json, builder->nmlFile(), error);
+                packagingFailed = true;
+                continue;
+            }
+            if(json){
+                out << QJsonDocument(QJsonObject({{"project", builder->nmlFile()}, {"package", info.packageFile}, {"files", QJsonArray::fromStringList(info.files)}, {"grfId", info.grfId}, {"md5", info.md5}, {"size", info.packageSize}})).toJson(QJsonDocument::Compact) << "\n";
+            }
+            else{
+                err << QObject::tr("Packaged %1 to %2 (GRF ID %3, MD5 %4)").arg(QFileInfo(grfFile).fileName(), info.packageFile, info.grfId.isEmpty() ? "-" : info.grfId, info.md5) << "\n";
+            }
+        }
+    }
+
+    //Print a summary
+    if(builders.length() == 1){
+        for(NMLCompiler *compiler: builders[0]->compilers()){
+            err << compiler->configuration().name << ": " << (compiler->result() == NMLCompiler::Success ? QObject::tr("compiled successfully to %1").arg(compiler->configuration().outputPath(compiler->nmlFile())) : compiler->result() == NMLCompiler::CompilerNotFound ? QObject::tr("compiler %1 not found").arg(NMLCompiler::compilerPath()) : QObject::tr("compilation failed")) << " (" << compiler->duration() << " ms";
+            if(compiler->statistics().cacheHitRatio() >= 0){
+                err << ", " << QObject::tr("%1% of the sprites reused from the cache").arg(qRound(compiler->statistics().cacheHitRatio() * 100));
+            }
+            err << ")\n";
+        }
+    }
+    else if(json){
+        for(ProjectBuilder *builder: qAsConst(builders)){
+            out << QJsonDocument(QJsonObject({{"project", builder->nmlFile()}, {"status", status(builder)}, {"duration", builder->duration()}, {"grfSize", grfSize(builder)}, {"cacheHits", cacheStatistics(builder).cacheHits}, {"cacheMisses", cacheStatistics(builder).cacheMisses}})).toJson(QJsonDocument::Compact) << "\n";
+        }
+    }
+    else{
+        const QStringList header = {QObject::tr("Project"), QObject::tr("Status"), QObject::tr("Duration"), QObject::tr("GRF size"), QObject::tr("Cache hits")};
+        QList<QStringList> rows;
+        QVector<int> widths;
+        for(const QString &column: header){
+            widths.append(column.length());
+        }
+        for(ProjectBuilder *builder: qAsConst(builders)){
+            const qint64 size = grfSize(builder);
+            const double cacheHitRatio = cacheStatistics(builder).cacheHitRatio();
+            rows.append({QFileInfo(builder->nmlFile()).fileName(), status(builder), QString::number(builder->duration() / 1000.0, 'f', 1) + " s", (size < 0) ? "-" : QString::number(size / 1024.0, 'f', 1) + " KiB", (cacheHitRatio < 0) ? "-" : QString::number(qRound(cacheHitRatio * 100)) + "%"});
+            for(int i = 0; i < widths.length(); i++){
+                widths[i] = qMax(widths[i], rows.last()[i].length());
+            }
+        }
+        rows.prepend(header);
+        for(const QStringList &row: qAsConst(rows)){
+            for(int i = 0; i < row.length(); i++){
+                out << ((i == 0 || i == 1) ? row[i].leftJustified(widths[i]) : row[i].rightJustified(widths[i])) << ((i + 1 < row.length()) ? "  " : "\n");
+            }
+        }
+    }
+    if(parser.isSet(summaryOption) && !writeSummary(parser.value(summaryOption), builders)){
+        printError(err, json, parser.value(summaryOption), QObject::tr("You do not have permission to create the file %1.").arg(parser.value(summaryOption)));
+    }
+
+    int exitCode = Success;
+    for(ProjectBuilder *builder: qAsConst(builders)){
+        if(builder->compilerNotFound()){
+            exitCode = CompilerNotFound;
+        }
+        else if(!builder->succeeded() && exitCode == Success){
+            exitCode = CompilationFailed;
+        }
+    }
+    if(packagingFailed && exitCode == Success){
+        exitCode = CompilationFailed;
+    }
+    qDeleteAll(builders);
+    return exitCode;
+}
+
+QStringList HeadlessBuild::findProjects(const QString &directory){
+    //Use the same convention as when opening a file from the command line: a project is a folder containing a .nml or .pnml file with the same name, or any such file next to a lang or gfx folder
+    const QDir dir(QFileInfo(directory).absoluteFilePath());
+    for(const QString &suffix: QStringList({".nml", ".pnml"})){
+        if(QFileInfo(dir.absoluteFilePath(dir.dirName() + suffix)).isFile()){
+            return {dir.absoluteFilePath(dir.dirName() + suffix)};
+        }
+    }
+    const QStringList nmlFiles = dir.entryList({"*.nml", "*.pnml"}, QDir::Files, QDir::Name);
+    if(!nmlFiles.isEmpty() && (dir.exists("lang") || dir.exists("gfx"))){
+        return {dir.absoluteFilePath(nmlFiles[0])};
+    }
+
+    QStringList projects;
+    const QStringList subdirectories = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDir::Name);
+    for(const QString &subdirectory: subdirectories){
+        projects.append(findProjects(dir.absoluteFilePath(subdirectory)));
+    }
+    return projects;
+}
+
+QList<BuildConfiguration> HeadlessBuild::selectConfigurations(const QString &nmlFile, const QStringList &names, const QString &output, bool outputIsFolder){
+    QList<BuildConfiguration> configurations;
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(nmlFile)){
+        if(names.isEmpty() ? configuration.enabled : names.contains(configuration.name)){
+            configurations.append(configuration);
+        }
+    }
+    if(output.isEmpty()){
+        return configurations;
+    }
+
+    if(configurations.length() == 1 && !outputIsFolder){
+        configurations[0].output = output;
+    }
+    else{
+        QDir(output).mkpath(".");
+        for(BuildConfiguration &configuration: configurations){
+            configuration.output = output + "/" + QFileInfo(configuration.outputPath(nmlFile)).fileName();
+        }
+    }
+    return configurations;
+}
+
+qint64 HeadlessBuild::grfSize(const ProjectBuilder *builder){
+    qint64 size = -1;
+    for(NMLCompiler *compiler: builder->compilers()){
+        if(compiler->result() == NMLCompiler::Success && compiler->configuration().outputType == "grf"){
+            size = qMax(0ll, size) + QFileInfo(compiler->configuration().outputPath(builder->nmlFile())).size();
+        }
+    }
+    return size;
+}
+
+BuildStatistics HeadlessBuild::cacheStatistics(const ProjectBuilder *builder){
+    BuildStatistics statistics;
+    for(NMLCompiler *compiler: builder->compilers()){
+        if(compiler->statistics().cacheHits >= 0){
+            statistics.cacheHits = qMax(0, statistics.cacheHits) + compiler->statistics().cacheHits;
+            statistics.cacheMisses = qMax(0, statistics.cacheMisses) + compiler->statistics().cacheMisses;
+            statistics.cacheSize = qMax(0ll, statistics.cacheSize) + compiler->statistics().cacheSize;
+        }
+    }
+    return statistics;
+}
+
+QString HeadlessBuild::status(const ProjectBuilder *builder){
+    if(builder->succeeded()){
+        return "success";
+    }
+    else if(builder->compilerNotFound()){
+        return "compiler not found";
+    }
+    else if(!builder->errors().isEmpty()){
+        return "error";
+    }
+    return "failed";
+}
+
+bool HeadlessBuild::writeSummary(const QString &fileName, const QList<ProjectBuilder*> &builders){
+    QSaveFile file(fileName);
+    if(!file.open(QFile::WriteOnly)){
+        return false;
+    }
+    file.write("project,status,duration_ms,grf_size_bytes,cache_hits,cache_misses\n");
+    for(const ProjectBuilder *builder: builders){
+        file.write(("\"" + QString(builder->nmlFile()).replace("\"", "\"\"") + "\"," + status(builder) + "," + QString::number(builder->duration()) + "," + QString::number(grfSize(builder)) + "," + QString::number(cacheStatistics(builder).cacheHits) + "," + QString::number(cacheStatistics(builder).cacheMisses) + "\n").toUtf8());
+    }
+    return file.commit();
+}
+
+void HeadlessBuild::printMessage(QTextStream &stream, bool json, const ProjectBuilder *builder, const NMLCompiler *compiler, const NMLCompiler::Message &message){
+    if(message.text.trimmed().isEmpty()){
+        return;
+    }
+    if(NMLCompiler::isFilteredWarning(message.text)){
+        return;
+    }
+
+    const QString type = (message.type == NMLCompiler::Error) ? "error" : (message.type == NMLCompiler::Warning) ? "warning" : "info";
+    const QString file = message.file.isEmpty() ? "" : QDir::cleanPath(QFileInfo(builder->nmlFile()).dir().absoluteFilePath(message.file));
+    const QString description = QString(message.text).remove(QRegularExpression("^\\s*nmlc\\s*(?:error|warning|info)\\s*:\\s*(?:\"[^\"]+\"\\s*,\\s*line\\s*[0-9]+\\s*:\\s*)?", QRegularExpression::CaseInsensitiveOption)).trimmed();
+
+    if(json){
+        const QJsonObject object({
+            {"project", builder->nmlFile()},
+            {"configuration", compiler->configuration().name},
+            {"type", type},
+            {"file", file},
+            {"line", message.line},
+            {"message", description}
+        });
+        stream << QJsonDocument(object).toJson(QJsonDocument::Compact) << "\n";
+    }
+    else if(!file.isEmpty()){
+        stream << file << ":" << message.line << ": " << type << ": " << description << " [" << compiler->configuration().name << "]\n";
+    }
+    else{
+        stream << builder->nmlFile() << ": " << type << ": " << description << " [" << compiler->configuration().name << "]\n";
+    }
+}
+
+void HeadlessBuild::printError(QTextStream &stream, bool json, const QString &nmlFile, const QString &error){
+    if(json){
+        stream << QJsonDocument(QJsonObject({{"project", nmlFile}, {"type", "error"}, {"message", error}})).toJson(QJsonDocument::Compact) << "\n";
+    }
+    else{
+        stream << nmlFile << ": error: " << error << "\n";
+    }
+    stream.flush();
+}
@@ -0,0 +1,35 @@
+#ifndef HEADLESSBUILD_H
+#define HEADLESSBUILD_H
+
+#include <QTextStream>
+#include "projectbuilder.h"
+
+//Builds projects from the command line without opening any window, for example "NMLCreator --build MyProject/MyProject.nml" or "NMLCreator --batch MyProjects"
+class HeadlessBuild{
+public:
+    enum ExitCode{
+        Success = 0,
+        CompilationFailed = 1,    //Also used if the project couldn't be packaged
+        FileNotFound = 2,    //The system cannot find the file specified.
+        PathNotFound = 3,    //The system cannot find the path specified.
+        InvalidArguments = 87,    //The parameter is incorrect.
+        CompilerNotFound = 127    //Same as a shell that can't find a command
+    };
+
+    static bool isRequested(int argc, char **argv);
+    static int run(const QStringList &arguments);
+
+    static QStringList findProjects(const QString &directory);    //Returns the .nml file of every project in the directory and its subdirectories
+
+    static void printMessage(QTextStream &stream, bool json, const ProjectBuilder *builder, const NMLCompiler *compiler, const NMLCompiler::Message &message);
+    static void printError(QTextStream &stream, bool json, const QString &nmlFile, const QString &error);
+
+private:
+    static QList<BuildConfiguration> selectConfigurations(const QString &nmlFile, const QStringList &names, const QString &output, bool outputIsFolder);
+    static qint64 grfSize(const ProjectBuilder *builder);
+    static BuildStatistics cacheStatistics(const ProjectBuilder *builder);    //Returns the sum of the cache statistics of all the compilers of the project
+    static QString status(const ProjectBuilder *builder);
+    static bool writeSummary(const QString &fileName, const QList<ProjectBuilder*> &builders);
+};
+
+#endif // HEADLESSBUILD_H
@@ -1,10 +1,19 @@
 #include <QApplication>
 #include <QtWidgets>
 #include "nmlproject.h"
+#include "headlessbuild.h"
 
 int main(int argc, char **argv){
+    const bool headless = HeadlessBuild::isRequested(argc, argv);
+    if(headless){
+        qputenv("QT_QPA_PLATFORM", "offscreen");    //Don't require a display when building from the command line
+    }
     QApplication app(argc, argv);
 
+    if(headless){
+        return HeadlessBuild::run(app.arguments());
+    }
+
     if(argc >= 2){
         const QString fileToOpen = QString(argv[1]).replace("\\", "/");
         const QString type = QFileInfo(fileToOpen).suffix();
@@ -16,18 +25,21 @@ int main(int argc, char **argv){
             QMessageBox::critical(nullptr, "", QObject::tr("Could not open file %1.").arg(fileToOpen));
             return 4;    //The system cannot open the file.
         }
-        else if(type == "nml"){
+        else if(type == "nml" || type == "pnml"){
             new NMLProject(fileToOpen);
         }
         else if(type == "lng" || type == "png"){
             const QDir langDir = QFileInfo(fileToOpen).dir();
             const QDir projectDir = QFileInfo(langDir.path()).dir();
-            const QString nmlFile = projectDir.path() + "/" + projectDir.dirName() + ".nml";
+            QString nmlFile = projectDir.path() + "/" + projectDir.dirName() + ".nml";
+            if(!QFile(nmlFile).exists()){
+                nmlFile = projectDir.path() + "/" + projectDir.dirName() + ".pnml";
+            }
             if(QFile(nmlFile).exists() && QFile(nmlFile).open(QFile::ReadOnly)){
                 new NMLProject(nmlFile, fileToOpen);
             }
             else{
-                const QStringList &nmlFiles = projectDir.entryList({"*.nml"}, QDir::Files);
+                const QStringList &nmlFiles = projectDir.entryList({"*.nml", "*.pnml"}, QDir::Files);
                 if((type == "lng" && langDir.dirName() != "lang") || (type == "png" && langDir.dirName() != "gfx") || nmlFiles.isEmpty()){
                     QMessageBox::critical(nullptr, "", QObject::tr("The file %1 does not seem to be part of an NML project.").arg(argv[1]));
                     return 3;    //The system cannot find the path specified.
@@ -0,0 +1,177 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include <QFileInfo>
+#include <QDir>
+#include <QRegularExpression>
+#include "nmlcompiler.h"
+
+NMLCompiler::NMLCompiler(const QString &nmlFile, const BuildConfiguration &configuration, QObject *parent):
+    QObject(parent),
+    _nmlFile(nmlFile),
+    _inputFile(nmlFile),
+    _sourceDirectory(QFileInfo(nmlFile).absolutePath()),
+    _configuration(configuration),
+    _result(NotFinished),
+    _duration(0)
+{
+    this->_process.setWorkingDirectory(this->_sourceDirectory);
+    this->_statistics.configuration = configuration.name;
+
+    QObject::connect(&this->_process, &QProcess::started, [this](){
+        this->_statistics.spawnTime = this->_timer.elapsed();
+        this->_sampler.start(this->_process.processId());
+    });
+    QObject::connect(&this->_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), [this](int exitCode, QProcess::ExitStatus exitStatus){
+        this->_duration = this->_timer.elapsed();
+        this->_sampler.stop();
+        this->_statistics.compilerTime = this->_duration - this->_statistics.spawnTime;
+        this->_statistics.peakMemory = this->_sampler.peakMemory();
+        this->_statistics.cpuTime = this->_sampler.cpuTime();
+
+        QElapsedTimer parseTimer;
+        parseTimer.start();
+        this->_output = QString::fromLatin1(this->_process.readAllStandardError()).split("\n");
+        const QString projectDir = QFileInfo(this->_nmlFile).absolutePath();
+        if(this->_sourceDirectory != projectDir){
+            //Make the messages refer to the files of the project rather than to their temporary copies
+            for(QString &line: this->_output){
+                line.replace(this->_sourceDirectory, projectDir).replace(QDir::toNativeSeparators(this->_sourceDirectory), QDir::toNativeSeparators(projectDir));
+            }
+        }
+        for(const QString &line: qAsConst(this->_output)){
+            const QPair<QString, int> fileAndLineNumber = NMLCompiler::fileAndLineNumber(line);
+            this->_messages.append({line, messageType(line), fileAndLineNumber.first, fileAndLineNumber.second});
+        }
+        this->_statistics.parseTime = parseTimer.elapsed();
+
+        //Sprites that were already in the cache before compiling were reused, the others had to be encoded
+        if(SpriteCache::isEnabled()){
+            const QString cacheDir = SpriteCache::directory(this->_nmlFile, this->_configuration);
+            const QSet<QString> cacheEntries = SpriteCache::entries(cacheDir);
+            this->_statistics.cacheHits = QSet<QString>(cacheEntries).intersect(this->_cacheEntries).size();
+            this->_statistics.cacheMisses = cacheEntries.size() - this->_statistics.cacheHits;
+            this->_statistics.cacheSize = SpriteCache::size(cacheDir);
+            SpriteCache::markUsed(SpriteCache::budgetDirectory(this->_nmlFile), cacheDir, projectDir);
+        }
+
+        this->_result = (exitCode == 0 && exitStatus == QProcess::NormalExit) ? Success : Failed;
+        this->_statistics.success = (this->_result == Success);
+        emit this->finished(this);
+    });
+    QObject::connect(&this->_process, &QProcess::errorOccurred, [this](QProcess::ProcessError error){
+        if(error != QProcess::FailedToStart){
+            return;    //The finished signal is emitted for all the other errors
+        }
+        this->_duration = this->_timer.elapsed();
+        this->_result = CompilerNotFound;
+        emit this->finished(this);
+    });
+}
+
+const QString &NMLCompiler::nmlFile() const{
+    return this->_nmlFile;
+}
+
+const QString &NMLCompiler::inputFile() const{
+    return this->_inputFile;
+}
+
+void NMLCompiler::setInputFile(const QString &inputFile){
+    this->_inputFile = inputFile;
+}
+
+const QString &NMLCompiler::sourceDirectory() const{
+    return this->_sourceDirectory;
+}
+
+void NMLCompiler::setSourceDirectory(const QString &sourceDirectory){
+    this->_sourceDirectory = sourceDirectory;
+    this->_process.setWorkingDirectory(sourceDirectory);
+}
+
+const BuildConfiguration &NMLCompiler::configuration() const{
+    return this->_configuration;
+}
+
+QStringList NMLCompiler::arguments() const{
+    QSettings settings("OpenTTD", "NMLCreator");
+    //The output file and the cache are absolute paths, since the compiler may run in a temporary copy of the project folder
+    QStringList args = {"-c", "--" + this->_configuration.outputType, QFileInfo(this->_configuration.outputPath(this->_nmlFile)).absoluteFilePath(), this->_inputFile, "--cache-dir=" + SpriteCache::directory(this->_nmlFile, this->_configuration)};
+    if(!settings.value("compiler/enableCache", true).toBool()){
+        args.append("--no-cache");
+    }
+    if(!settings.value("compiler/clearUnusedCache", false).toBool()){
+        args.append("--clear-orphaned");
+    }
+    if(!settings.value("compiler/enableWarnings", true).toBool()){
+        args.append("--quiet");
+    }
+    args.append(this->_configuration.extraArguments);
+    return args;
+}
+
+NMLCompiler::Result NMLCompiler::result() const{
+    return this->_result;
+}
+
+QStringList NMLCompiler::output() const{
+    return this->_output;
+}
+
+QList<NMLCompiler::Message> NMLCompiler::messages() const{
+    return this->_messages;
+}
+
+qint64 NMLCompiler::duration() const{
+    return this->_duration;
+}
+
+BuildStatistics NMLCompiler::statistics() const{
+    return this->_statistics;
+}
+
+QString NMLCompiler::compilerPath(){
+    return QSettings("OpenTTD", "NMLCreator").value("compiler/path", NMLCOMPILER).toString();
+}
+
+NMLCompiler::MessageType NMLCompiler::messageType(const QString &message){
+    if(message.contains(QRegularExpression("^\\s*(?:nmlc|pnml)\\s*error", QRegularExpression::CaseInsensitiveOption))){
+        return Error;
+    }
+    else if(message.contains(QRegularExpression("^\\s*(?:nmlc|pnml)\\s*warning", QRegularExpression::CaseInsensitiveOption))){
+        return Warning;
+    }
+    return Information;
+}
+
+QPair<QString, int> NMLCompiler::fileAndLineNumber(const QString &message){
+    const QRegularExpression regex("^\\s*(?:nmlc|pnml)\\s*(?:error|warning)\\s*:\\s*\"([^\"]+)\"\\s*,\\s*line\\s*([0-9]+)", QRegularExpression::CaseInsensitiveOption);
+    const QRegularExpressionMatch match = regex.match(message);
+    if(!match.hasMatch()){
+        return QPair<QString, int>("", 0);
+    }
+    return QPair<QString, int>(match.captured(1).replace("\\", "/"), match.captured(2).toInt());
+}
+
+bool NMLCompiler::isFilteredWarning(const QString &message){
+    const QString filterWarnings = QSettings("OpenTTD", "NMLCreator").value("compiler/filterWarnings", "").toString();
+    return messageType(message) == Warning && !filterWarnings.isEmpty() && message.contains(QRegularExpression(filterWarnings));
+}
+
+void NMLCompiler::cancel(){
+    if(this->_result != NotFinished || this->_process.state() != QProcess::NotRunning){
+        return;
+    }
+    this->_result = Cancelled;
+    emit this->finished(this);
+}
+
+void NMLCompiler::start(){
+    this->_result = NotFinished;
+    this->_output.clear();
+    this->_messages.clear();
+    this->_statistics.date = QDateTime::currentDateTime();
+    this->_cacheEntries = SpriteCache::isEnabled() ? SpriteCache::entries(SpriteCache::directory(this->_nmlFile, this->_configuration)) : QSet<QString>();
+    this->_timer.start();
+    this->_process.start(compilerPath(), this->arguments());
+}
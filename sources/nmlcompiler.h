@@ -0,0 +1,76 @@
+#ifndef NMLCOMPILER_H
+#define NMLCOMPILER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include "buildconfiguration.h"
+#include "buildstatistics.h"
+#include "processsampler.h"
+#include "spritecache.h"
+
+#ifdef _WIN32
+    #define NMLCOMPILER (qApp->applicationDirPath() + "/nmlc.exe")    //On Windows, run the nmlc.exe file in the same folder as the NMLCreator executable
+#else
+    #define NMLCOMPILER "nmlc"    //On Linux, run the nmlc command that the user is supposed to install from the command line
+#endif
+
+class NMLCompiler : public QObject{
+    Q_OBJECT
+
+public:
+    enum Result{NotFinished, Success, Failed, CompilerNotFound, Cancelled};    //Cancelled means that the compiler was never started, for example because the same build was requested again
+    enum MessageType{Information, Warning, Error};
+
+    struct Message{
+        QString text;
+        MessageType type;
+        QString file;    //Exactly as written by the compiler, empty if the message doesn't refer to a file
+        int line;    //0 if the message doesn't refer to a line
+    };
+
+    NMLCompiler(const QString &nmlFile, const BuildConfiguration &configuration, QObject *parent = nullptr);
+
+    const QString &nmlFile() const;
+    const QString &inputFile() const;
+    void setInputFile(const QString &inputFile);    //The file actually passed to the compiler, by default the .nml file itself, for example the expanded file of a .pnml project
+    const QString &sourceDirectory() const;
+    void setSourceDirectory(const QString &sourceDirectory);    //The folder the compiler runs in, by default the project folder, for example a CompileOverlay with the unsaved changes of the project
+    const BuildConfiguration &configuration() const;
+    QStringList arguments() const;
+
+    Result result() const;
+    QStringList output() const;    //The messages printed by the compiler, one message per line
+    QList<Message> messages() const;    //The same messages as output(), with their type, file and line number
+    qint64 duration() const;    //In milliseconds
+    BuildStatistics statistics() const;    //Only the values measured by the compiler itself are filled in
+
+    static QString compilerPath();
+    static MessageType messageType(const QString &message);
+    static QPair<QString, int> fileAndLineNumber(const QString &message);    //Returns the file and the line number exactly as they are written in the message, or an empty string and 0 if the message doesn't refer to a line
+    static bool isFilteredWarning(const QString &message);
+
+public slots:
+    void start();
+    void cancel();    //Only does something if the compiler hasn't been started yet
+
+signals:
+    void finished(NMLCompiler *compiler);
+
+private:
+    const QString _nmlFile;
+    QString _inputFile;
+    QString _sourceDirectory;
+    const BuildConfiguration _configuration;
+    QProcess _process;
+    ProcessSampler _sampler;
+    QElapsedTimer _timer;
+    Result _result;
+    QStringList _output;
+    QList<Message> _messages;
+    qint64 _duration;
+    BuildStatistics _statistics;
+    QSet<QString> _cacheEntries;    //The sprites that were in the cache before compiling
+};
+
+#endif // NMLCOMPILER_H
@@ -1,12 +1,7 @@
+#include <QtConcurrent>
 #include "nmlproject.h"
 #include "version.h"
 
-#ifdef _WIN32
-    #define NMLCOMPILER (qApp->applicationDirPath() + "/nmlc.exe")    //On Windows, run the nmlc.exe file in the same folder as the NMLCreator executable
-#else
-    #define NMLCOMPILER "nmlc"    //On Linux, run the nmlc command that the user is supposed to install from the command line
-#endif
-
 const QMap<QString, int> NMLProject::_languageCodes = QMap<QString, int>({
     {QObject::tr("Afrikaans"), 0x1b},
     {QObject::tr("Arabic"), 0x14},
@@ -71,6 +66,17 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
     _projectDir(QFileInfo(nmlFile).dir()),
     _langDir(_projectDir.path() + "/lang"),
     _gfxDir(_projectDir.path() + "/gfx"),
+    _preprocessor(nmlFile),
+    _tableGenerator(nmlFile),
+    _thumbnails(nmlFile),
+    _savingSprites(false),
+    _saveTime(-1),
+    _compileOverlay(nullptr),
+    _benchmark(new Benchmark(nmlFile, this)),
+    _benchmarkItem(nullptr),
+    _compilerBenchmark(new CompilerBenchmark(nmlFile, this)),
+    _compilerBenchmarkItem(nullptr),
+    _compileButton(new QAction(QIcon(":/icons/hammer.svg"), QObject::tr("&Compile"))),
     _undoButton(new QAction(QIcon(":/icons/undo.svg"), QObject::tr("&Undo"))),
     _redoButton(new QAction(QIcon(":/icons/redo.svg"), QObject::tr("&Redo"))),
     _cutButton(new QAction(QIcon(":/icons/cut.svg"), QObject::tr("Cu&t"))),
@@ -99,33 +105,112 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
     spritesItem->setIcon(QFileIconProvider().icon(QFileIconProvider::Folder));
     this->_fileListModel.appendRow(spritesItem);
 
+    QObject::connect(&this->_spriteLoader, &SpriteLoader::loaded, this, &NMLProject::spriteLoaded);
+    QObject::connect(&this->_spriteLoader, &SpriteLoader::progress, this, &NMLProject::showSpriteLoadingProgress);
+    QObject::connect(&this->_thumbnails, &ThumbnailCache::thumbnailReady, [this](const QString &fileName, const QImage &thumbnail){
+        const int index = this->_spriteFiles.indexOf(fileName);
+        if(index >= 0){
+            this->_fileListModel.item(2)->child(index)->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
+        }
+    });
+
     this->reloadLanguageList();
     this->reloadSpriteList();
+    this->reloadIncludeList();
+
+    //Update the list of included files shortly after the user stops typing, only the files that changed are expanded again
+    this->_includeListTimer.setSingleShot(true);
+    this->_includeListTimer.setInterval(500);
+    QObject::connect(&this->_includeListTimer, &QTimer::timeout, this, &NMLProject::reloadIncludeList);
+
+    //Analyze the cost of the callbacks in the background when the user stops typing, only the switches and items that changed are parsed again
+    this->_costAnalysisTimer.setSingleShot(true);
+    this->_costAnalysisTimer.setInterval(500);
+    QObject::connect(&this->_costAnalysisTimer, &QTimer::timeout, this, &NMLProject::analyzeCost);
+    QObject::connect(&this->_costAnalyzer, &CostAnalyzer::finished, this, &NMLProject::showHotSpots);
+    this->analyzeCost();
 
     QObject::connect(&this->_textEditors, &TextEditorList::changesInTextEditor, [this](TextEditor *editor){
         if(editor == this->centralWidget()){
             this->setWindowTitle("*" + QFileInfo(this->_activeFile).fileName() + " @ " + QFileInfo(this->_nmlFile).fileName() + " - NMLCreator");
         }
+        if(Preprocessor::isPreprocessed(this->_nmlFile)){
+            this->_includeListTimer.start();
+        }
+        if(QFileInfo(this->_textEditors.fileNameFromTextEditor(editor)).suffix() != "lng"){
+            this->_costAnalysisTimer.start();
+        }
     });
 
     //Create the logging area
-    QListView *logView = new QListView;
+    QTreeView *logView = new QTreeView;
     logView->setModel(&this->_logModel);
+    logView->header()->hide();
     logView->setEditTriggers(QTreeView::NoEditTriggers);
     this->_logDockWidget.setWidget(logView);
     this->_logDockWidget.setWindowTitle(QObject::tr("Errors and Warnings"));
     this->addDockWidget(Qt::BottomDockWidgetArea, &this->_logDockWidget);
+    this->statusBar()->addPermanentWidget(&this->_buildQueueLabel);
+
+    QObject::connect(&this->_logModel, &QStandardItemModel::rowsInserted, logView, [logView](const QModelIndex &parent){
+        if(parent.isValid()){
+            logView->expand(parent);    //Show the messages of each build configuration as soon as they are added
+        }
+    });
 
-    QObject::connect(logView, &QListView::clicked, [this](const QModelIndex &index){
+    //Create the build statistics panel
+    QWidget *statisticsWidget = new QWidget;
+    QVBoxLayout *statisticsLayout = new QVBoxLayout;
+    statisticsLayout->setContentsMargins(0, 0, 0, 0);
+    QToolBar *statisticsToolBar = new QToolBar;
+    QAction *exportCsv = statisticsToolBar->addAction(QObject::tr("Export as &CSV..."));
+    QAction *exportJson = statisticsToolBar->addAction(QObject::tr("Export as &JSON..."));
+    QAction *clearStatistics = statisticsToolBar->addAction(QObject::tr("C&lear history"));
+    statisticsLayout->addWidget(statisticsToolBar);
+    QTableView *statisticsView = new QTableView;
+    statisticsView->setModel(&this->_statisticsModel);
+    statisticsView->setEditTriggers(QTableView::NoEditTriggers);
+    statisticsView->verticalHeader()->hide();
+    statisticsView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    statisticsLayout->addWidget(statisticsView);
+    statisticsWidget->setLayout(statisticsLayout);
+    this->_statisticsModel.setHorizontalHeaderLabels(BuildStatistics::columnNames());
+    for(const BuildStatistics &statistics: BuildStatistics::loadHistory(this->_nmlFile)){
+        this->addBuildStatistics(statistics);
+    }
+    this->_statisticsDockWidget.setWidget(statisticsWidget);
+    this->_statisticsDockWidget.setWindowTitle(QObject::tr("Build statistics"));
+    this->addDockWidget(Qt::BottomDockWidgetArea, &this->_statisticsDockWidget);
+    this->tabifyDockWidget(&this->_logDockWidget, &this->_statisticsDockWidget);
+    this->_logDockWidget.raise();
+
+    QObject::connect(exportCsv, &QAction::triggered, [this](){
+        const QString fileName = QFileDialog::getSaveFileName(this, QObject::tr("Export Build Statistics"), "", QObject::tr("CSV files") + " (*.csv)");
+        if(!fileName.isEmpty() && !BuildStatistics::exportCsv(fileName, this->_buildStatistics)){
+            QMessageBox::critical(this, "", QObject::tr("You do not have permission to create the file %1.").arg(fileName));
+        }
+    });
+    QObject::connect(exportJson, &QAction::triggered, [this](){
+        const QString fileName = QFileDialog::getSaveFileName(this, QObject::tr("Export Build Statistics"), "", QObject::tr("JSON files") + " (*.json)");
+        if(!fileName.isEmpty() && !BuildStatistics::exportJson(fileName, this->_buildStatistics)){
+            QMessageBox::critical(this, "", QObject::tr("You do not have permission to create the file %1.").arg(fileName));
+        }
+    });
+    QObject::connect(clearStatistics, &QAction::triggered, [this](){
+        this->_buildStatistics.clear();
+        this->_statisticsModel.removeRows(0, this->_statisticsModel.rowCount());
+        BuildStatistics::saveHistory(this->_nmlFile, this->_buildStatistics);
+    });
+
+    QObject::connect(logView, &QTreeView::clicked, [this](const QModelIndex &index){
         const QPair<QString, int> fileAndLineNumber = this->fileAndLineNumber(this->_logModel.itemFromIndex(index)->text());
         const QString file = fileAndLineNumber.first;
-        TextEditor *editor = this->_textEditors.textEditorFromFileName(file);
         const int lineNumber = fileAndLineNumber.second;
-        if(file.isEmpty() || lineNumber == 0){
+        if(file.isEmpty() || lineNumber == 0 || !this->setActiveFile(file)){
             return;
         }
 
-        this->setActiveFile(file);
+        TextEditor *editor = this->_textEditors.textEditorFromFileName(file);    //Included files only get a text editor when they are opened for the first time
         editor->setTextCursor(QTextCursor(editor->document()->findBlockByLineNumber(lineNumber - 1)));
     });
 
@@ -221,11 +306,50 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
                     this->addSprite(":/sprites/emptysprite.png", "sprites");
                 });
 
-                QAction *importSprite = contextMenu->addAction(QObject::tr("&Import sprite..."));
+                QAction *importSprite = contextMenu->addAction(QObject::tr("&Import sprites..."));
                 QObject::connect(importSprite, &QAction::triggered, [this](){
-                    const QString &fileName = QFileDialog::getOpenFileName(this, QObject::tr("Import Sprite"), "", QObject::tr("All supported image files") + " (*.png;*.bmp;*.gif;*.jpg;*.jpeg;*.pbm;*.pgm;*.ppm;*.xbm;*.xpm);;" + QObject::tr("PNG files") + " (*.png)");
-                    if(!fileName.isEmpty()){
-                        this->addSprite(fileName, QFileInfo(fileName).baseName());
+                    const QStringList fileNames = QFileDialog::getOpenFileNames(this, QObject::tr("Import Sprites"), "", QObject::tr("All supported image files") + " (*.png;*.bmp;*.gif;*.jpg;*.jpeg;*.pbm;*.pgm;*.ppm;*.xbm;*.xpm);;" + QObject::tr("PNG files") + " (*.png)");
+                    if(fileNames.length() == 1){
+                        this->addSprite(fileNames.first(), QFileInfo(fileNames.first()).baseName());
+                    }
+                    else{
+                        //Several files are decoded and converted in the background, they are added when they are ready
+                        for(const QString &fileName: fileNames){
+                            this->_spriteImports.insert(fileName, QFileInfo(fileName).baseName());
+                            this->_spriteLoader.load(fileName);
+                        }
+                    }
+                });
+
+                QAction *reloadSprites = contextMenu->addAction(QObject::tr("Reload all &open sprites"));
+                QObject::connect(reloadSprites, &QAction::triggered, [this](){
+                    QStringList openSprites, unsavedSprites;
+                    for(auto i = this->_spriteEditors.constBegin(); i != this->_spriteEditors.constEnd(); i++){
+                        if(i.value() != nullptr){
+                            openSprites.append(i.key());
+                            if(i.value()->hasUnsavedChanges()){
+                                unsavedSprites.append(QFileInfo(i.key()).fileName());
+                            }
+                        }
+                    }
+                    if(!unsavedSprites.isEmpty() && QMessageBox::warning(this, "", QObject::tr("The following files have unsaved changes:") + "\n\n" + unsavedSprites.join("\n") + "\n\n" + QObject::tr("Do you really want to reload them?"), QMessageBox::Yes | QMessageBox::No) == QMessageBox::No){
+                        return;
+                    }
+
+                    //The sprites that were never opened don't need to be reloaded, they are read from their files when they are opened
+                    for(const QString &spriteFile: qAsConst(openSprites)){
+                        this->_spriteLoader.load(spriteFile, spriteFile == this->_activeFile);
+                        this->setSpriteItemLoading(spriteFile, true);
+                    }
+                });
+
+                QAction *cancelLoading = contextMenu->addAction(QObject::tr("&Cancel loading sprites"));
+                cancelLoading->setEnabled(!this->_spriteLoader.isIdle());
+                QObject::connect(cancelLoading, &QAction::triggered, [this](){
+                    this->_spriteLoader.cancel();
+                    this->_spriteImports.clear();
+                    for(const QString &spriteFile: qAsConst(this->_spriteFiles)){
+                        this->setSpriteItemLoading(spriteFile, false);
                     }
                 });
             }
@@ -253,9 +377,10 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
                         this->removeSprite(QFileInfo(file).fileName());
                         return;
                     }
-                    this->_spriteEditors[file] = new SpriteEditor(file);
-                    if(this->_activeFile == file){
-                        this->setActiveFile(file);
+                    this->_spriteEditors[file] = nullptr;    //The file is loaded again when it's opened
+                    this->_fileListModel.item(2)->child(this->_spriteFiles.indexOf(file))->setIcon(this->spriteIcon(file));
+                    if(this->_activeFile == file && !this->setActiveFile(file)){
+                        this->setActiveFile(this->_nmlFile);
                     }
                     if(oldEditor != nullptr){
                         delete oldEditor;
@@ -295,7 +420,7 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
                     fileListView->edit(index);
                 });
             }
-            if(type != "nml"){
+            if(type == "lng" || type == "png"){
                 QAction *remove = contextMenu->addAction(QObject::tr("&Delete"));
                 QObject::connect(remove, &QAction::triggered, [this, file, type](){
                     if(QMessageBox::warning(this, "", QObject::tr("Do you really want to delete the file %1? This can not be undone.").arg(file), QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes){
@@ -332,8 +457,14 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
     save->setShortcut(QKeySequence("CTRL+S"));
     QAction *saveAll = fileMenu->addAction(QObject::tr("Save &all"));
     saveAll->setShortcut(QKeySequence("CTRL+Shift+S"));
-    QAction *compileButton = fileMenu->addAction(QIcon(":/icons/hammer.svg"), QObject::tr("&Compile"));
-    compileButton->setShortcut(QKeySequence("F5"));
+    fileMenu->addAction(this->_compileButton);
+    this->_compileButton->setShortcut(QKeySequence("F5"));
+    QAction *buildConfigurations = fileMenu->addAction(QObject::tr("&Build configurations..."));
+    QAction *spriteCache = fileMenu->addAction(QObject::tr("Sprite &cache..."));
+    QAction *cost = fileMenu->addAction(QObject::tr("&Runtime cost of callbacks..."));
+    QAction *package = fileMenu->addAction(QObject::tr("Create BaNaNaS &package"));
+    QAction *benchmark = fileMenu->addAction(QObject::tr("Run &benchmark in OpenTTD..."));
+    QAction *compilerBenchmark = fileMenu->addAction(QObject::tr("Compare co&mpilers..."));
     fileMenu->addSeparator();
     QAction *settings = fileMenu->addAction(QIcon(":/icons/settings.svg"), QObject::tr("S&ettings"));
     fileMenu->addSeparator();
@@ -350,107 +481,27 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
         this->saveFile(this->_activeFile);
     });
     QObject::connect(saveAll, &QAction::triggered, this, &NMLProject::saveAll);
-    auto *connections = new QMap<TextEditor*, QMetaObject::Connection>;    //Contains connections between the TextChanged signal of text editors and a lambda to remove warnings and errors in that editor
-    QObject::connect(compileButton, &QAction::triggered, [this, compileButton, connections](){
-        if(!this->saveAll()){
-            return;
+    QObject::connect(this->_compileButton, &QAction::triggered, this, &NMLProject::compile);
+    QObject::connect(buildConfigurations, &QAction::triggered, this, &NMLProject::showBuildConfigurationsWindow);
+    QObject::connect(spriteCache, &QAction::triggered, this, &NMLProject::showSpriteCacheWindow);
+    QObject::connect(cost, &QAction::triggered, this, &NMLProject::showCostWindow);
+    QObject::connect(package, &QAction::triggered, this, &NMLProject::createPackage);
+    QObject::connect(benchmark, &QAction::triggered, this, &NMLProject::showBenchmarkWindow);
+    QObject::connect(this->_benchmark, &Benchmark::finished, this, &NMLProject::showBenchmarkResult);
+    QObject::connect(compilerBenchmark, &QAction::triggered, this, &NMLProject::showCompilerBenchmarkWindow);
+    QObject::connect(this->_compilerBenchmark, &CompilerBenchmark::progress, [this](int done, int total){
+        if(this->logContains(this->_compilerBenchmarkItem)){
+            this->_compilerBenchmarkItem->setText(QObject::tr("Compiler benchmark: Compiling %1 of %2...").arg(qMin(done + 1, total)).arg(total));
         }
-
-        compileButton->setDisabled(true);
-        for(TextEditor *editor: this->_textEditors){
-            editor->removeAllErrors();
-            editor->removeAllWarnings();
-            if(connections->contains(editor)){
-                QObject::disconnect((*connections)[editor]);
-            }
-        }
-        connections->clear();
-        this->_logModel.removeRows(0, this->_logModel.rowCount());
-        this->_logModel.appendRow(new QStandardItem(QObject::tr("Compiling, please wait...")));
-
-        const QString destination = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/OpenTTD/newgrf/" + QFileInfo(this->_nmlFile).baseName() + ".grf";
-        QProcess *compiler = new QProcess;
-        compiler->setWorkingDirectory(this->_projectDir.path());
-        QObject::connect(compiler, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), [this, compileButton, compiler, connections](bool failed){
-            const QStringList output = QString::fromLatin1(compiler->readAllStandardError()).split("\n");
-            this->_logModel.removeRows(0, this->_logModel.rowCount());
-            if(failed){
-                this->_logModel.appendRow(new QStandardItem(QObject::tr("NewGRF was not compiled because of the following errors:")));
-            }
-            else{
-                this->_logModel.appendRow(new QStandardItem(QObject::tr("NewGRF was compiled successfully. To test it, run OpenTTD, go to NewGRF Settings, select your NewGRF in the list and click \"Add\".")));
-            }
-            for(const QString &message: output){
-                QStandardItem *modelItem = new QStandardItem(message);
-                QIcon icon;
-                const QPair<TextEditor*, int> editorAndLineNumber = this->editorAndLineNumber(message);
-                TextEditor *editor = editorAndLineNumber.first;
-                const int lineNumber = editorAndLineNumber.second;
-                const QString filterWarnings = QSettings("OpenTTD", "NMLCreator").value("compiler/filterWarnings", "").toString();
-
-                if(message.contains(QRegularExpression("^\\s*nmlc\\s*error", QRegularExpression::CaseInsensitiveOption))){
-                    icon = QIcon(":/icons/error.svg");
-                    if(editor != nullptr && lineNumber > 0){
-                        editor->addError(lineNumber);
-                    }
-                }
-                else if(message.contains(QRegularExpression("^\\s*nmlc\\s*warning", QRegularExpression::CaseInsensitiveOption))){
-                    if(!filterWarnings.isEmpty() && message.contains(QRegularExpression(filterWarnings))){
-                        continue;
-                    }
-                    icon = QIcon(":/icons/warning.svg");
-                    if(editor != nullptr && lineNumber > 0){
-                        editor->addWarning(lineNumber);
-                    }
-                }
-                if(editor != nullptr && !connections->contains(editor)){
-                    connections->insert(editor, QObject::connect(editor, &TextEditor::textChanged, [this, editor, modelItem, connections](){
-                        editor->removeAllErrors();
-                        editor->removeAllWarnings();
-                        this->_logModel.removeRow(this->_logModel.indexFromItem(modelItem).row());
-                        QObject::disconnect((*connections)[editor]);
-                        connections->remove(editor);
-                    }));
-                }
-
-                modelItem->setIcon(icon);
-                this->_logModel.appendRow(modelItem);
-            }
-
-            compileButton->setDisabled(false);
-            delete compiler;
-        });
-        QObject::connect(compiler, &QProcess::errorOccurred, [this, compileButton, compiler](){
-            const QString compilerPath = QSettings("OpenTTD", "NMLCreator").value("compiler/path", NMLCOMPILER).toString();
-            this->_logModel.removeRows(0, this->_logModel.rowCount());
-            this->_logModel.appendRow(new QStandardItem(QIcon(":/icons/error.svg"), QObject::tr("NewGRF was not compiled because the compiler was not found.")));
-            #ifdef _WIN32
-                QMessageBox::critical(this, "", QObject::tr("Could not find the file %1.").arg(compilerPath) + "\n\n" + QObject::tr("To fix this error, try resetting the NMLCreator settings. If this error persists, reinstalling NMLCreator."));
-            #else
-                if(compilerPath == "nmlc"){
-                    QMessageBox::critical(this, "", QObject::tr("Command nmlc not found. Please install NML by running the following command in the command line:") + "\n\npython3 -m pip install nml\n\n" + QObject::tr("If you receive an error doing so, try installing Python 3 and pip by running the following commands:") + "\n\nsudo apt install python3\nsudo apt install python3-pip");
-                }
-                else{
-                    QMessageBox::critical(this, "", QObject::tr("Command %1 not found. Please open the NMLCreator settings and specify a valid command under \"Compiler path\".").arg(compilerPath));
-                }
-            #endif
-
-            compileButton->setDisabled(false);
-            delete compiler;
-        });
-        QSettings settings("OpenTTD", "NMLCreator");
-        QStringList args = {"-c", "--grf", destination, this->_nmlFile, "--cache-dir=" + settings.value("compiler/cacheDir", ".nmlcache").toString()};
-        if(!settings.value("compiler/enableCache", true).toBool()){
-            args.append("--no-cache");
-        }
-        if(!settings.value("compiler/clearUnusedCache", false).toBool()){
-            args.append("--clear-orphaned");
-        }
-        if(!settings.value("compiler/enableWarnings", true).toBool()){
-            args.append("--quiet");
+    });
+    QObject::connect(this->_compilerBenchmark, &CompilerBenchmark::finished, this, &NMLProject::showCompilerBenchmarkResult);
+    QObject::connect(BuildPool::instance(), &BuildPool::allJobsFinished, this, &NMLProject::pruneSpriteCache);
+    QObject::connect(BuildPool::instance(), &BuildPool::jobStarted, this, [this](NMLCompiler *compiler){
+        if(this->_compilerLogItems.contains(compiler)){
+            this->_compilerLogItems[compiler]->setText(compiler->configuration().name + ": " + QObject::tr("Compiling, please wait..."));
         }
-        compiler->start(settings.value("compiler/path", NMLCOMPILER).toString(), args);
     });
+    QObject::connect(BuildPool::instance(), &BuildPool::queueChanged, this, &NMLProject::showBuildQueue);
     QObject::connect(settings, &QAction::triggered, this, &NMLProject::showSettingsWindow);
     QObject::connect(close, &QAction::triggered, [this](){
         emit this->aboutToClose(nullptr);
@@ -492,18 +543,17 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
     toggleLogsList->setChecked(true);
     QObject::connect(toggleLogsList, &QAction::triggered, &this->_logDockWidget, &QDockWidget::setVisible);
     QObject::connect(&this->_logDockWidget, &QDockWidget::visibilityChanged, toggleLogsList, &QAction::setChecked);
+    QAction *toggleStatistics = viewMenu->addAction(QObject::tr("&Build statistics"));
+    toggleStatistics->setCheckable(true);
+    toggleStatistics->setChecked(true);
+    QObject::connect(toggleStatistics, &QAction::triggered, &this->_statisticsDockWidget, &QDockWidget::setVisible);
+    QObject::connect(&this->_statisticsDockWidget, &QDockWidget::visibilityChanged, toggleStatistics, &QAction::setChecked);
     viewMenu->addSeparator();
     QAction *clearLogs = viewMenu->addAction(QObject::tr("&Clear errors and warnings"));
-    QObject::connect(clearLogs, &QAction::triggered, [this, connections](){
-        for(TextEditor *editor: this->_textEditors){
-            editor->removeAllErrors();
-            editor->removeAllWarnings();
-            if(connections->contains(editor)){
-                QObject::disconnect((*connections)[editor]);
-            }
+    QObject::connect(clearLogs, &QAction::triggered, [this](){
+        if(this->_compilerLogItems.isEmpty()){
+            this->clearDiagnostics();
         }
-        connections->clear();
-        this->_logModel.removeRows(0, this->_logModel.rowCount());
     });
 
     QMenu *helpMenu = menuBar->addMenu(QObject::tr("&Help"));
@@ -540,7 +590,7 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
     fileToolBar->addAction(newProject);
     fileToolBar->addAction(openProject);
     fileToolBar->addSeparator();
-    fileToolBar->addAction(compileButton);
+    fileToolBar->addAction(this->_compileButton);
     fileToolBar->addAction(settings);
 
     QAction *toggleFileToolBar = toolBarsList->addAction(QObject::tr("&File"));
@@ -644,13 +694,19 @@ NMLProject::NMLProject(const QString &nmlFile, const QString &fileToOpen):
         if(this->_textEditors.hasUnsavedChanges(this->_textEditors.textEditorFromFileName(this->_nmlFile))){
             unsavedFiles.append(QFileInfo(this->_nmlFile).fileName());
         }
+        for(const QString &includedFile: qAsConst(this->_includedFiles)){
+            if(this->_textEditors.hasUnsavedChanges(this->_textEditors.textEditorFromFileName(includedFile))){
+                unsavedFiles.append(this->_projectDir.relativeFilePath(includedFile));
+            }
+        }
         for(const QString &languageFile: qAsConst(this->_languageFiles)){
             if(this->_textEditors.hasUnsavedChanges(this->_textEditors.textEditorFromFileName(languageFile))){
                 unsavedFiles.append(QFileInfo(languageFile).fileName());
             }
         }
         for(const QString &spriteFile: qAsConst(this->_spriteFiles)){
-            if(this->_spriteEditors[spriteFile]->hasUnsavedChanges()){
+            const SpriteEditor *editor = this->_spriteEditors.value(spriteFile);
+            if(editor != nullptr && editor->hasUnsavedChanges()){
                 unsavedFiles.append(QFileInfo(spriteFile).fileName());
             }
         }
@@ -783,11 +839,11 @@ NMLProject *NMLProject::newNMLProject(QWidget *parent){
 }
 
 NMLProject *NMLProject::openNMLProject(QWidget *parent){
-    const QString fileName = QFileDialog::getOpenFileName(parent, "", "", QObject::tr("NML project files") + " (*.nml)");
+    const QString fileName = QFileDialog::getOpenFileName(parent, "", "", QObject::tr("NML project files") + " (*.nml *.pnml)");
     if(fileName.isEmpty()){
         return nullptr;
     }
-    else if(QFileInfo(fileName).suffix() != "nml"){
+    else if(QFileInfo(fileName).suffix() != "nml" && !Preprocessor::isPreprocessed(fileName)){
         QMessageBox::critical(parent, "", QObject::tr("The file %1 is not a valid NML file.").arg(fileName));
         return nullptr;
     }
@@ -853,8 +909,17 @@ bool NMLProject::removeLanguage(const QString &language){
 }
 
 void NMLProject::addSprite(const QString &fileName, const QString &destinationName){
-    if(QImage(fileName).isNull()){
-        QMessageBox::critical(this, "", QObject::tr("The file %1 is not a valid image file.").arg(fileName));
+    this->addSprite(fileName, SpriteLoader::decode(fileName), destinationName, true);
+}
+
+void NMLProject::addSprite(const QString &fileName, const SpriteLoader::Sprite &sprite, const QString &destinationName, bool open){
+    if(sprite.image.isNull()){
+        if(open){
+            QMessageBox::critical(this, "", QObject::tr("The file %1 is not a valid image file.").arg(fileName));
+        }
+        else{
+            this->_spriteLoadingErrors.append(QObject::tr("The file %1 is not a valid image file.").arg(fileName));
+        }
         return;
     }
     QString destination = this->_gfxDir.path() + "/" + destinationName + ".png";
@@ -862,9 +927,14 @@ void NMLProject::addSprite(const QString &fileName, const QString &destinationNa
         destination = this->_gfxDir.path() + "/" + destinationName + "-" + QString::number(i) + ".png";
     }
 
-    SpriteEditor *editor = new SpriteEditor(fileName);
+    SpriteEditor *editor = new SpriteEditor(sprite);
     if(!editor->save(destination)){
-        QMessageBox::critical(this, "", QObject::tr("You do not have permission to create the file %1.").arg(destination));
+        if(open){
+            QMessageBox::critical(this, "", QObject::tr("You do not have permission to create the file %1.").arg(destination));
+        }
+        else{
+            this->_spriteLoadingErrors.append(QObject::tr("You do not have permission to create the file %1.").arg(destination));
+        }
         delete editor;
         return;
     }
@@ -875,8 +945,62 @@ void NMLProject::addSprite(const QString &fileName, const QString &destinationNa
     QStandardItem *spriteItem = new QStandardItem(QFileInfo(destination).fileName());
     spriteItem->setIcon(QIcon(":/icons/png.svg"));
     this->_fileListModel.item(2)->appendRow(spriteItem);
+    this->_thumbnails.update(destination, editor->image());
+
+    if(open){
+        this->setActiveFile(destination);
+    }
+}
+
+void NMLProject::spriteLoaded(const QString &fileName, const SpriteLoader::Sprite &sprite){
+    if(this->_spriteImports.contains(fileName)){
+        this->addSprite(fileName, sprite, this->_spriteImports.take(fileName), false);
+        return;
+    }
+    if(!this->_spriteEditors.contains(fileName)){
+        return;    //The sprite was removed or renamed while it was loading
+    }
+    this->setSpriteItemLoading(fileName, false);
+    if(sprite.image.isNull()){
+        this->_spriteLoadingErrors.append(QObject::tr("The file %1 is not a valid image file.").arg(fileName));
+        return;
+    }
+
+    SpriteEditor *oldEditor = this->_spriteEditors[fileName];
+    this->_spriteEditors[fileName] = new SpriteEditor(sprite);
+    if(this->_activeFile == fileName){
+        this->setActiveFile(fileName);
+    }
+    delete oldEditor;
+    this->_fileListModel.item(2)->child(this->_spriteFiles.indexOf(fileName))->setIcon(this->spriteIcon(fileName));
+}
+
+void NMLProject::showSpriteLoadingProgress(int done, int total){
+    this->_fileListModel.item(2)->setText((total > 0) ? "gfx " + QObject::tr("(loading %1 of %2 sprites)").arg(done + 1).arg(total) : "gfx");
 
-    this->setActiveFile(destination);
+    //A message box for each file would open the next one while the previous one is still shown, so the errors are shown together once the loader is idle
+    if(total == 0 && !this->_spriteLoadingErrors.isEmpty()){
+        const QStringList errors = this->_spriteLoadingErrors;
+        this->_spriteLoadingErrors.clear();
+        QMessageBox::critical(this, "", errors.join("\n"));
+    }
+}
+
+QIcon NMLProject::spriteIcon(const QString &fileName){
+    const QImage thumbnail = this->_thumbnails.thumbnail(fileName);
+    return thumbnail.isNull() ? QIcon(":/icons/png.svg") : QIcon(QPixmap::fromImage(thumbnail));
+}
+
+void NMLProject::setSpriteItemLoading(const QString &fileName, bool loading){
+    //The sprites that are waiting to be loaded again are shown in italics
+    const int index = this->_spriteFiles.indexOf(fileName);
+    if(index < 0){
+        return;
+    }
+    QStandardItem *item = this->_fileListModel.item(2)->child(index);
+    QFont font = item->font();
+    font.setItalic(loading);
+    item->setFont(font);
 }
 
 bool NMLProject::renameSprite(const QString &oldName, const QString &newName){
@@ -896,6 +1020,7 @@ bool NMLProject::renameSprite(const QString &oldName, const QString &newName){
     this->_spriteEditors.insert(newPath, this->_spriteEditors[oldPath]);
     this->_spriteEditors.remove(oldPath);
     this->_fileListModel.item(2)->child(index)->setText(QFileInfo(newPath).fileName());
+    this->_fileListModel.item(2)->child(index)->setIcon(this->spriteIcon(newPath));    //The thumbnails are found by the path of the file, the icon is updated again if a new one has to be generated
 
     if(this->_activeFile == oldPath){
         this->setActiveFile(newPath);
@@ -924,14 +1049,15 @@ bool NMLProject::removeSprite(const QString &fileName){
 
 bool NMLProject::saveFile(const QString &fileName){
     if(QFileInfo(fileName).suffix() == "png"){
-        SpriteEditor *editor = this->_spriteEditors[fileName];
-        if(editor == nullptr){
-            return true;
+        SpriteEditor *editor = this->_spriteEditors.value(fileName);
+        if(editor == nullptr || editor->matchesFile()){
+            return true;    //The file doesn't need to be encoded again
         }
 
         if(!editor->save(fileName)){
             return false;
         }
+        this->_thumbnails.update(fileName, editor->image());
     }
     else{
         TextEditor *editor = this->_textEditors.textEditorFromFileName(fileName);
@@ -939,13 +1065,12 @@ bool NMLProject::saveFile(const QString &fileName){
             return true;
         }
 
-        QFile file(fileName);
-        if(!file.open(QFile::WriteOnly | QFile::Truncate)){
+        //The file is replaced rather than rewritten, so that a compiler reading it through a hard link of a CompileOverlay still sees the whole previous version
+        QSaveFile file(fileName);
+        if(!file.open(QFile::WriteOnly) || file.write(fileContents(editor)) < 0 || !file.commit()){
             QMessageBox::critical(this, "", QObject::tr("An error occurred when saving the file %1. The file might be used by another program or you might not have sufficient permissions to edit this file.").arg(fileName));
             return false;
         }
-        file.write(editor->toPlainText().replace(QRegularExpression("[^\\S\r\n]*([\r\n]|$)"), "\n").replace(QRegularExpression("[\r\n]*$"), "").toUtf8());
-        file.close();
 
         this->_textEditors.markAsSaved(editor);
     }
@@ -961,19 +1086,428 @@ bool NMLProject::saveAll(){
     if(!this->saveFile(this->_nmlFile)){
         return false;
     }
-    for(const QString &fileName: qAsConst(this->_languageFiles)){
+    for(const QString &fileName: qAsConst(this->_includedFiles)){
         if(!this->saveFile(fileName)){
             return false;
         }
     }
-    for(const QString &fileName: qAsConst(this->_spriteFiles)){
+    for(const QString &fileName: qAsConst(this->_languageFiles)){
         if(!this->saveFile(fileName)){
             return false;
         }
     }
+    return this->saveSprites();
+}
+
+bool NMLProject::saveSprites(){
+    if(this->_savingSprites){
+        return false;
+    }
+
+    //The images are implicitly shared, so the copies taken here stay the same if an editor changes its image while the files are written
+    struct Job{
+        QString fileName;
+        QImage image;
+        quint64 revision;
+        QPointer<SpriteEditor> editor;
+        bool success;
+    };
+    QVector<Job> jobs;
+    for(const QString &fileName: qAsConst(this->_spriteFiles)){
+        SpriteEditor *editor = this->_spriteEditors.value(fileName);
+        if(editor != nullptr && !editor->matchesFile()){
+            jobs.append({fileName, editor->image(), editor->revision(), editor, false});
+        }
+    }
+    if(jobs.isEmpty()){
+        return true;
+    }
+
+    //Encoding a large PNG takes a while, so the files are encoded on the global thread pool while a local event loop keeps the window painted
+    this->_savingSprites = true;
+    this->statusBar()->showMessage(QObject::tr("Saving %n sprite(s)...", "", jobs.length()));
+    const int compressionLevel = SpritePalette::compressionLevel();
+    QEventLoop eventLoop;
+    QFutureWatcher<void> watcher;
+    QObject::connect(&watcher, &QFutureWatcher<void>::finished, &eventLoop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::map(jobs, [compressionLevel](Job &job){
+        job.success = SpritePalette::save(job.image, job.fileName, compressionLevel);
+    }));
+    eventLoop.exec(QEventLoop::ExcludeUserInputEvents);
+    this->statusBar()->clearMessage();
+    this->_savingSprites = false;
+
+    QStringList failedFiles;
+    for(const Job &job: qAsConst(jobs)){
+        if(!job.success){
+            failedFiles.append(job.fileName);
+            continue;
+        }
+        //The sprite could have been reloaded from the file while it was saved
+        if(!job.editor.isNull() && this->_spriteEditors.value(job.fileName) == job.editor){
+            job.editor->markAsSaved(job.revision);
+        }
+        this->_thumbnails.update(job.fileName, job.image);
+    }
+    SpriteEditor *activeEditor = this->_spriteEditors.value(this->_activeFile);
+    if(activeEditor != nullptr && !activeEditor->hasUnsavedChanges()){
+        this->setWindowTitle(QFileInfo(this->_activeFile).fileName() + " @ " + QFileInfo(this->_nmlFile).fileName() + " - NMLCreator");
+    }
+
+    if(!failedFiles.isEmpty()){
+        QMessageBox::critical(this, "", QObject::tr("An error occurred when saving the following files. The files might be used by another program or you might not have sufficient permissions to edit them.") + "\n\n" + failedFiles.join("\n"));
+        return false;
+    }
     return true;
 }
 
+void NMLProject::compile(){
+    if(!this->_compilerLogItems.isEmpty()){
+        return;    //This project is already being compiled
+    }
+    QList<BuildConfiguration> configurations;
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(this->_nmlFile)){
+        if(configuration.enabled){
+            configurations.append(configuration);
+        }
+    }
+    if(configurations.isEmpty()){
+        QMessageBox::critical(this, "", QObject::tr("All the build configurations of this project are disabled. Please enable at least one of them under File > Build configurations."));
+        return;
+    }
+
+    this->clearDiagnostics();
+
+    //The code generated from the tables must be up to date before the project folder is copied and preprocessed
+    QElapsedTimer generateTimer;
+    generateTimer.start();
+    if(!this->_tableGenerator.generate()){
+        this->showBuildErrors(this->_tableGenerator.errors());
+        return;
+    }
+    if(!this->_tableGenerator.writtenFiles().isEmpty()){
+        this->_logModel.appendRow(new QStandardItem(QObject::tr("Tables: %1 of %n row(s) generated again in %2 ms", "", this->_tableGenerator.rows()).arg(this->_tableGenerator.renderedRows()).arg(generateTimer.elapsed())));
+    }
+
+    //Instead of saving the project, the files with unsaved changes are written to a temporary copy of the project folder, which is compiled instead
+    QElapsedTimer saveTimer;
+    saveTimer.start();
+    const QMap<QString, QString> unsavedContents = this->unsavedContents();
+    QStringList unsavedSprites;
+    for(auto i = this->_spriteEditors.constBegin(); i != this->_spriteEditors.constEnd(); i++){
+        //The sprites that were never opened are only converted if their file doesn't use the OpenTTD palette, which can be checked without decoding them
+        if((i.value() != nullptr) ? !i.value()->matchesFile() : !SpritePalette::fileIsPalettized(i.key())){
+            unsavedSprites.append(i.key());
+        }
+    }
+    if(!unsavedContents.isEmpty() || !unsavedSprites.isEmpty()){
+        this->_compileOverlay = new CompileOverlay(this->_nmlFile, this);
+        for(auto i = unsavedContents.constBegin(); i != unsavedContents.constEnd(); i++){
+            this->_compileOverlay->setFile(i.key(), fileContents(this->_textEditors.textEditorFromFileName(i.key())));
+        }
+        for(const QString &spriteFile: qAsConst(unsavedSprites)){
+            const SpriteEditor *editor = this->_spriteEditors.value(spriteFile);
+            this->_compileOverlay->setImage(spriteFile, (editor != nullptr) ? editor->image() : SpritePalette::convert(QImage(spriteFile)));
+        }
+        if(!this->_compileOverlay->create()){
+            QMessageBox::critical(this, "", this->_compileOverlay->errorString());
+            delete this->_compileOverlay;
+            this->_compileOverlay = nullptr;
+            return;
+        }
+    }
+    this->_saveTime = saveTimer.elapsed();
+    const auto sourceFile = [this](const QString &fileName){
+        return (this->_compileOverlay != nullptr) ? this->_compileOverlay->filePath(fileName) : fileName;
+    };
+
+    //The compiler doesn't understand the #include and #define directives of .pnml files, so it compiles the expanded file instead
+    if(Preprocessor::isPreprocessed(this->_nmlFile)){
+        this->_preprocessor.setUnsavedContents(unsavedContents);
+        const bool preprocessed = this->_preprocessor.preprocessToFile(sourceFile(Preprocessor::outputFile(this->_nmlFile)));
+        this->showIncludedFiles();
+        if(!preprocessed){
+            this->showBuildErrors(this->_preprocessor.errors());
+            delete this->_compileOverlay;
+            this->_compileOverlay = nullptr;
+            return;
+        }
+    }
+
+    this->_compileButton->setDisabled(true);
+    this->_buildTimer.start();
+
+    QList<NMLCompiler*> compilers;
+    for(const BuildConfiguration &configuration: qAsConst(configurations)){
+        NMLCompiler *compiler = new NMLCompiler(this->_nmlFile, configuration, this);
+        compiler->setInputFile(sourceFile(Preprocessor::isPreprocessed(this->_nmlFile) ? Preprocessor::outputFile(this->_nmlFile) : this->_nmlFile));
+        if(this->_compileOverlay != nullptr){
+            compiler->setSourceDirectory(this->_compileOverlay->path());
+        }
+        QStandardItem *configurationItem = new QStandardItem(configuration.name + ": " + QObject::tr("Waiting for other compilers to finish..."));
+        this->_logModel.appendRow(configurationItem);
+        this->_compilerLogItems.insert(compiler, configurationItem);
+        compilers.append(compiler);
+    }
+    for(NMLCompiler *compiler: qAsConst(compilers)){
+        QObject::connect(compiler, &NMLCompiler::finished, this, [this](NMLCompiler *compiler){
+            this->showCompilerOutput(compiler);
+            for(NMLCompiler *otherCompiler: this->_compilerLogItems.keys()){
+                if(otherCompiler->result() == NMLCompiler::NotFinished){
+                    return;
+                }
+            }
+            this->finishBuild();
+        });
+    }
+    for(NMLCompiler *compiler: qAsConst(compilers)){
+        BuildPool::instance()->enqueue(compiler, this->isActiveWindow() ? BuildPool::Foreground : BuildPool::Background);
+    }
+}
+
+void NMLProject::showCompilerOutput(NMLCompiler *compiler){
+    QElapsedTimer populateTimer;
+    populateTimer.start();
+    QStandardItem *configurationItem = this->_compilerLogItems[compiler];
+    const BuildConfiguration &configuration = compiler->configuration();
+    if(compiler->result() == NMLCompiler::CompilerNotFound){
+        configurationItem->setIcon(QIcon(":/icons/error.svg"));
+        configurationItem->setText(configuration.name + ": " + QObject::tr("NewGRF was not compiled because the compiler was not found."));
+        return;
+    }
+    else if(compiler->result() == NMLCompiler::Cancelled){
+        configurationItem->setText(configuration.name + ": " + QObject::tr("Skipped because this build configuration was compiled again from another window."));
+        return;
+    }
+    else if(compiler->result() == NMLCompiler::Failed){
+        configurationItem->setText(configuration.name + ": " + QObject::tr("NewGRF was not compiled because of the following errors:"));
+    }
+    else if(configuration.outputType == "grf"){
+        configurationItem->setText(configuration.name + ": " + QObject::tr("NewGRF was compiled successfully. To test it, run OpenTTD, go to NewGRF Settings, select your NewGRF in the list and click \"Add\"."));
+    }
+    else{
+        configurationItem->setText(configuration.name + ": " + QObject::tr("The file %1 was written successfully.").arg(configuration.outputPath(this->_nmlFile)));
+    }
+
+    for(const NMLCompiler::Message &message: compiler->messages()){
+        if(NMLCompiler::isFilteredWarning(message.text)){
+            continue;
+        }
+
+        QStandardItem *modelItem = new QStandardItem(message.text);
+        TextEditor *editor = this->_textEditors.textEditorFromFileName(this->resolveFileName(message.file));
+        const int lineNumber = message.line;
+
+        switch(message.type){
+        case NMLCompiler::Error:
+            modelItem->setIcon(QIcon(":/icons/error.svg"));
+            if(editor != nullptr && lineNumber > 0){
+                editor->addError(lineNumber);
+            }
+            break;
+        case NMLCompiler::Warning:
+            modelItem->setIcon(QIcon(":/icons/warning.svg"));
+            if(editor != nullptr && lineNumber > 0){
+                editor->addWarning(lineNumber);
+            }
+            break;
+        default:
+            break;
+        }
+        if(editor != nullptr && !this->_diagnosticConnections.contains(editor)){
+            this->_diagnosticConnections.insert(editor, QObject::connect(editor, &TextEditor::textChanged, [this, editor, modelItem](){
+                editor->removeAllErrors();
+                editor->removeAllWarnings();
+                const QModelIndex index = this->_logModel.indexFromItem(modelItem);
+                this->_logModel.removeRow(index.row(), index.parent());
+                QObject::disconnect(this->_diagnosticConnections[editor]);
+                this->_diagnosticConnections.remove(editor);
+            }));
+        }
+
+        configurationItem->appendRow(modelItem);
+    }
+
+    BuildStatistics statistics = compiler->statistics();
+    if(statistics.cacheHitRatio() >= 0){
+        QStandardItem *cacheItem = new QStandardItem(QObject::tr("Sprite cache: %1 of %2 sprites were reused (%3%), the cache uses %4 MB.").arg(statistics.cacheHits).arg(statistics.cacheHits + statistics.cacheMisses).arg(qRound(statistics.cacheHitRatio() * 100)).arg(statistics.cacheSize / 1048576.0, 0, 'f', 1));
+        configurationItem->appendRow(cacheItem);
+    }
+    statistics.saveTime = this->_saveTime;
+    statistics.populateTime = populateTimer.elapsed();
+    this->addBuildStatistics(statistics);
+}
+
+void NMLProject::finishBuild(){
+    QList<NMLCompiler*> compilers = this->_compilerLogItems.keys();
+    int succeeded = 0;
+    bool compilerNotFound = false;
+    QStringList cacheDirs;
+    for(NMLCompiler *compiler: qAsConst(compilers)){
+        succeeded += (compiler->result() == NMLCompiler::Success);
+        compilerNotFound |= (compiler->result() == NMLCompiler::CompilerNotFound);
+        cacheDirs.append(SpriteCache::directory(this->_nmlFile, compiler->configuration()));
+        compiler->deleteLater();
+    }
+    this->_compilerLogItems.clear();
+    delete this->_compileOverlay;
+    this->_compileOverlay = nullptr;
+
+    //The caches are pruned once the compilers of the other windows are finished too, since they may be using caches in the same shared folder, see pruneSpriteCache()
+    for(const QString &cacheDir: qAsConst(cacheDirs)){
+        if(!this->_cachesToPrune.contains(cacheDir)){
+            this->_cachesToPrune.append(cacheDir);
+        }
+    }
+
+    BuildStatistics::saveHistory(this->_nmlFile, this->_buildStatistics);
+
+    if(compilers.length() > 1){
+        QStandardItem *summaryItem = new QStandardItem(QObject::tr("%1 of %2 build configurations were compiled successfully in %3 seconds.").arg(succeeded).arg(compilers.length()).arg(this->_buildTimer.elapsed() / 1000.0, 0, 'f', 1));
+        if(succeeded < compilers.length()){
+            summaryItem->setIcon(QIcon(":/icons/error.svg"));
+        }
+        this->_logModel.insertRow(0, summaryItem);
+    }
+    this->_compileButton->setDisabled(false);
+
+    //Let a running OpenTTD game load the NewGRF that was just compiled
+    if(succeeded == compilers.length() && QSettings("OpenTTD", "NMLCreator").value("openttd/reloadAfterCompiling", false).toBool()){
+        QStandardItem *reloadItem = new QStandardItem(QObject::tr("OpenTTD: Reloading NewGRFs..."));
+        this->_logModel.appendRow(reloadItem);
+        const QPersistentModelIndex reloadIndex = this->_logModel.indexFromItem(reloadItem);
+        AdminPortClient *client = new AdminPortClient(this);
+        QObject::connect(client, &AdminPortClient::finished, this, [this, client, reloadIndex](bool success, const QString &message){
+            //The log may have been cleared by another compilation in the meantime, which deletes the item and invalidates its index
+            if(reloadIndex.isValid()){
+                QStandardItem *reloadItem = this->_logModel.itemFromIndex(reloadIndex);
+                reloadItem->setText("OpenTTD: " + message);
+                if(!success){
+                    reloadItem->setIcon(QIcon(":/icons/error.svg"));
+                }
+                for(const QString &line: client->output()){
+                    reloadItem->appendRow(new QStandardItem(line));
+                }
+                if(!client->errors().isEmpty()){
+                    reloadItem->appendRow(new QStandardItem(QObject::tr("OpenTTD only runs reload_newgrfs in single-player games with the NewGRF developer tools enabled, while the admin port only exists in multiplayer games. Unmodified versions of OpenTTD therefore refuse the command.")));
+                }
+            }
+            client->deleteLater();
+        });
+        client->reloadNewGRFs();
+    }
+
+    if(compilerNotFound){
+        const QString compilerPath = NMLCompiler::compilerPath();
+        #ifdef _WIN32
+            QMessageBox::critical(this, "", QObject::tr("Could not find the file %1.").arg(compilerPath) + "\n\n" + QObject::tr("To fix this error, try resetting the NMLCreator settings. If this error persists, reinstalling NMLCreator."));
+        #else
+            if(compilerPath == "nmlc"){
+                QMessageBox::critical(this, "", QObject::tr("Command nmlc not found. Please install NML by running the following command in the command line:") + "\n\npython3 -m pip install nml\n\n" + QObject::tr("If you receive an error doing so, try installing Python 3 and pip by running the following commands:") + "\n\nsudo apt install python3\nsudo apt install python3-pip");
+            }
+            else{
+                QMessageBox::critical(this, "", QObject::tr("Command %1 not found. Please open the NMLCreator settings and specify a valid command under \"Compiler path\".").arg(compilerPath));
+            }
+        #endif
+    }
+}
+
+void NMLProject::pruneSpriteCache(){
+    //A compiler of another window could be reading or writing a cache that would be deleted or rewritten, so this waits until the build pool is idle
+    if(this->_cachesToPrune.isEmpty() || !BuildPool::instance()->isIdle()){
+        return;
+    }
+    if(SpriteCache::isEnabled()){
+        SpriteCache::prune(SpriteCache::budgetDirectory(this->_nmlFile), SpriteCache::budget(), this->_cachesToPrune);
+    }
+    this->_cachesToPrune.clear();
+}
+
+void NMLProject::showBuildQueue(){
+    const BuildPool *pool = BuildPool::instance();
+    if(pool->isIdle()){
+        this->_buildQueueLabel.clear();
+        return;
+    }
+
+    QString text = QObject::tr("Build queue: %1 running, %2 waiting").arg(pool->runningJobs()).arg(pool->waitingJobs());
+    int position = -1;
+    for(const NMLCompiler *compiler: this->_compilerLogItems.keys()){
+        const int compilerPosition = pool->position(compiler);
+        if(compilerPosition >= 0 && (position < 0 || compilerPosition < position)){
+            position = compilerPosition;
+        }
+    }
+    if(position >= 0){
+        text += " - " + QObject::tr("this project is next in line after %1 other compilations").arg(position);
+    }
+    this->_buildQueueLabel.setText(text);
+}
+
+void NMLProject::changeEvent(QEvent *event){
+    //The compilers of the window the user is working in are started before those of the other windows
+    if(event->type() == QEvent::ActivationChange){
+        BuildPool::instance()->setPriority(this, this->isActiveWindow() ? BuildPool::Foreground : BuildPool::Background);
+    }
+    MainWindow::changeEvent(event);
+}
+
+void NMLProject::addBuildStatistics(const BuildStatistics &statistics){
+    this->_buildStatistics.append(statistics);
+    QList<QStandardItem*> row;
+    for(const QString &value: statistics.toStringList()){
+        row.append(new QStandardItem(value));
+    }
+    if(!statistics.success){
+        row[2]->setIcon(QIcon(":/icons/error.svg"));
+    }
+    this->_statisticsModel.insertRow(0, row);    //Show the most recent build first
+
+    //Keep as many builds in memory as in the saved history, so that a long session doesn't grow without limit
+    const int excess = this->_buildStatistics.length() - BuildStatistics::maximumHistoryLength;
+    if(excess > 0){
+        this->_buildStatistics.erase(this->_buildStatistics.begin(), this->_buildStatistics.begin() + excess);
+        this->_statisticsModel.removeRows(this->_statisticsModel.rowCount() - excess, excess);
+    }
+}
+
+void NMLProject::clearDiagnostics(){
+    for(TextEditor *editor: this->_textEditors){
+        editor->removeAllErrors();
+        editor->removeAllWarnings();
+        if(this->_diagnosticConnections.contains(editor)){
+            QObject::disconnect(this->_diagnosticConnections[editor]);
+        }
+    }
+    this->_diagnosticConnections.clear();
+    this->_logModel.removeRows(0, this->_logModel.rowCount());
+}
+
+void NMLProject::showBuildErrors(const QList<Preprocessor::Error> &errors){
+    QStandardItem *errorsItem = new QStandardItem(QObject::tr("NewGRF was not compiled because of the following errors:"));
+    errorsItem->setIcon(QIcon(":/icons/error.svg"));
+    this->_logModel.appendRow(errorsItem);
+    for(const Preprocessor::Error &error: errors){
+        QStandardItem *errorItem = new QStandardItem(error.toString());
+        errorItem->setIcon(QIcon(":/icons/error.svg"));
+        errorsItem->appendRow(errorItem);
+        TextEditor *editor = this->_textEditors.textEditorFromFileName(this->resolveFileName(error.file));
+        if(editor != nullptr && error.line > 0){
+            editor->addError(error.line);
+        }
+    }
+}
+
+bool NMLProject::logContains(const QStandardItem *item) const{
+    //The item may already be deleted, so it is only compared with the items in the log
+    for(int row = 0; row < this->_logModel.rowCount(); row++){
+        if(this->_logModel.item(row) == item){
+            return true;
+        }
+    }
+    return false;
+}
+
 void NMLProject::reloadLanguageList(){
     for(const QString &file: qAsConst(this->_languageFiles)){
         if(!QFile(file).exists()){
@@ -1008,17 +1542,80 @@ void NMLProject::reloadSpriteList(){
         if(this->_spriteFiles.contains(filePath)){
             continue;    //This file is already loaded, no need to do anything
         }
-        if(QImage(filePath).isNull()){
+
+        //Only the header is read, the sprite is loaded when it's opened for the first time
+        QImageReader reader(filePath);
+        const QSize size = reader.size();
+        if(!reader.canRead() || !size.isValid()){
             QMessageBox::critical(nullptr, "", QObject::tr("The file %1 is not a valid image file.").arg(filePath));
             continue;
         }
         this->_spriteFiles.append(filePath);
-        this->_spriteEditors.insert(filePath, new SpriteEditor(filePath));
+        this->_spriteEditors.insert(filePath, nullptr);
 
         QStandardItem *spriteItem = new QStandardItem(spriteFile);
-        spriteItem->setIcon(QIcon(":/icons/png.svg"));
+        spriteItem->setIcon(this->spriteIcon(filePath));
+        spriteItem->setToolTip(QObject::tr("%1 × %2 pixels").arg(size.width()).arg(size.height()));
         this->_fileListModel.item(2)->appendRow(spriteItem);
     }
+    this->_thumbnails.removeUnused(this->_spriteFiles);
+}
+
+QMap<QString, QString> NMLProject::unsavedContents() const{
+    QMap<QString, QString> contents;
+    for(auto i = this->_textEditors.begin(); i != this->_textEditors.end(); i++){
+        if(i.value() != nullptr && this->_textEditors.hasUnsavedChanges(i.value())){
+            contents.insert(i.key(), i.value()->toPlainText());
+        }
+    }
+    return contents;
+}
+
+QByteArray NMLProject::fileContents(const TextEditor *editor){
+    //Remove the spaces at the end of the lines and the empty lines at the end of the file
+    return editor->toPlainText().replace(QRegularExpression("[^\\S\r\n]*([\r\n]|$)"), "\n").replace(QRegularExpression("[\r\n]*$"), "").toUtf8();
+}
+
+void NMLProject::reloadIncludeList(){
+    if(!Preprocessor::isPreprocessed(this->_nmlFile)){
+        return;
+    }
+
+    //Use the unsaved changes, so that the list is up to date while the user is typing
+    this->_preprocessor.setUnsavedContents(this->unsavedContents());
+    this->_preprocessor.preprocess();
+    this->showIncludedFiles();
+}
+
+void NMLProject::analyzeCost(){
+    this->_costAnalyzer.analyze(QStringList(this->_nmlFile) + this->_includedFiles, this->unsavedContents());
+}
+
+void NMLProject::showHotSpots(){
+    const CostAnalyzer::Result result = this->_costAnalyzer.result();
+    for(auto i = this->_textEditors.begin(); i != this->_textEditors.end(); i++){
+        if(i.value() != nullptr){
+            i.value()->setHotSpots(result.hotSpots.value(i.key()));
+        }
+    }
+}
+
+void NMLProject::showIncludedFiles(){
+    const QStringList includedFiles = this->_preprocessor.includedFiles();
+    if(includedFiles == this->_includedFiles){
+        return;
+    }
+    this->_costAnalysisTimer.start();    //The new list of files must be analyzed
+
+    //Included files that were removed from the list stay open if they have unsaved changes, they can still be saved with the main file
+    this->_includedFiles = includedFiles;
+    QStandardItem *nmlItem = this->_fileListModel.item(0);
+    nmlItem->removeRows(0, nmlItem->rowCount());
+    for(const QString &includedFile: includedFiles){
+        QStandardItem *includedItem = new QStandardItem(this->_projectDir.relativeFilePath(includedFile));
+        includedItem->setIcon(QIcon(":/icons/nml.svg"));
+        nmlItem->appendRow(includedItem);
+    }
 }
 
 void NMLProject::showSettingsWindow(){
@@ -1067,6 +1664,17 @@ void NMLProject::showSettingsWindow(){
     compilerPathBox.setLayout(&compilerPathLayout);
     compilerLayout.addWidget(&compilerPathBox);
 
+    QGroupBox buildQueueBox(QObject::tr("Build queue"));
+    QFormLayout buildQueueLayout;
+    QSpinBox maximumJobs;
+    maximumJobs.setRange(0, 256);
+    maximumJobs.setSpecialValueText(QObject::tr("One per processor core"));
+    maximumJobs.setValue(settings.value("compiler/maximumJobs", 0).toInt());
+    maximumJobs.setWhatsThis(QObject::tr("The maximum number of compilers that run at the same time. This limit is shared by all the open projects, the compilers of the project in the active window are started first."));
+    buildQueueLayout.addRow(QObject::tr("Parallel compilers"), &maximumJobs);
+    buildQueueBox.setLayout(&buildQueueLayout);
+    compilerLayout.addWidget(&buildQueueBox);
+
     QGroupBox cacheBox(QObject::tr("Cache"));
     QFormLayout cacheLayout;
     QCheckBox enableCache(QObject::tr("Enable caching of sprites"));
@@ -1082,6 +1690,34 @@ void NMLProject::showSettingsWindow(){
     clearUnusedCache.setChecked(settings.value("compiler/clearUnusedCache", false).toBool());
     clearUnusedCache.setWhatsThis(QObject::tr("Checking this box passes the --clear-orphaned flag to the compiler, which makes the compiler automatically remove unused items from cache files."));
     cacheLayout.addRow(&clearUnusedCache);
+    QSpinBox cacheBudget;
+    cacheBudget.setRange(0, 1024 * 1024);
+    cacheBudget.setSuffix(" MB");
+    cacheBudget.setSpecialValueText(QObject::tr("Unlimited"));
+    cacheBudget.setValue(settings.value("compiler/cacheBudget", 0).toInt());
+    cacheBudget.setWhatsThis(QObject::tr("After compiling, the cache files of the build configurations that were used least recently are deleted until the cache is smaller than this size, then the least recently used sprites of the build configurations that were just compiled. Set to 0 to never delete cache files."));
+    cacheBudget.setEnabled(enableCache.isChecked());
+    QObject::connect(&enableCache, &QCheckBox::clicked, &cacheBudget, &QSpinBox::setEnabled);
+    cacheLayout.addRow(QObject::tr("Maximum cache size"), &cacheBudget);
+    QWidget sharedCacheWidget;
+    QHBoxLayout sharedCacheLayout;
+    sharedCacheLayout.setContentsMargins(0, 0, 0, 0);
+    QLineEdit sharedCacheDir(settings.value("compiler/sharedCacheDir", "").toString());
+    sharedCacheDir.setWhatsThis(QObject::tr("If this is not empty, the cache files of all your projects are stored in this folder instead of in the location above, and the maximum cache size applies to all the projects together.") + "\n\n" + QObject::tr("Leave empty to store the cache files of each project separately."));
+    QPushButton browseForSharedCacheButton(QObject::tr("Browse..."));
+    browseForSharedCacheButton.setWhatsThis(QObject::tr("Opens a dialog where you can select the folder where the cache files of all your projects are stored."));
+    QObject::connect(&browseForSharedCacheButton, &QPushButton::pressed, [&](){
+        const QString folder = QFileDialog::getExistingDirectory(&settingsWindow, QObject::tr("Select Shared Cache Folder"), sharedCacheDir.text());
+        if(!folder.isEmpty()){
+            sharedCacheDir.setText(folder);
+        }
+    });
+    sharedCacheLayout.addWidget(&sharedCacheDir);
+    sharedCacheLayout.addWidget(&browseForSharedCacheButton);
+    sharedCacheWidget.setLayout(&sharedCacheLayout);
+    sharedCacheWidget.setEnabled(enableCache.isChecked());
+    QObject::connect(&enableCache, &QCheckBox::clicked, &sharedCacheWidget, &QWidget::setEnabled);
+    cacheLayout.addRow(QObject::tr("Shared cache folder"), &sharedCacheWidget);
     cacheBox.setLayout(&cacheLayout);
     compilerLayout.addWidget(&cacheBox);
 
@@ -1102,6 +1738,50 @@ void NMLProject::showSettingsWindow(){
     compilerTab.setLayout(&compilerLayout);
     tabs.addTab(&compilerTab, QObject::tr("Compiler"));
 
+    //OpenTTD tab
+    QWidget openttdTab;
+    QVBoxLayout openttdLayout;
+
+    QGroupBox openttdPathBox(QObject::tr("OpenTTD executable"));
+    QHBoxLayout openttdPathLayout;
+    QLineEdit openttdPath(settings.value("openttd/path", OPENTTD).toString());
+    openttdPath.setWhatsThis(QObject::tr("The OpenTTD executable that is used to run benchmarks."));
+    openttdPathLayout.addWidget(&openttdPath);
+    QPushButton openttdPathButton(QObject::tr("Browse..."));
+    QObject::connect(&openttdPathButton, &QPushButton::pressed, [&](){
+        const QString file = QFileDialog::getOpenFileName(&settingsWindow, QObject::tr("Select OpenTTD Executable"), openttdPath.text());
+        if(!file.isEmpty()){
+            openttdPath.setText(file);
+        }
+    });
+    openttdPathLayout.addWidget(&openttdPathButton);
+    openttdPathBox.setLayout(&openttdPathLayout);
+    openttdLayout.addWidget(&openttdPathBox);
+
+    QGroupBox reloadBox(QObject::tr("Reload NewGRFs after compiling"));
+    reloadBox.setCheckable(true);
+    reloadBox.setChecked(settings.value("openttd/reloadAfterCompiling", false).toBool());
+    reloadBox.setWhatsThis(QObject::tr("After compiling successfully, connects to the admin port of a running OpenTTD game and runs the reload_newgrfs console command, so that you can test your changes without restarting OpenTTD.") + "\n\n" + QObject::tr("The game must be a multiplayer game, and the admin port must be enabled by setting admin_password in the [network] section of openttd.cfg.") + "\n\n" + QObject::tr("Unmodified versions of OpenTTD only run reload_newgrfs in single-player games with the NewGRF developer tools enabled, so they refuse it through the admin port. The log shows the answer of OpenTTD."));
+    QFormLayout reloadLayout;
+    QLineEdit adminHost(settings.value("openttd/adminHost", "localhost").toString());
+    adminHost.setWhatsThis(QObject::tr("The computer OpenTTD is running on, usually localhost."));
+    reloadLayout.addRow(QObject::tr("Host"), &adminHost);
+    QSpinBox adminPort;
+    adminPort.setRange(1, 65535);
+    adminPort.setValue(settings.value("openttd/adminPort", AdminPortClient::defaultPort).toInt());
+    adminPort.setWhatsThis(QObject::tr("The admin port of OpenTTD, which is set by server_admin_port in openttd.cfg. The default is %1.").arg(AdminPortClient::defaultPort));
+    reloadLayout.addRow(QObject::tr("Admin port"), &adminPort);
+    QLineEdit adminPassword(settings.value("openttd/adminPassword", "").toString());
+    adminPassword.setEchoMode(QLineEdit::Password);
+    adminPassword.setWhatsThis(QObject::tr("The value of admin_password in openttd.cfg. It is stored unencrypted in the NMLCreator settings."));
+    reloadLayout.addRow(QObject::tr("Admin password"), &adminPassword);
+    reloadBox.setLayout(&reloadLayout);
+    openttdLayout.addWidget(&reloadBox);
+    openttdLayout.addStretch();
+
+    openttdTab.setLayout(&openttdLayout);
+    tabs.addTab(&openttdTab, QObject::tr("OpenTTD"));
+
     //Text editor tab
     QWidget textEditorTab;
     QVBoxLayout textEditorLayout;
@@ -1215,6 +1895,62 @@ void NMLProject::showSettingsWindow(){
     textEditorTab.setLayout(&textEditorLayout);
     tabs.addTab(&textEditorTab, QObject::tr("Text editor"));
 
+    //Sprite editor tab
+    QWidget spriteEditorTab;
+    QVBoxLayout spriteEditorLayout;
+
+    QGroupBox undoBox(QObject::tr("Undo history"));
+    QFormLayout undoLayout;
+    QSpinBox undoBudget;
+    undoBudget.setRange(0, 64 * 1024);
+    undoBudget.setSuffix(" MB");
+    undoBudget.setSpecialValueText(QObject::tr("Unlimited"));
+    undoBudget.setValue(settings.value("spriteEditor/undoBudget", 64).toInt());
+    undoBudget.setWhatsThis(QObject::tr("The oldest changes of an image can't be undone anymore when its undo history uses more memory than this. The last change can always be undone. Set to 0 to never forget changes."));
+    undoLayout.addRow(QObject::tr("Maximum memory per image"), &undoBudget);
+    QSpinBox totalUndoBudget;
+    totalUndoBudget.setRange(0, 64 * 1024);
+    totalUndoBudget.setSuffix(" MB");
+    totalUndoBudget.setSpecialValueText(QObject::tr("Unlimited"));
+    totalUndoBudget.setValue(settings.value("spriteEditor/totalUndoBudget", 256).toInt());
+    totalUndoBudget.setWhatsThis(QObject::tr("When the undo histories of all the open images together use more memory than this, the oldest changes are forgotten first, whichever image they belong to. Set to 0 to never forget changes."));
+    undoLayout.addRow(QObject::tr("Maximum memory for all images"), &totalUndoBudget);
+    undoBox.setLayout(&undoLayout);
+    spriteEditorLayout.addWidget(&undoBox);
+
+    QGroupBox importBox(QObject::tr("Images that don't use the OpenTTD palette"));
+    importBox.setWhatsThis(QObject::tr("Images that don't use the OpenTTD palette yet are converted to it when they are opened or compiled. Each color becomes the nearest color of the palette, except the colors excluded here. Colors that are exactly in the palette always keep their index."));
+    QVBoxLayout importLayout;
+    QCheckBox excludeTransparentColor(QObject::tr("Don't use the transparent blue (index 0) for nearby colors"));
+    excludeTransparentColor.setChecked(settings.value("spriteEditor/excludeTransparentColor", true).toBool());
+    importLayout.addWidget(&excludeTransparentColor);
+    QCheckBox excludeCompanyColors(QObject::tr("Don't use the company colors (0xC6 to 0xCD) for nearby colors"));
+    excludeCompanyColors.setChecked(settings.value("spriteEditor/excludeCompanyColors", true).toBool());
+    importLayout.addWidget(&excludeCompanyColors);
+    QCheckBox excludeAnimatedColors(QObject::tr("Don't use the animated colors (0xE3 to 0xFE) for nearby colors"));
+    excludeAnimatedColors.setChecked(settings.value("spriteEditor/excludeAnimatedColors", true).toBool());
+    importLayout.addWidget(&excludeAnimatedColors);
+    QCheckBox dither(QObject::tr("Dither"));
+    dither.setChecked(settings.value("spriteEditor/dither", false).toBool());
+    dither.setWhatsThis(QObject::tr("Spreads the difference between each color and the nearest color of the palette to the pixels around it, which looks better for renders with smooth gradients but adds noise to flat areas."));
+    importLayout.addWidget(&dither);
+    importBox.setLayout(&importLayout);
+    spriteEditorLayout.addWidget(&importBox);
+
+    QGroupBox saveBox(QObject::tr("Saving"));
+    QFormLayout saveLayout;
+    QSpinBox compressionLevel;
+    compressionLevel.setRange(0, 9);
+    compressionLevel.setValue(SpritePalette::compressionLevel());
+    compressionLevel.setWhatsThis(QObject::tr("How hard the PNG files are compressed, from 0 (no compression, fastest) to 9 (smallest files, slowest). The files always contain the same pixels, only their size and the time it takes to save them change."));
+    saveLayout.addRow(QObject::tr("PNG compression level"), &compressionLevel);
+    saveBox.setLayout(&saveLayout);
+    spriteEditorLayout.addWidget(&saveBox);
+    spriteEditorLayout.addStretch();
+
+    spriteEditorTab.setLayout(&spriteEditorLayout);
+    tabs.addTab(&spriteEditorTab, QObject::tr("Sprite editor"));
+
     //OK and cancel buttons
     QPushButton okButton(QObject::tr("OK"));
     okButton.setWhatsThis(QObject::tr("Closes this window and saves the changes."));
@@ -1246,9 +1982,26 @@ void NMLProject::showSettingsWindow(){
         enableCache.setChecked(true);
         cacheDir.setEnabled(true);
         cacheDir.setText(".nmlcache");
+        cacheBudget.setEnabled(true);
+        cacheBudget.setValue(0);
+        maximumJobs.setValue(0);
+        sharedCacheWidget.setEnabled(true);
+        sharedCacheDir.setText("");
         enableWarnings.setChecked(true);
         filterWarnings.setEnabled(true);
         filterWarnings.setText("");
+        openttdPath.setText(OPENTTD);
+        reloadBox.setChecked(false);
+        adminHost.setText("localhost");
+        adminPort.setValue(AdminPortClient::defaultPort);
+        adminPassword.setText("");
+        undoBudget.setValue(64);
+        totalUndoBudget.setValue(256);
+        excludeTransparentColor.setChecked(true);
+        excludeCompanyColors.setChecked(true);
+        excludeAnimatedColors.setChecked(true);
+        dither.setChecked(false);
+        compressionLevel.setValue(6);
 
         settingsWindow.accept();
     });
@@ -1263,8 +2016,25 @@ void NMLProject::showSettingsWindow(){
         settings.setValue("compiler/path", compilerPath.text());
         settings.setValue("compiler/enableCache", enableCache.isChecked());
         settings.setValue("compiler/cacheDir", cacheDir.text());
+        settings.setValue("compiler/cacheBudget", cacheBudget.value());
+        settings.setValue("compiler/maximumJobs", maximumJobs.value());
+        BuildPool::instance()->setMaximumJobs(maximumJobs.value());
+        settings.setValue("compiler/sharedCacheDir", sharedCacheDir.text());
         settings.setValue("compiler/enableWarnings", enableWarnings.isChecked());
         settings.setValue("compiler/filterWarnings", filterWarnings.text());
+        settings.setValue("openttd/path", openttdPath.text());
+        settings.setValue("openttd/reloadAfterCompiling", reloadBox.isChecked());
+        settings.setValue("openttd/adminHost", adminHost.text());
+        settings.setValue("openttd/adminPort", adminPort.value());
+        settings.setValue("openttd/adminPassword", adminPassword.text());
+        settings.setValue("spriteEditor/undoBudget", undoBudget.value());
+        settings.setValue("spriteEditor/totalUndoBudget", totalUndoBudget.value());
+        settings.setValue("spriteEditor/excludeTransparentColor", excludeTransparentColor.isChecked());
+        settings.setValue("spriteEditor/excludeCompanyColors", excludeCompanyColors.isChecked());
+        settings.setValue("spriteEditor/excludeAnimatedColors", excludeAnimatedColors.isChecked());
+        settings.setValue("spriteEditor/dither", dither.isChecked());
+        settings.setValue("spriteEditor/compressionLevel", compressionLevel.value());
+        SpriteHistory::setBudgets(undoBudget.value() * qint64(1024 * 1024), totalUndoBudget.value() * qint64(1024 * 1024));
 
         settings.setValue("textEditor/font", exampleText.font());
         commentsButton.saveColorSettings();
@@ -1278,6 +2048,558 @@ void NMLProject::showSettingsWindow(){
     }
 }
 
+void NMLProject::showBuildConfigurationsWindow(){
+    QDialog window(this, Qt::WindowSystemMenuHint | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    window.setWindowTitle(QObject::tr("Build Configurations"));
+    QGridLayout layout;
+
+    QTableWidget table(0, 5);
+    table.setHorizontalHeaderLabels({QObject::tr("Name"), QObject::tr("Output type"), QObject::tr("Output file"), QObject::tr("Extra compiler arguments"), QObject::tr("Enabled")});
+    table.horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table.horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    table.horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
+    table.verticalHeader()->hide();
+    table.setWhatsThis(QObject::tr("Each enabled build configuration is compiled when you compile the project. Build configurations are compiled at the same time, up to one per processor core.") + "\n\n" + QObject::tr("If the output file is left empty, GRF files are written to the OpenTTD NewGRF folder and other files to the project folder. Relative paths are relative to the folder containing the .nml file."));
+    layout.addWidget(&table, 0, 0, 1, 4);
+
+    const auto addRow = [&table](const BuildConfiguration &configuration){
+        const int row = table.rowCount();
+        table.insertRow(row);
+        table.setItem(row, 0, new QTableWidgetItem(configuration.name));
+        QComboBox *outputType = new QComboBox;
+        outputType->addItems(BuildConfiguration::outputTypes);
+        outputType->setCurrentText(configuration.outputType);
+        table.setCellWidget(row, 1, outputType);
+        table.setItem(row, 2, new QTableWidgetItem(configuration.output));
+        QStringList extraArguments;
+        for(const QString &argument: configuration.extraArguments){
+            extraArguments.append(argument.contains(' ') ? "\"" + argument + "\"" : argument);
+        }
+        table.setItem(row, 3, new QTableWidgetItem(extraArguments.join(" ")));
+        QTableWidgetItem *enabled = new QTableWidgetItem;
+        enabled->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+        enabled->setCheckState(configuration.enabled ? Qt::Checked : Qt::Unchecked);
+        table.setItem(row, 4, enabled);
+    };
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(this->_nmlFile)){
+        addRow(configuration);
+    }
+
+    QPushButton addButton(QObject::tr("Add"));
+    addButton.setWhatsThis(QObject::tr("Adds a new build configuration."));
+    QObject::connect(&addButton, &QPushButton::pressed, [&](){
+        addRow(BuildConfiguration(QObject::tr("Configuration %1").arg(table.rowCount() + 1), "grf", QFileInfo(this->_nmlFile).baseName() + "-" + QString::number(table.rowCount() + 1) + ".grf"));
+    });
+    layout.addWidget(&addButton, 1, 0);
+
+    QPushButton removeButton(QObject::tr("Remove"));
+    removeButton.setWhatsThis(QObject::tr("Removes the selected build configuration."));
+    QObject::connect(&removeButton, &QPushButton::pressed, [&](){
+        if(table.currentRow() >= 0){
+            table.removeRow(table.currentRow());
+        }
+    });
+    layout.addWidget(&removeButton, 1, 1);
+
+    QList<BuildConfiguration> configurations;
+    QPushButton okButton(QObject::tr("OK"));
+    QObject::connect(&okButton, &QPushButton::pressed, [&](){
+        configurations.clear();
+        QStringList names, outputs;
+        for(int row = 0; row < table.rowCount(); row++){
+            const BuildConfiguration configuration(
+                table.item(row, 0)->text().trimmed(),
+                dynamic_cast<QComboBox*>(table.cellWidget(row, 1))->currentText(),
+                table.item(row, 2)->text().trimmed(),
+                QProcess::splitCommand(table.item(row, 3)->text()),
+                table.item(row, 4)->checkState() == Qt::Checked
+            );
+            if(configuration.name.isEmpty() || names.contains(configuration.name)){
+                QMessageBox::critical(&window, "", QObject::tr("Each build configuration must have a unique name."));
+                return;
+            }
+            if(configuration.enabled && outputs.contains(configuration.outputPath(this->_nmlFile))){
+                QMessageBox::critical(&window, "", QObject::tr("The build configurations %1 and %2 write to the same output file. Please specify a different output file for one of them.").arg(configurations[outputs.indexOf(configuration.outputPath(this->_nmlFile))].name, configuration.name));
+                return;
+            }
+            names.append(configuration.name);
+            outputs.append(configuration.enabled ? configuration.outputPath(this->_nmlFile) : "");
+            configurations.append(configuration);
+        }
+        window.accept();
+    });
+    layout.addWidget(&okButton, 1, 2);
+
+    QPushButton cancelButton(QObject::tr("Cancel"));
+    QObject::connect(&cancelButton, &QPushButton::pressed, &window, &QDialog::reject);
+    layout.addWidget(&cancelButton, 1, 3);
+
+    window.setLayout(&layout);
+    window.resize(800, 300);
+    if(window.exec()){
+        BuildConfiguration::save(this->_nmlFile, configurations);
+    }
+}
+
+void NMLProject::createPackage(){
+    const QString grfFile = BananasPackage::grfFile(this->_nmlFile);
+    if(grfFile.isEmpty()){
+        QMessageBox::critical(this, "", QObject::tr("None of the enabled build configurations of this project compiles a .grf file. Please enable one of them under File > Build configurations."));
+        return;
+    }
+    if(!this->_compilerLogItems.isEmpty()){
+        QMessageBox::critical(this, "", QObject::tr("Please wait until the project is compiled."));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    BananasPackage::Info info;
+    QString error;
+    const bool created = BananasPackage::create(this->_nmlFile, grfFile, &info, &error);
+    QApplication::restoreOverrideCursor();
+    if(!created){
+        QMessageBox::critical(this, "", error);
+        return;
+    }
+
+    QString message = QObject::tr("The package %1 was created. You can upload it on the BaNaNaS website.").arg(info.packageFile) + "\n\n" + QObject::tr("Files: %1").arg(info.files.join(", ")) + "\n" + QObject::tr("Size: %1 KB (%2 KB uncompressed .grf file)").arg(info.packageSize / 1024.0, 0, 'f', 1).arg(info.grfSize / 1024.0, 0, 'f', 1) + "\n" + QObject::tr("GRF ID: %1").arg(info.grfId.isEmpty() ? QObject::tr("not found") : info.grfId) + "\n" + QObject::tr("MD5: %1").arg(info.md5);
+    if(BananasPackage::documentationFiles(this->_nmlFile).length() < BananasPackage::documentationFileNames.length()){
+        message += "\n\n" + QObject::tr("Consider adding the missing files among %1 to your project folder, BaNaNaS shows them on the page of your NewGRF.").arg(BananasPackage::documentationFileNames.join(", "));
+    }
+    QMessageBox::information(this, "", message);
+}
+
+void NMLProject::showBenchmarkWindow(){
+    if(this->_benchmark->isRunning()){
+        if(QMessageBox::question(this, "", QObject::tr("A benchmark is running. Do you want to stop it?")) == QMessageBox::Yes){
+            this->_benchmark->cancel();
+        }
+        return;
+    }
+
+    QSettings projectSettings(BuildConfiguration::settingsFile(this->_nmlFile), QSettings::IniFormat);
+    QDialog window(this, Qt::WindowSystemMenuHint | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    window.setWindowTitle(QObject::tr("Benchmark"));
+    QFormLayout layout;
+
+    QLabel description(QObject::tr("Runs a savegame in OpenTTD without any window or sound and measures how long each tick takes. OpenTTD uses the NewGRF that was compiled most recently if the savegame uses an older version of it, so compile your project before running the benchmark."));
+    description.setWordWrap(true);
+    layout.addRow(&description);
+
+    QWidget savegameWidget;
+    QHBoxLayout savegameLayout;
+    savegameLayout.setContentsMargins(0, 0, 0, 0);
+    QLineEdit savegame(projectSettings.value("benchmark/savegame", "").toString());
+    savegame.setWhatsThis(QObject::tr("The savegame to run. It must use the NewGRF of this project, for example a game in which many vehicles or houses of the NewGRF are used."));
+    savegameLayout.addWidget(&savegame);
+    QPushButton browseButton(QObject::tr("Browse..."));
+    QObject::connect(&browseButton, &QPushButton::pressed, [&](){
+        const QString file = QFileDialog::getOpenFileName(&window, QObject::tr("Select Savegame"), savegame.text(), QObject::tr("OpenTTD savegames") + " (*.sav)");
+        if(!file.isEmpty()){
+            savegame.setText(file);
+        }
+    });
+    savegameLayout.addWidget(&browseButton);
+    savegameWidget.setLayout(&savegameLayout);
+    layout.addRow(QObject::tr("Savegame"), &savegameWidget);
+
+    QSpinBox ticks;
+    ticks.setRange(2, 1000000);
+    ticks.setValue(projectSettings.value("benchmark/ticks", 2000).toInt());
+    ticks.setWhatsThis(QObject::tr("How many ticks OpenTTD runs. A day lasts 74 ticks. More ticks give more precise results."));
+    layout.addRow(QObject::tr("Ticks"), &ticks);
+
+    QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    buttons.button(QDialogButtonBox::Ok)->setText(QObject::tr("Run"));
+    QObject::connect(&buttons, &QDialogButtonBox::accepted, &window, &QDialog::accept);
+    QObject::connect(&buttons, &QDialogButtonBox::rejected, &window, &QDialog::reject);
+    layout.addRow(&buttons);
+
+    window.setLayout(&layout);
+    window.resize(600, 0);
+    if(!window.exec()){
+        return;
+    }
+    projectSettings.setValue("benchmark/savegame", savegame.text());
+    projectSettings.setValue("benchmark/ticks", ticks.value());
+
+    this->_benchmarkItem = new QStandardItem(QObject::tr("Benchmark: Running OpenTTD for %1 ticks...").arg(ticks.value()));
+    this->_logModel.appendRow(this->_benchmarkItem);
+    this->_logDockWidget.show();
+    this->_benchmark->start(savegame.text(), ticks.value());
+}
+
+void NMLProject::showBenchmarkResult(const Benchmark::Result &result){
+    if(!this->logContains(this->_benchmarkItem)){
+        this->_benchmarkItem = new QStandardItem;    //The log was cleared while the benchmark was running
+        this->_logModel.appendRow(this->_benchmarkItem);
+    }
+    QStandardItem *item = this->_benchmarkItem;
+    this->_benchmarkItem = nullptr;
+    if(!result.success){
+        item->setText(QObject::tr("Benchmark: %1").arg(result.error));
+        item->setIcon(QIcon(":/icons/error.svg"));
+        return;
+    }
+
+    //Compare with the previous run of the same savegame if there is one, the last result in the history is this one
+    const QList<Benchmark::Result> history = Benchmark::loadHistory(this->_nmlFile);
+    Benchmark::Result previous;
+    for(int i = history.length() - 2; i >= 0; i--){
+        if(history[i].success && (!previous.success || (history[i].savegame == result.savegame && history[i].ticks == result.ticks))){
+            previous = history[i];
+            if(previous.savegame == result.savegame && previous.ticks == result.ticks){
+                break;
+            }
+        }
+    }
+
+    item->setText(QObject::tr("Benchmark: %1 ms per tick over %2 ticks (%3)").arg(result.msPerTick, 0, 'f', 3).arg(result.ticks).arg(Benchmark::compare(previous, result)));
+    item->appendRow(new QStandardItem(QObject::tr("Starting OpenTTD and loading the savegame: %1 ms").arg(result.loadTime)));
+    item->appendRow(new QStandardItem(QObject::tr("Running all the ticks: %1 ms").arg(result.runTime)));
+    if(result.cpuTime >= 0){
+        item->appendRow(new QStandardItem(QObject::tr("CPU time of the ticks: %1 ms").arg(result.cpuTime)));
+    }
+    if(result.peakMemory >= 0){
+        item->appendRow(new QStandardItem(QObject::tr("Peak memory: %1 MB").arg(result.peakMemory / 1024.0, 0, 'f', 1)));
+    }
+}
+
+void NMLProject::showCostWindow(){
+    QDialog window(this, Qt::WindowSystemMenuHint | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    window.setWindowTitle(QObject::tr("Runtime Cost of Callbacks"));
+    QGridLayout layout;
+
+    QTreeWidget tree;
+    tree.setColumnCount(5);
+    tree.setHeaderLabels({QObject::tr("Item"), QObject::tr("Line"), QObject::tr("Switches"), QObject::tr("Expensive variables"), QObject::tr("Longest chain")});
+    tree.setWhatsThis(QObject::tr("Shows, for each callback of each item, how many switches and random switches OpenTTD may have to go through to evaluate it and how many expensive variables, such as nearby_tile_* and other variables that take a parameter, it may evaluate on the way.") + "\n\n" + QObject::tr("Callbacks going through at least %1 switches or evaluating at least %2 expensive variables, and the switches evaluating expensive variables, are marked in the line numbers of the text editor.").arg(CostAnalyzer::deepChain).arg(CostAnalyzer::manyExpensiveVariables));
+    layout.addWidget(&tree, 0, 0, 1, 2);
+
+    const CostAnalyzer::Result result = this->_costAnalyzer.result();
+    QMap<QString, QTreeWidgetItem*> itemItems;
+    int maximumDepth = 0;
+    for(const CostAnalyzer::Callback &callback: result.callbacks){
+        QTreeWidgetItem *&itemItem = itemItems[callback.item];
+        if(itemItem == nullptr){
+            itemItem = new QTreeWidgetItem({callback.item});
+            tree.addTopLevelItem(itemItem);
+        }
+        QTreeWidgetItem *callbackItem = new QTreeWidgetItem({callback.callback, QString::number(callback.line), QString::number(callback.depth), QString::number(callback.expensiveVariables), callback.chain.join(" > ")});
+        callbackItem->setData(0, Qt::UserRole, callback.file);
+        if(callback.depth >= CostAnalyzer::deepChain || callback.expensiveVariables >= CostAnalyzer::manyExpensiveVariables){
+            callbackItem->setIcon(0, QIcon(":/icons/warning.svg"));
+            itemItem->setIcon(0, QIcon(":/icons/warning.svg"));
+        }
+        itemItem->addChild(callbackItem);
+        itemItem->setText(2, QString::number(qMax(itemItem->text(2).toInt(), callback.depth)));
+        itemItem->setText(3, QString::number(qMax(itemItem->text(3).toInt(), callback.expensiveVariables)));
+        maximumDepth = qMax(maximumDepth, callback.depth);
+    }
+    tree.expandAll();
+    tree.header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QObject::connect(&tree, &QTreeWidget::itemDoubleClicked, [this, &window](QTreeWidgetItem *item){
+        const QString file = item->data(0, Qt::UserRole).toString();
+        if(file.isEmpty() || !this->setActiveFile(file)){
+            return;
+        }
+        TextEditor *editor = this->_textEditors.textEditorFromFileName(file);
+        editor->setTextCursor(QTextCursor(editor->document()->findBlockByLineNumber(item->text(1).toInt() - 1)));
+        window.accept();
+    });
+
+    QLabel summary(this->_costAnalyzer.isRunning() ? QObject::tr("The analysis is being updated.") : QObject::tr("%n switch(es), the longest chain has %1 switch(es).", "", result.switches).arg(maximumDepth));
+    layout.addWidget(&summary, 1, 0);
+
+    QPushButton closeButton(QObject::tr("Close"));
+    QObject::connect(&closeButton, &QPushButton::pressed, &window, &QDialog::accept);
+    layout.addWidget(&closeButton, 1, 1);
+
+    layout.setColumnStretch(0, 1);
+    window.setLayout(&layout);
+    window.resize(800, 500);
+    window.exec();
+}
+
+void NMLProject::showCompilerBenchmarkWindow(){
+    if(this->_compilerBenchmark->isRunning()){
+        if(QMessageBox::question(this, "", QObject::tr("A compiler benchmark is running. Do you want to stop it?")) == QMessageBox::Yes){
+            this->_compilerBenchmark->cancel();
+        }
+        return;
+    }
+
+    QSettings projectSettings(BuildConfiguration::settingsFile(this->_nmlFile), QSettings::IniFormat);
+    QDialog window(this, Qt::WindowSystemMenuHint | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    window.setWindowTitle(QObject::tr("Compare Compilers"));
+    QGridLayout layout;
+
+    QLabel description(QObject::tr("Compiles the saved project several times with each variant and compares how long it takes, how much memory the compiler uses and whether the .grf files are identical. Each variant has its own sprite cache, which is empty at the start of the benchmark."));
+    description.setWordWrap(true);
+    layout.addWidget(&description, 0, 0, 1, 4);
+
+    QTableWidget table(0, 4);
+    table.setHorizontalHeaderLabels({QObject::tr("Name"), QObject::tr("Compiler command"), QObject::tr("Extra compiler arguments"), QObject::tr("Sprite cache")});
+    table.horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table.horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    table.horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    table.verticalHeader()->hide();
+    table.setWhatsThis(QObject::tr("If the compiler command is left empty, the compiler in the settings is used. The command can contain arguments, for example \"python3 nml-0.7.5/nmlc\".") + "\n\n" + QObject::tr("The extra compiler arguments are passed after the ones of the build configuration, for example --clear-orphaned."));
+    layout.addWidget(&table, 1, 0, 1, 4);
+
+    const auto addRow = [&table](const CompilerBenchmark::Variant &variant){
+        const int row = table.rowCount();
+        table.insertRow(row);
+        table.setItem(row, 0, new QTableWidgetItem(variant.name));
+        table.setItem(row, 1, new QTableWidgetItem(variant.compiler));
+        QStringList arguments;
+        for(const QString &argument: variant.arguments){
+            arguments.append(argument.contains(' ') ? "\"" + argument + "\"" : argument);
+        }
+        table.setItem(row, 2, new QTableWidgetItem(arguments.join(" ")));
+        QTableWidgetItem *cache = new QTableWidgetItem;
+        cache->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+        cache->setCheckState(variant.cache ? Qt::Checked : Qt::Unchecked);
+        table.setItem(row, 3, cache);
+    };
+    for(const CompilerBenchmark::Variant &variant: CompilerBenchmark::loadVariants(this->_nmlFile)){
+        addRow(variant);
+    }
+
+    QPushButton addButton(QObject::tr("Add"));
+    QObject::connect(&addButton, &QPushButton::pressed, [&](){
+        addRow({QObject::tr("Variant %1").arg(table.rowCount() + 1), "", {}, true});
+    });
+    layout.addWidget(&addButton, 2, 0);
+    QPushButton removeButton(QObject::tr("Remove"));
+    QObject::connect(&removeButton, &QPushButton::pressed, [&](){
+        if(table.currentRow() >= 0){
+            table.removeRow(table.currentRow());
+        }
+    });
+    layout.addWidget(&removeButton, 2, 1);
+
+    QFormLayout optionsLayout;
+    QComboBox configurationBox;
+    QList<BuildConfiguration> configurations;
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(this->_nmlFile)){
+        if(configuration.enabled){
+            configurations.append(configuration);
+            configurationBox.addItem(configuration.name);
+        }
+    }
+    configurationBox.setCurrentText(projectSettings.value("compilerBenchmark/configuration", "").toString());
+    optionsLayout.addRow(QObject::tr("Build configuration"), &configurationBox);
+    QSpinBox runs;
+    runs.setRange(1, 100);
+    runs.setValue(projectSettings.value("compilerBenchmark/runs", 5).toInt());
+    runs.setWhatsThis(QObject::tr("How many times each variant is compiled. The median and the 95th percentile of the compilation times are shown, so more runs give more reliable results."));
+    optionsLayout.addRow(QObject::tr("Runs per variant"), &runs);
+    QCheckBox warmUp(QObject::tr("Compile each variant once before measuring"));
+    warmUp.setChecked(projectSettings.value("compilerBenchmark/warmUp", true).toBool());
+    warmUp.setWhatsThis(QObject::tr("The first compilation fills the sprite cache and is usually much slower than the next ones. Leave this checked to measure the compilation of a project that was already compiled before."));
+    optionsLayout.addRow(&warmUp);
+    layout.addLayout(&optionsLayout, 3, 0, 1, 4);
+
+    QList<CompilerBenchmark::Variant> variants;
+    QPushButton runButton(QObject::tr("Run"));
+    QObject::connect(&runButton, &QPushButton::pressed, [&](){
+        variants.clear();
+        for(int row = 0; row < table.rowCount(); row++){
+            variants.append({table.item(row, 0)->text().trimmed(), table.item(row, 1)->text().trimmed(), QProcess::splitCommand(table.item(row, 2)->text()), table.item(row, 3)->checkState() == Qt::Checked});
+        }
+        if(variants.isEmpty() || configurations.isEmpty()){
+            QMessageBox::critical(&window, "", QObject::tr("The benchmark needs at least one variant and one enabled build configuration."));
+            return;
+        }
+        window.accept();
+    });
+    layout.addWidget(&runButton, 2, 2);
+    QPushButton cancelButton(QObject::tr("Cancel"));
+    QObject::connect(&cancelButton, &QPushButton::pressed, &window, &QDialog::reject);
+    layout.addWidget(&cancelButton, 2, 3);
+
+    window.setLayout(&layout);
+    window.resize(800, 400);
+    if(!window.exec()){
+        return;
+    }
+    CompilerBenchmark::saveVariants(this->_nmlFile, variants);
+    projectSettings.setValue("compilerBenchmark/configuration", configurationBox.currentText());
+    projectSettings.setValue("compilerBenchmark/runs", runs.value());
+    projectSettings.setValue("compilerBenchmark/warmUp", warmUp.isChecked());
+
+    //The saved files are compiled, like from the command line
+    QString inputFile = this->_nmlFile;
+    if(Preprocessor::isPreprocessed(this->_nmlFile)){
+        Preprocessor preprocessor(this->_nmlFile);
+        inputFile = Preprocessor::outputFile(this->_nmlFile);
+        if(!preprocessor.preprocessToFile(inputFile)){
+            QMessageBox::critical(this, "", preprocessor.errors().isEmpty() ? QObject::tr("Could not write the file %1.").arg(inputFile) : preprocessor.errors().first().toString());
+            return;
+        }
+    }
+
+    QString error;
+    this->_compilerBenchmarkItem = new QStandardItem(QObject::tr("Compiler benchmark: Starting..."));
+    this->_logModel.appendRow(this->_compilerBenchmarkItem);
+    this->_logDockWidget.show();
+    if(!this->_compilerBenchmark->start(inputFile, configurations.value(configurationBox.currentIndex()), variants, runs.value(), warmUp.isChecked(), &error)){
+        this->_compilerBenchmarkItem->setText(QObject::tr("Compiler benchmark: %1").arg(error));
+        this->_compilerBenchmarkItem->setIcon(QIcon(":/icons/error.svg"));
+    }
+}
+
+void NMLProject::showCompilerBenchmarkResult(bool cancelled){
+    if(!this->logContains(this->_compilerBenchmarkItem)){
+        this->_compilerBenchmarkItem = new QStandardItem;    //The log was cleared while the benchmark was running
+        this->_logModel.appendRow(this->_compilerBenchmarkItem);
+    }
+    QStandardItem *item = this->_compilerBenchmarkItem;
+    this->_compilerBenchmarkItem = nullptr;
+    const QList<CompilerBenchmark::Summary> summaries = this->_compilerBenchmark->summaries();
+    if(cancelled){
+        item->setText(QObject::tr("Compiler benchmark: Stopped."));
+        return;
+    }
+    item->setText(QObject::tr("Compiler benchmark: %n variant(s) compared", "", summaries.length()));
+
+    const auto memoryText = [](qint64 memory){
+        return (memory < 0) ? QObject::tr("unknown") : QObject::tr("%1 MB").arg(memory / 1024.0, 0, 'f', 1);
+    };
+    //The output of the other variants is compared with the one of the first variant that compiled successfully at least once
+    const CompilerBenchmark::Summary *reference = nullptr;
+    for(const CompilerBenchmark::Summary &summary: summaries){
+        if(summary.failures() < summary.runs.length()){
+            reference = &summary;
+            break;
+        }
+    }
+    for(const CompilerBenchmark::Summary &summary: summaries){
+        QStandardItem *variantItem = new QStandardItem;
+        if(summary.failures() == summary.runs.length()){
+            variantItem->setText(QObject::tr("%1: Failed: %2").arg(summary.variant.name, summary.error));
+            variantItem->setIcon(QIcon(":/icons/error.svg"));
+            item->appendRow(variantItem);
+            continue;
+        }
+
+        QString output;
+        if(!summary.isDeterministic()){
+            output = QObject::tr("the output is different in each run");
+        }
+        else if(&summary == reference){
+            output = QObject::tr("output %1").arg(QString(summary.md5().toHex()));
+        }
+        else{
+            output = (summary.md5() == reference->md5()) ? QObject::tr("same output as %1").arg(reference->variant.name) : QObject::tr("output different from %1").arg(reference->variant.name);
+        }
+        variantItem->setText(QObject::tr("%1: median %2 ms, p95 %3 ms, CPU time %4, peak memory %5, %6").arg(summary.variant.name).arg(summary.medianWallTime()).arg(summary.p95WallTime()).arg((summary.medianCpuTime() < 0) ? QObject::tr("unknown") : QObject::tr("%1 ms").arg(summary.medianCpuTime())).arg(memoryText(summary.peakMemory()), output));
+        if(summary.failures() > 0){
+            variantItem->setText(variantItem->text() + ", " + QObject::tr("%n run(s) failed: %1", "", summary.failures()).arg(summary.error));
+            variantItem->setIcon(QIcon(":/icons/warning.svg"));
+        }
+        else if(!summary.isDeterministic() || summary.md5() != reference->md5()){
+            variantItem->setIcon(QIcon(":/icons/warning.svg"));
+        }
+        for(int i = 0; i < summary.runs.length(); i++){
+            const CompilerBenchmark::Run &run = summary.runs[i];
+            variantItem->appendRow(new QStandardItem(run.success ? QObject::tr("Run %1: %2 ms, peak memory %3").arg(i + 1).arg(run.wallTime).arg(memoryText(run.peakMemory)) : QObject::tr("Run %1: failed").arg(i + 1)));
+        }
+        item->appendRow(variantItem);
+    }
+}
+
+void NMLProject::showSpriteCacheWindow(){
+    QDialog window(this, Qt::WindowSystemMenuHint | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
+    window.setWindowTitle(QObject::tr("Sprite Cache"));
+    QGridLayout layout;
+
+    QTreeWidget tree;
+    tree.setColumnCount(4);
+    tree.setHeaderLabels({QObject::tr("Sprite"), QObject::tr("Region"), QObject::tr("Encoded size"), QObject::tr("Status")});
+    tree.setWhatsThis(QObject::tr("Shows the sprites encoded by the compiler in the cache of each build configuration, grouped by file with the largest files first. The encoded size of a sprite is roughly the size it takes in the .grf file.") + "\n\n" + QObject::tr("Sprites whose file was modified since the cache was written are encoded again the next time the project is compiled."));
+    layout.addWidget(&tree, 0, 0, 1, 2);
+
+    const auto sizeText = [](qint64 size){
+        return QObject::tr("%1 KB").arg(size / 1024.0, 0, 'f', 1);
+    };
+    int staleSprites = 0;
+    qint64 totalSize = 0;
+    for(const BuildConfiguration &configuration: BuildConfiguration::load(this->_nmlFile)){
+        const QString cacheDir = SpriteCache::directory(this->_nmlFile, configuration);
+        QTreeWidgetItem *configurationItem = new QTreeWidgetItem({configuration.name});
+        tree.addTopLevelItem(configurationItem);
+
+        //Group the sprites by file, since a sprite sheet usually contains many sprites
+        struct SpriteFile{
+            QList<SpriteCacheReader::Entry> entries;
+            qint64 size;
+            SpriteCacheReader::Status status;
+        };
+        QMap<QString, SpriteFile> spriteFiles;
+        qint64 configurationSize = 0;
+        for(const QString &indexFile: QDir(cacheDir).entryList({"*.cacheindex"}, QDir::Files)){
+            const SpriteCacheReader reader(cacheDir + "/" + indexFile, this->_projectDir.path());
+            for(const SpriteCacheReader::Entry &entry: reader.entries()){
+                SpriteFile &spriteFile = spriteFiles[entry.rgbFile.isEmpty() ? entry.maskFile : entry.rgbFile];
+                if(spriteFile.entries.isEmpty()){
+                    spriteFile.size = 0;
+                    spriteFile.status = SpriteCacheReader::UpToDate;
+                }
+                spriteFile.entries.append(entry);
+                spriteFile.size += entry.size;
+                spriteFile.status = qMax(spriteFile.status, entry.status);
+                staleSprites += (entry.status != SpriteCacheReader::UpToDate);
+            }
+            configurationSize += reader.encodedSize();
+        }
+        totalSize += configurationSize;
+        if(spriteFiles.isEmpty()){
+            configurationItem->setText(1, QObject::tr("The cache is empty, compile the project to fill it."));
+            continue;
+        }
+        configurationItem->setText(2, sizeText(configurationSize));
+
+        QStringList fileNames = spriteFiles.keys();
+        std::sort(fileNames.begin(), fileNames.end(), [&spriteFiles](const QString &a, const QString &b){
+            return spriteFiles[a].size > spriteFiles[b].size;
+        });
+        for(const QString &fileName: qAsConst(fileNames)){
+            const SpriteFile &spriteFile = spriteFiles[fileName];
+            QTreeWidgetItem *fileItem = new QTreeWidgetItem({fileName, QObject::tr("%n sprite(s)", "", spriteFile.entries.length()), sizeText(spriteFile.size), SpriteCacheReader::statusText(spriteFile.status)});
+            if(spriteFile.status != SpriteCacheReader::UpToDate){
+                fileItem->setIcon(3, QIcon(":/icons/warning.svg"));
+            }
+            configurationItem->addChild(fileItem);
+            for(const SpriteCacheReader::Entry &entry: spriteFile.entries){
+                const QRect &rect = entry.rgbRect.isNull() ? entry.maskRect : entry.rgbRect;
+                const QString region = QString("%1, %2 (%3 x %4)").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+                fileItem->addChild(new QTreeWidgetItem({entry.maskFile.isEmpty() ? "" : QObject::tr("Mask: %1").arg(entry.maskFile), region, QObject::tr("%1 bytes").arg(entry.size), SpriteCacheReader::statusText(entry.status)}));
+            }
+        }
+        configurationItem->setExpanded(true);
+    }
+    tree.header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tree.header()->setStretchLastSection(false);
+    for(int column = 1; column < tree.columnCount(); column++){
+        tree.header()->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+    }
+
+    QLabel summary(QObject::tr("Total encoded size: %1. %n sprite(s) will be encoded again the next time the project is compiled.", "", staleSprites).arg(sizeText(totalSize)));
+    layout.addWidget(&summary, 1, 0);
+
+    QPushButton closeButton(QObject::tr("Close"));
+    QObject::connect(&closeButton, &QPushButton::pressed, &window, &QDialog::accept);
+    layout.addWidget(&closeButton, 1, 1);
+
+    layout.setColumnStretch(0, 1);
+    window.setLayout(&layout);
+    window.resize(800, 500);
+    window.exec();
+}
+
 QString NMLProject::fileFromModelIndex(const QModelIndex &index) const{
     if(!index.isValid()){
         return "";
@@ -1294,6 +2616,8 @@ QString NMLProject::fileFromModelIndex(const QModelIndex &index) const{
         return "";
     }
     else switch(index.parent().row()){
+    case 0:
+        return this->_includedFiles.value(index.row());
     case 1:
         return this->_languageFiles[index.row()];
     case 2:
@@ -1308,11 +2632,23 @@ bool NMLProject::setActiveFile(const QString &fileName){
         if(!this->_spriteEditors.contains(fileName)){
             return false;
         }
-        editor = new QScrollArea;
+        if(this->_spriteLoader.isLoading(fileName)){
+            this->_spriteLoader.load(fileName, true);    //The sprite is shown again when it's loaded
+        }
+        if(this->_spriteEditors[fileName] == nullptr){
+            SpriteEditor *spriteEditor = new SpriteEditor(fileName);
+            if(spriteEditor->image().isNull()){
+                QMessageBox::critical(this, "", QObject::tr("The file %1 is not a valid image file.").arg(fileName));
+                delete spriteEditor;
+                return false;
+            }
+            this->_spriteEditors[fileName] = spriteEditor;
+        }
+        editor = this->_spriteEditors[fileName];
     }
     else{
         editor = this->_textEditors.textEditorFromFileName(fileName);
-        if(editor == nullptr && !(editor = this->_textEditors.addTextEditor(fileName, (QFileInfo(fileName).suffix() == "nml") ? SyntaxHighlighter::NML : SyntaxHighlighter::LNG))){
+        if(editor == nullptr && !(editor = this->_textEditors.addTextEditor(fileName, (QFileInfo(fileName).suffix() == "lng") ? SyntaxHighlighter::LNG : SyntaxHighlighter::NML))){
             return false;
         }
     }
@@ -1325,11 +2661,9 @@ bool NMLProject::setActiveFile(const QString &fileName){
     this->_selectAllButton->disconnect();
     QWidget *activeEditor = this->centralWidget();
     TextEditor *activeTextEditor = dynamic_cast<TextEditor*>(activeEditor);
-    SpriteEditor *activeSpriteEditor = nullptr;
-    QScrollArea *activeScrollArea = dynamic_cast<QScrollArea*>(activeEditor);
-    if(activeScrollArea != nullptr){
-        activeSpriteEditor = dynamic_cast<SpriteEditor*>(activeScrollArea->widget());
-        activeSpriteEditor->setParent(nullptr);
+    SpriteEditor *activeSpriteEditor = dynamic_cast<SpriteEditor*>(activeEditor);
+    if(activeSpriteEditor != nullptr){
+        activeSpriteEditor->setParent(nullptr);    //Otherwise setCentralWidget() deletes it
         activeSpriteEditor->hide();
         activeSpriteEditor->disconnect();    //This is all we need, the buttons are disconnected above
 
@@ -1352,8 +2686,9 @@ bool NMLProject::setActiveFile(const QString &fileName){
     editor->show();    //To compensate for hiding the widget above
 
     TextEditor *textEditor = dynamic_cast<TextEditor*>(editor);
-    QScrollArea *scrollArea = dynamic_cast<QScrollArea*>(editor);
+    SpriteEditor *spriteEditor = dynamic_cast<SpriteEditor*>(editor);
     if(textEditor != nullptr){
+        textEditor->setHotSpots(this->_costAnalyzer.result().hotSpots.value(fileName));
         QObject::connect(this->_undoButton, &QAction::triggered, textEditor, &TextEditor::undo);
         QObject::connect(textEditor, &TextEditor::undoAvailable, this->_undoButton, &QAction::setEnabled);
         this->_undoButton->setEnabled(this->_textEditors.undoEnabled(textEditor));
@@ -1374,11 +2709,7 @@ bool NMLProject::setActiveFile(const QString &fileName){
 
         this->setWindowTitle((this->_textEditors.hasUnsavedChanges(textEditor) ? "*" : "") + QFileInfo(fileName).fileName() + " @ " + QFileInfo(this->_nmlFile).fileName() + " - NMLCreator");
     }
-    if(scrollArea != nullptr){
-        SpriteEditor *spriteEditor = this->_spriteEditors[fileName];
-        scrollArea->setWidget(spriteEditor);
-        spriteEditor->show();
-
+    if(spriteEditor != nullptr){
         QObject::connect(this->_undoButton, &QAction::triggered, spriteEditor, &SpriteEditor::undo);
         QObject::connect(spriteEditor, &SpriteEditor::undoAvailable, this->_undoButton, &QAction::setEnabled);
         this->_undoButton->setEnabled(spriteEditor->undoIsAvailable());
@@ -1407,25 +2738,26 @@ bool NMLProject::setActiveFile(const QString &fileName){
     return true;
 }
 
-QPair<QString, int> NMLProject::fileAndLineNumber(const QString &message){
-    const QRegularExpression regex("^\\s*nmlc\\s*(?:error|warning)\\s*:\\s*\"([^\"]+)\"\\s*,\\s*line\\s*([0-9]+)", QRegularExpression::CaseInsensitiveOption);
-    const QRegularExpressionMatch match = regex.match(message);
-    QString file = "";
-    int lineNumber = 0;
-    if(match.hasMatch()){
-        file = match.captured(1).replace("\\", "/");
-        if(this->_textEditors.textEditorFromFileName(file) == nullptr){
-            file = this->_projectDir.path() + "/" + match.captured(1).replace("\\", "/");
-        }
-        if(this->_textEditors.textEditorFromFileName(file) == nullptr){
-            file = "";
-        }
-        lineNumber = match.captured(2).toInt();
+QString NMLProject::resolveFileName(const QString &file) const{
+    //The compiler writes paths either as they were passed to it or relative to the project folder
+    //Files included by a .pnml file are part of the project even if they haven't been opened yet
+    const QString absolutePath = QDir::cleanPath(this->_projectDir.absoluteFilePath(file));
+    if(file.isEmpty() || this->_textEditors.textEditorFromFileName(file) != nullptr){
+        return file;
+    }
+    else if(this->_textEditors.textEditorFromFileName(this->_projectDir.path() + "/" + file) != nullptr){
+        return this->_projectDir.path() + "/" + file;
+    }
+    else if(absolutePath == QDir::cleanPath(QFileInfo(this->_nmlFile).absoluteFilePath())){
+        return this->_nmlFile;
     }
-    return QPair<QString, int>(file, lineNumber);
+    else if(this->_includedFiles.contains(absolutePath)){
+        return absolutePath;
+    }
+    return "";
 }
 
-QPair<TextEditor*, int> NMLProject::editorAndLineNumber(const QString &message){
-    const QPair<QString, int> fileAndLineNumber = this->fileAndLineNumber(message);
-    return QPair<TextEditor*, int>(this->_textEditors.textEditorFromFileName(fileAndLineNumber.first), fileAndLineNumber.second);
+QPair<QString, int> NMLProject::fileAndLineNumber(const QString &message){
+    const QPair<QString, int> fileAndLineNumber = NMLCompiler::fileAndLineNumber(message);
+    return QPair<QString, int>(this->resolveFileName(fileAndLineNumber.first), fileAndLineNumber.second);
 }
@@ -5,6 +5,18 @@
 #include "texteditor.h"
 #include "texteditorlist.h"
 #include "spriteeditor.h"
+#include "thumbnailcache.h"
+#include "spritepalette.h"
+#include "buildpool.h"
+#include "preprocessor.h"
+#include "tablegenerator.h"
+#include "compileoverlay.h"
+#include "spritecachereader.h"
+#include "adminportclient.h"
+#include "bananaspackage.h"
+#include "benchmark.h"
+#include "compilerbenchmark.h"
+#include "costanalyzer.h"
 #include "windowwithclosesignal.hpp"
 
 class NMLProject : public MainWindow{
@@ -24,35 +36,93 @@ public:
     void addSprite(const QString &fileName, const QString &destinationName);    //fileName is the complete path of the file to import, for example "C:/sprites.png", destinationName is the name of the destination file without the extension, for example "sprites"
     bool renameSprite(const QString &oldName, const QString &newName);    //Takes the name of the file with the extension, for example "oldsprites.png" and "newsprites.png"
     bool removeSprite(const QString &fileName);    //Takes the name of the file with the extension, for example "sprites.png"
+    void spriteLoaded(const QString &fileName, const SpriteLoader::Sprite &sprite);    //Receives the sprites loaded in the background, which were imported or reloaded
 
     bool saveFile(const QString &fileName);
 
 public slots:
     bool saveAll();
+    void compile();
 
     void reloadLanguageList();
     void reloadSpriteList();
+    void reloadIncludeList();    //Only does something for .pnml projects
+    void analyzeCost();
+    void showHotSpots();
 
     void showSettingsWindow();
+    void showBuildConfigurationsWindow();
+    void showSpriteCacheWindow();
+    void showCostWindow();
+    void createPackage();
+    void showBenchmarkWindow();
+    void showBenchmarkResult(const Benchmark::Result &result);
+    void showCompilerBenchmarkWindow();
+    void showCompilerBenchmarkResult(bool cancelled);
+
+protected:
+    void changeEvent(QEvent *event) override;
 
 private:
     QString fileFromModelIndex(const QModelIndex &index) const;
     bool setActiveFile(const QString &fileName);
-
+    void addSprite(const QString &fileName, const SpriteLoader::Sprite &sprite, const QString &destinationName, bool open);    //The errors of sprites that aren't opened are reported when the sprite loader is idle
+    void showSpriteLoadingProgress(int done, int total);
+    void setSpriteItemLoading(const QString &fileName, bool loading);
+    QIcon spriteIcon(const QString &fileName);    //The thumbnail of the sprite if it's in the cache, the thumbnail is generated in the background otherwise
+    bool saveSprites();    //Saves the sprites with unsaved changes at the same time, the window is still painted but ignores user input until they're saved
+
+    void showCompilerOutput(NMLCompiler *compiler);
+    void finishBuild();
+    void pruneSpriteCache();    //Prunes the caches in _cachesToPrune if no compiler of any window is running
+    void showBuildQueue();
+    void clearDiagnostics();
+    void showBuildErrors(const QList<Preprocessor::Error> &errors);    //Shows the errors that prevented the compiler from being started, for example errors of the preprocessor
+    bool logContains(const QStandardItem *item) const;    //Returns true if the item is at the top level of the log
+    void addBuildStatistics(const BuildStatistics &statistics);
+    void showIncludedFiles();
+    QMap<QString, QString> unsavedContents() const;    //The contents of the text files with unsaved changes
+    static QByteArray fileContents(const TextEditor *editor);    //The contents of the file as they are saved
+
+    QString resolveFileName(const QString &file) const;    //Takes a file name as written by the compiler and returns the complete path of the file, or an empty string if it is not part of the project
     QPair<QString, int> fileAndLineNumber(const QString &message);
-    QPair<TextEditor*, int> editorAndLineNumber(const QString &message);
 
     const QString _nmlFile;
     const QDir _projectDir, _langDir, _gfxDir;
     QStringList _languageFiles;
     QStringList _spriteFiles;
-    QStandardItemModel _fileListModel, _logModel;
+    QStringList _includedFiles;    //The files included by a .pnml file with #include
+    Preprocessor _preprocessor;
+    TableGenerator _tableGenerator;    //Keeps the generated code of each row between builds
+    QTimer _includeListTimer;
+    CostAnalyzer _costAnalyzer;
+    QTimer _costAnalysisTimer;
+    QStandardItemModel _fileListModel, _logModel, _statisticsModel;
 
     TextEditorList _textEditors;
-    QMap<QString, SpriteEditor*> _spriteEditors;
+    QMap<QString, SpriteEditor*> _spriteEditors;    //nullptr for the sprites that weren't opened yet
+    SpriteLoader _spriteLoader;
+    QMap<QString, QString> _spriteImports;    //The destination names of the files that are imported in the background
+    QStringList _spriteLoadingErrors;    //The errors of the sprites loaded in the background, shown in a single message when all of them are loaded
+    ThumbnailCache _thumbnails;
+    bool _savingSprites;
     QString _activeFile;
-    QDockWidget _fileListDockWidget, _logDockWidget;
 
+    QMap<NMLCompiler*, QStandardItem*> _compilerLogItems;    //Contains the item in the log for each build configuration that is being compiled
+    QMap<TextEditor*, QMetaObject::Connection> _diagnosticConnections;    //Contains connections between the TextChanged signal of text editors and a lambda to remove warnings and errors in that editor
+    QElapsedTimer _buildTimer;
+    qint64 _saveTime;    //Time it took to write the unsaved changes to the CompileOverlay before the current build, in milliseconds
+    CompileOverlay *_compileOverlay;    //The copy of the project folder that is being compiled, or nullptr if the project is compiled in its own folder
+    QStringList _cachesToPrune;    //The sprite caches built since the cache was last pruned, they are kept when other caches are deleted
+    Benchmark *const _benchmark;
+    QStandardItem *_benchmarkItem;    //The item in the log showing the result of the benchmark that is running
+    CompilerBenchmark *const _compilerBenchmark;
+    QStandardItem *_compilerBenchmarkItem;
+    QList<BuildStatistics> _buildStatistics;
+    QDockWidget _fileListDockWidget, _logDockWidget, _statisticsDockWidget;
+    QLabel _buildQueueLabel;
+
+    QAction *const _compileButton;
     QAction *const _undoButton, *const _redoButton, *const _cutButton, *const _copyButton, *const _pasteButton, *const _findButton, *const _selectAllButton;
     QAction *const _toggleEditToolBar, *const _toggleImageTools;
     QToolBar *const _editToolBar;
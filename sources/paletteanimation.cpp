@@ -0,0 +1,89 @@
+#include <QObject>
+#include "paletteanimation.h"
+#include "spritepalette.h"
+
+namespace{
+    const int companyColorsStart = 0xC6;
+    const int animatedColorsStart = 0xE3;
+
+    //The first of the 8 colors of the palette that replace the company colors for each company color, in the order of PaletteAnimation::CompanyColor
+    const int companyColorRanges[PaletteAnimation::companyColorCount] = {0xC6, 0x60, 0x2A, 0x3E, 0xB3, 0x9A, 0x50, 0x58, 0x92, 0x20, 0x80, 0x88, 0xB6, 0x70, 0x04, 0x08};
+
+    //The colors of the cycles are those of the extra palette values of OpenTTD, which aren't in the palette itself
+    const QRgb fizzyDrink[5] = {qRgb(76, 24, 8), qRgb(108, 44, 24), qRgb(144, 72, 52), qRgb(176, 108, 84), qRgb(212, 148, 128)};
+    const QRgb oilRefinery[7] = {qRgb(252, 60, 0), qRgb(252, 84, 0), qRgb(252, 108, 0), qRgb(252, 124, 0), qRgb(252, 148, 0), qRgb(252, 172, 0), qRgb(252, 196, 0)};
+    const QRgb lighthouse[4] = {qRgb(240, 208, 0), qRgb(0, 0, 0), qRgb(0, 0, 0), qRgb(0, 0, 0)};
+    const QRgb darkWater[5] = {qRgb(32, 68, 112), qRgb(36, 72, 116), qRgb(40, 76, 120), qRgb(44, 80, 124), qRgb(48, 84, 128)};
+
+    //The glittery water cycles through more colors than it has in the palette, only every third color is visible at the same time
+    const QRgb glitteryWater[15] = {
+        qRgb(216, 244, 252), qRgb(172, 208, 224), qRgb(132, 172, 196), qRgb(100, 132, 168), qRgb(72, 100, 144),
+        qRgb(72, 100, 144), qRgb(72, 100, 144), qRgb(72, 100, 144), qRgb(72, 100, 144), qRgb(72, 100, 144),
+        qRgb(72, 100, 144), qRgb(72, 100, 144), qRgb(100, 132, 168), qRgb(132, 172, 196), qRgb(172, 208, 224)
+    };
+
+    //Same as OpenTTD: the position in a cycle of the given length, which goes around the cycle once each time counter * speed overflows 16 bits
+    int cyclePosition(uint counter, uint speed, int length){
+        return (quint16(counter * speed) * length) >> 16;
+    }
+
+    //Copies a cycle of colors to the color table starting at the given position in the cycle
+    void cycle(QRgb *destination, const QRgb *colors, int length, int position, int count, int step = 1){
+        for(int i = 0; i < count; i++){
+            destination[i] = colors[position];
+            position = (position + step) % length;
+        }
+    }
+
+    QRgb radioTowerLight(uint counter){
+        const int phase = counter & 0x7F;
+        return qRgb((phase < 0x3F) ? 255 : ((phase < 0x4A || phase >= 0x75) ? 128 : 20), 0, 0);
+    }
+}
+
+QVector<QRgb> PaletteAnimation::colorTable(CompanyColor companyColor){
+    QVector<QRgb> colorTable = SpritePalette::colors;
+    const int start = companyColorRanges[qBound(0, int(companyColor), companyColorCount - 1)];
+    for(int i = 0; i < 8; i++){
+        colorTable[companyColorsStart + i] = SpritePalette::colors[start + i];
+    }
+    return colorTable;
+}
+
+void PaletteAnimation::animate(QVector<QRgb> *colorTable, uint counter){
+    //The cycles are in the same order as in the palette
+    QRgb *destination = colorTable->data() + animatedColorsStart;
+    cycle(destination, fizzyDrink, 5, cyclePosition(~counter, 512, 5), 5);
+    cycle(destination + 5, oilRefinery, 7, cyclePosition(~counter, 512, 7), 7);
+    destination[12] = radioTowerLight(counter >> 1);
+    destination[13] = radioTowerLight((counter >> 1) ^ 0x40);
+    cycle(destination + 14, lighthouse, 4, cyclePosition(counter, 256, 4), 4);
+    cycle(destination + 18, darkWater, 5, cyclePosition(counter, 320, 5), 5);
+    cycle(destination + 23, glitteryWater, 15, cyclePosition(counter, 128, 15), 5, 3);
+}
+
+QString PaletteAnimation::name(CompanyColor companyColor){
+    switch(companyColor){
+        case DarkBlue: return QObject::tr("Dark blue");
+        case PaleGreen: return QObject::tr("Pale green");
+        case Pink: return QObject::tr("Pink");
+        case Yellow: return QObject::tr("Yellow");
+        case Red: return QObject::tr("Red");
+        case LightBlue: return QObject::tr("Light blue");
+        case Green: return QObject::tr("Green");
+        case DarkGreen: return QObject::tr("Dark green");
+        case Blue: return QObject::tr("Blue");
+        case Cream: return QObject::tr("Cream");
+        case Mauve: return QObject::tr("Mauve");
+        case Purple: return QObject::tr("Purple");
+        case Orange: return QObject::tr("Orange");
+        case Brown: return QObject::tr("Brown");
+        case Grey: return QObject::tr("Grey");
+        case White: return QObject::tr("White");
+    }
+    return QString();
+}
+
+QRgb PaletteAnimation::color(CompanyColor companyColor){
+    return SpritePalette::colors[companyColorRanges[qBound(0, int(companyColor), companyColorCount - 1)] + 4];
+}
@@ -0,0 +1,22 @@
+#ifndef PALETTEANIMATION_H
+#define PALETTEANIMATION_H
+
+#include <QColor>
+#include <QVector>
+
+//The colors OpenTTD changes while the game runs: the company colors are replaced by the colors of the company that owns the sprite, and the animated colors cycle
+//Only the color table changes, so previewing them costs the same whatever the size of the image
+class PaletteAnimation{
+public:
+    enum CompanyColor{DarkBlue, PaleGreen, Pink, Yellow, Red, LightBlue, Green, DarkGreen, Blue, Cream, Mauve, Purple, Orange, Brown, Grey, White};
+    static const int companyColorCount = 16;
+    static const int tickDuration = 27;    //In milliseconds, the length of a tick in OpenTTD at the normal game speed
+    static const uint counterStep = 8;    //How much the palette animation counter of OpenTTD increases each tick
+
+    static QVector<QRgb> colorTable(CompanyColor companyColor);    //The OpenTTD palette with the company colors replaced, dark blue gives the palette itself
+    static void animate(QVector<QRgb> *colorTable, uint counter);    //Replaces the animated colors by the ones they have in the game when the palette animation counter has this value
+    static QString name(CompanyColor companyColor);
+    static QRgb color(CompanyColor companyColor);    //A color in the middle of the range, to show the company color in lists
+};
+
+#endif // PALETTEANIMATION_H
@@ -0,0 +1,187 @@
+#include <QMutex>
+#include <QSettings>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include "palettequantizer.h"
+#include "spritepalette.h"
+
+namespace{
+    enum ExcludedRange{TransparentColor = 0x1, CompanyColors = 0x2, AnimatedColors = 0x4};
+
+    bool isExcluded(int index, int excludedRanges){
+        return ((excludedRanges & TransparentColor) && index == 0) ||
+               ((excludedRanges & CompanyColors) && index >= 0xC6 && index <= 0xCD) ||
+               ((excludedRanges & AnimatedColors) && index >= 0xE3 && index <= 0xFE);
+    }
+
+    int excludedRanges(const PaletteQuantizer::Options &options){
+        return (options.excludeTransparentColor ? TransparentColor : 0) | (options.excludeCompanyColors ? CompanyColors : 0) | (options.excludeAnimatedColors ? AnimatedColors : 0);
+    }
+}
+
+PaletteQuantizer::Options PaletteQuantizer::Options::fromSettings(){
+    QSettings settings("OpenTTD", "NMLCreator");
+    return {
+        settings.value("spriteEditor/excludeTransparentColor", true).toBool(),
+        settings.value("spriteEditor/excludeCompanyColors", true).toBool(),
+        settings.value("spriteEditor/excludeAnimatedColors", true).toBool(),
+        settings.value("spriteEditor/dither", false).toBool()
+    };
+}
+
+PaletteQuantizer::PaletteQuantizer(const Options &options):
+    _options(options),
+    _table(table(excludedRanges(options)))
+{
+    //If a color is several times in the palette, use an index that isn't excluded
+    const int excluded = excludedRanges(options);
+    for(int i = 0; i < SpritePalette::colors.length(); i++){
+        const QRgb color = SpritePalette::colors[i] | 0xFF000000;
+        if(!this->_exactColors.contains(color) || (isExcluded(this->_exactColors[color], excluded) && !isExcluded(i, excluded))){
+            this->_exactColors.insert(color, i);
+        }
+    }
+}
+
+QImage PaletteQuantizer::convert(const QImage &image) const{
+    if(image.isNull()){
+        return QImage();
+    }
+    const QImage source = image.convertToFormat(QImage::Format_ARGB32);
+    QImage result(source.size(), QImage::Format_Indexed8);
+    result.setColorTable(SpritePalette::colors);
+    result.setDotsPerMeterX(source.dotsPerMeterX());
+    result.setDotsPerMeterY(source.dotsPerMeterY());
+
+    //The destination is written through a pointer taken here, since calling scanLine() on the same image from several threads isn't safe
+    uchar *const bits = result.bits();
+    const int bytesPerLine = result.bytesPerLine();
+    QVector<int> bands;
+    for(int top = 0; top < source.height(); top += bandHeight){
+        bands.append(top);
+    }
+    QtConcurrent::blockingMap(bands, [this, &source, bits, bytesPerLine](int top){
+        this->convertBand(source, bits, bytesPerLine, top);
+    });
+    return result;
+}
+
+uchar PaletteQuantizer::index(QRgb color) const{
+    const quint16 entry = this->_table->constData()[key(color)];
+    if(entry & exactColor){
+        const auto exact = this->_exactColors.constFind(color | 0xFF000000);
+        if(exact != this->_exactColors.constEnd()){
+            return exact.value();
+        }
+    }
+    return entry & 0xFF;
+}
+
+QSharedPointer<const QVector<quint16>> PaletteQuantizer::table(int excludedRanges){
+    //The tables are shared by all the quantizers and only computed the first time they are needed
+    static QMutex mutex;
+    static QHash<int, QSharedPointer<const QVector<quint16>>> tables;
+    QMutexLocker locker(&mutex);
+    if(tables.contains(excludedRanges)){
+        return tables[excludedRanges];
+    }
+
+    QVector<int> allowed;
+    for(int i = 0; i < SpritePalette::colors.length(); i++){
+        if(!isExcluded(i, excludedRanges)){
+            allowed.append(i);
+        }
+    }
+    QVector<quint16> *entries = new QVector<quint16>(64 * 64 * 64, 0);
+    QVector<int> reds(64);
+    std::iota(reds.begin(), reds.end(), 0);
+    QtConcurrent::blockingMap(reds, [entries, &allowed](int red){
+        quint16 *cells = entries->data() + (red << 12);
+        const int r = (red << 2) | 2;
+        for(int green = 0; green < 64; green++){
+            const int g = (green << 2) | 2;
+            for(int blue = 0; blue < 64; blue++){
+                const int b = (blue << 2) | 2;
+                int best = allowed.isEmpty() ? 0 : allowed.first(), bestDistance = INT_MAX;
+                for(const int i: allowed){
+                    const QRgb color = SpritePalette::colors[i];
+                    const int dr = qRed(color) - r, dg = qGreen(color) - g, db = qBlue(color) - b;
+                    const int distance = dr * dr + dg * dg + db * db;
+                    if(distance < bestDistance){
+                        best = i;
+                        bestDistance = distance;
+                    }
+                }
+                cells[(green << 6) | blue] = best;
+            }
+        }
+    });
+    for(const QRgb color: SpritePalette::colors){
+        (*entries)[key(color)] |= exactColor;
+    }
+
+    const QSharedPointer<const QVector<quint16>> table(entries);
+    tables.insert(excludedRanges, table);
+    return table;
+}
+
+int PaletteQuantizer::key(QRgb color){
+    return ((color >> 6) & 0x3F000) | ((color >> 4) & 0xFC0) | ((color >> 2) & 0x3F);
+}
+
+void PaletteQuantizer::convertBand(const QImage &source, uchar *destination, int bytesPerLine, int top) const{
+    const int width = source.width(), bottom = qMin(top + bandHeight, source.height());
+    if(!this->_options.dither){
+        for(int y = top; y < bottom; y++){
+            const QRgb *input = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+            uchar *output = destination + y * bytesPerLine;
+
+            //Sprites mostly consist of runs of the same color, so the index of the previous pixel is reused
+            QRgb previous = ~input[0];
+            uchar previousIndex = 0;
+            for(int x = 0; x < width; x++){
+                const QRgb pixel = input[x];
+                if(pixel != previous){
+                    previous = pixel;
+                    previousIndex = (qAlpha(pixel) < 128) ? 0 : this->index(pixel);
+                }
+                output[x] = previousIndex;
+            }
+        }
+        return;
+    }
+
+    //Floyd-Steinberg: the error of each pixel is spread to the pixels right and below it, the error rows have one extra pixel on each side so that the edges don't need special cases
+    //The errors are stored in sixteenths, in the order red, green, blue
+    QVector<int> currentErrors(3 * (width + 2), 0), nextErrors(3 * (width + 2), 0);
+    for(int y = top; y < bottom; y++){
+        const QRgb *input = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+        uchar *output = destination + y * bytesPerLine;
+        int *current = currentErrors.data() + 3, *next = nextErrors.data() + 3;
+        for(int x = 0; x < width; x++){
+            const QRgb pixel = input[x];
+            if(qAlpha(pixel) < 128){
+                output[x] = 0;
+                continue;
+            }
+            const int r = qBound(0, qRed(pixel) + current[3 * x] / 16, 255);
+            const int g = qBound(0, qGreen(pixel) + current[3 * x + 1] / 16, 255);
+            const int b = qBound(0, qBlue(pixel) + current[3 * x + 2] / 16, 255);
+            const uchar index = this->index(qRgb(r, g, b));
+            output[x] = index;
+
+            const QRgb color = SpritePalette::colors[index];
+            const int errors[3] = {r - qRed(color), g - qGreen(color), b - qBlue(color)};
+            for(int channel = 0; channel < 3; channel++){
+                current[3 * (x + 1) + channel] += errors[channel] * 7;
+                next[3 * (x - 1) + channel] += errors[channel] * 3;
+                next[3 * x + channel] += errors[channel] * 5;
+                next[3 * (x + 1) + channel] += errors[channel];
+            }
+        }
+        currentErrors.swap(nextErrors);
+        std::fill(nextErrors.begin(), nextErrors.end(), 0);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef PALETTEQUANTIZER_H
+#define PALETTEQUANTIZER_H
+
+#include <QHash>
+#include <QImage>
+#include <QSharedPointer>
+#include <QVector>
+
+//Converts images to the OpenTTD palette with a lookup table instead of searching the nearest of the 256 colors for each pixel
+//The table has one entry per color with 6 bits per channel, which contains the nearest allowed color of the palette, so colors that only differ in the lowest 2 bits of each channel get the same index
+//Colors that are exactly in the palette always keep their index, even if they are in an excluded range, since they were most likely chosen on purpose
+class PaletteQuantizer{
+public:
+    struct Options{
+        bool excludeTransparentColor;    //Index 0, the blue that is transparent in OpenTTD
+        bool excludeCompanyColors;    //0xC6 to 0xCD, which are replaced by the company colors of the player
+        bool excludeAnimatedColors;    //0xE3 to 0xFE, which are animated in the game
+        bool dither;    //Floyd-Steinberg error diffusion, which looks better for photos and renders with smooth gradients
+
+        static Options fromSettings();
+    };
+
+    PaletteQuantizer(const Options &options);
+
+    QImage convert(const QImage &image) const;    //Returns an 8-bit image using the OpenTTD palette, pixels that are more than half transparent become index 0
+    uchar index(QRgb color) const;    //Returns the index of an opaque color
+
+    static const int bandHeight = 64;    //The rows of an image are converted in bands of this height in parallel, dithering doesn't carry errors between bands so that the result doesn't depend on the number of threads
+
+private:
+    static QSharedPointer<const QVector<quint16>> table(int excludedRanges);
+    static int key(QRgb color);
+
+    void convertBand(const QImage &source, uchar *destination, int bytesPerLine, int top) const;
+
+    const Options _options;
+    QSharedPointer<const QVector<quint16>> _table;    //The low 8 bits are the index, exactColor is set if a color of the palette falls in the cell
+    QHash<QRgb, uchar> _exactColors;
+
+    static const quint16 exactColor = 0x100;
+};
+
+#endif // PALETTEQUANTIZER_H
@@ -0,0 +1,704 @@
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <functional>
+#include "preprocessor.h"
+
+//Evaluates the expression of an #if or #elif directive once defined() and the macros have been replaced
+class ExpressionParser{
+public:
+    ExpressionParser(const QString &expression):
+        _position(0),
+        _ok(true)
+    {
+        static const QRegularExpression token("\\s*(0[xX][0-9a-fA-F]+[uUlL]*|[0-9]+[uUlL]*|[A-Za-z_][A-Za-z0-9_]*|'(?:\\\\.|[^'\\\\])'|<<|>>|<=|>=|==|!=|&&|\\|\\||\\S)");
+        QRegularExpressionMatchIterator i = token.globalMatch(expression);
+        while(i.hasNext()){
+            this->_tokens.append(i.next().captured(1));
+        }
+    }
+
+    qint64 parse(bool *ok){
+        const qint64 value = this->conditional();
+        *ok = this->_ok && this->_position == this->_tokens.length();
+        return value;
+    }
+
+private:
+    QString peek() const{
+        return (this->_position < this->_tokens.length()) ? this->_tokens[this->_position] : "";
+    }
+
+    QString next(){
+        return (this->_position < this->_tokens.length()) ? this->_tokens[this->_position++] : "";
+    }
+
+    static int precedence(const QString &op){
+        static const QHash<QString, int> precedences = {
+            {"||", 1}, {"&&", 2}, {"|", 3}, {"^", 4}, {"&", 5}, {"==", 6}, {"!=", 6}, {"<", 7}, {">", 7}, {"<=", 7}, {">=", 7},
+            {"<<", 8}, {">>", 8}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10}
+        };
+        return precedences.value(op, 0);
+    }
+
+    qint64 conditional(){
+        const qint64 condition = this->binary(1);
+        if(this->peek() != "?"){
+            return condition;
+        }
+        this->next();
+        const qint64 ifTrue = this->conditional();
+        if(this->next() != ":"){
+            this->_ok = false;
+        }
+        const qint64 ifFalse = this->conditional();
+        return condition ? ifTrue : ifFalse;
+    }
+
+    qint64 binary(int minimumPrecedence){
+        qint64 left = this->unary();
+        while(precedence(this->peek()) >= minimumPrecedence){
+            const QString op = this->next();
+            const qint64 right = this->binary(precedence(op) + 1);
+            if(((op == "/" || op == "%") && right == 0) || ((op == "<<" || op == ">>") && (right < 0 || right > 63))){
+                this->_ok = false;    //Undefined in C++, so it can't be evaluated
+                return 0;
+            }
+            left = (op == "||") ? (left || right) : (op == "&&") ? (left && right) : (op == "|") ? (left | right) : (op == "^") ? (left ^ right) : (op == "&") ? (left & right) :
+                   (op == "==") ? (left == right) : (op == "!=") ? (left != right) : (op == "<") ? (left < right) : (op == ">") ? (left > right) : (op == "<=") ? (left <= right) : (op == ">=") ? (left >= right) :
+                   (op == "<<") ? (left << right) : (op == ">>") ? (left >> right) : (op == "+") ? (left + right) : (op == "-") ? (left - right) : (op == "*") ? (left * right) : (op == "/") ? (left / right) : (left % right);
+        }
+        return left;
+    }
+
+    qint64 unary(){
+        const QString token = this->next();
+        if(token == "!"){
+            return !this->unary();
+        }
+        else if(token == "-"){
+            return -this->unary();
+        }
+        else if(token == "+"){
+            return this->unary();
+        }
+        else if(token == "~"){
+            return ~this->unary();
+        }
+        else if(token == "("){
+            const qint64 value = this->conditional();
+            if(this->next() != ")"){
+                this->_ok = false;
+            }
+            return value;
+        }
+        else if(token.startsWith('\'')){
+            return (token[1] != '\\') ? token[1].unicode() : (token[2] == 'n') ? '\n' : (token[2] == 't') ? '\t' : (token[2] == '0') ? 0 : token[2].unicode();
+        }
+        else if(!token.isEmpty() && (token[0].isLetter() || token[0] == '_')){
+            return 0;    //Like in the C preprocessor, identifiers that aren't macros are 0
+        }
+        bool ok = false;
+        const qint64 value = QString(token).remove(QRegularExpression("[uUlL]+$")).toLongLong(&ok, 0);
+        this->_ok &= ok;
+        return value;
+    }
+
+    QStringList _tokens;
+    int _position;
+    bool _ok;
+};
+
+QString Preprocessor::Error::toString() const{
+    return "pnml error: \"" + this->file + "\", line " + QString::number(this->line) + ": " + this->text;
+}
+
+Preprocessor::Preprocessor(const QString &mainFile):
+    _mainFile(QDir::cleanPath(QFileInfo(mainFile).absoluteFilePath()))
+{}
+
+QString Preprocessor::preprocess(){
+    this->_errors.clear();
+    this->_includes.clear();
+    const Result result = this->expandFile(this->_mainFile, Macros(), QStringList());
+
+    //Forget about the files that aren't included anymore
+    const QStringList files = this->includedFiles() + QStringList(this->_mainFile);
+    const QStringList cachedFiles = this->_cache.keys();
+    for(const QString &file: cachedFiles){
+        if(!files.contains(file)){
+            this->_cache.remove(file);
+        }
+    }
+    return result.text;
+}
+
+bool Preprocessor::preprocessToFile(const QString &outputFile){
+    const QString text = this->preprocess();
+    if(!this->_errors.isEmpty()){
+        return false;
+    }
+
+    QDir(QFileInfo(outputFile).path()).mkpath(".");
+    QSaveFile file(outputFile);
+    if(!file.open(QFile::WriteOnly) || file.write(text.toUtf8()) < 0 || !file.commit()){
+        this->_errors.append({outputFile, 0, QObject::tr("You do not have permission to create the file %1.").arg(outputFile)});
+        return false;
+    }
+    return true;
+}
+
+QList<Preprocessor::Error> Preprocessor::errors() const{
+    return this->_errors;
+}
+
+QStringList Preprocessor::includedFiles() const{
+    QStringList files;
+    const std::function<void(const QString&)> visit = [&](const QString &file){
+        for(const QString &includedFile: this->_includes.value(file)){
+            if(includedFile != this->_mainFile && !files.contains(includedFile)){
+                files.append(includedFile);
+                visit(includedFile);
+            }
+        }
+    };
+    visit(this->_mainFile);
+    return files;
+}
+
+QStringList Preprocessor::includes(const QString &file) const{
+    return this->_includes.value(QDir::cleanPath(QFileInfo(file).absoluteFilePath()));
+}
+
+void Preprocessor::setUnsavedContents(const QMap<QString, QString> &contents){
+    this->_unsavedContents.clear();
+    for(auto i = contents.constBegin(); i != contents.constEnd(); i++){
+        this->_unsavedContents.insert(QDir::cleanPath(QFileInfo(i.key()).absoluteFilePath()), i.value());
+    }
+}
+
+bool Preprocessor::isPreprocessed(const QString &nmlFile){
+    return QFileInfo(nmlFile).suffix().toLower() == "pnml";
+}
+
+QString Preprocessor::outputFile(const QString &nmlFile){
+    return QFileInfo(nmlFile).dir().path() + "/.nmlcreator/" + QFileInfo(nmlFile).completeBaseName() + ".nml";
+}
+
+Preprocessor::Result Preprocessor::expandFile(const QString &file, const Macros &macros, const QStringList &stack){
+    QString content;
+    if(!this->readFile(file, &content)){
+        this->_errors.append({file, 0, QObject::tr("Could not open file %1.").arg(file)});
+        return {"", macros, hash(macros)};
+    }
+    const QByteArray contentHash = QCryptographicHash::hash(content.toUtf8(), QCryptographicHash::Md5);
+    const QByteArray macrosHash = hash(macros);
+
+    //Forget the expansions of older versions of the file
+    QHash<QByteArray, Expansion> &expansions = this->_cache[file];
+    for(auto i = expansions.begin(); i != expansions.end();){
+        i = (i->contentHash != contentHash) ? expansions.erase(i) : i + 1;
+    }
+
+    //If neither the file nor the macros defined before it changed, only the files it includes need to be expanded again
+    //Its own text can be reused as long as the included files still define the same macros
+    if(expansions.contains(macrosHash)){
+        const Expansion expansion = expansions[macrosHash];    //Copy it, expanding the included files modifies the cache
+        const int errorCount = this->_errors.length();
+        QString text = expansion.segments[0];
+        bool valid = true;
+        for(int i = 0; i < expansion.includes.length() && valid; i++){
+            const Result included = this->expandFile(expansion.includes[i].file, expansion.includes[i].macros, stack + QStringList(file));
+            valid = (included.macrosHash == expansion.includes[i].resultHash);
+            text += included.text + expansion.segments[i + 1];
+        }
+        if(valid){
+            QStringList includes;
+            for(const Include &include: expansion.includes){
+                includes.append(include.file);
+            }
+            this->_includes.insert(file, includes);
+            this->_errors.append(expansion.errors);
+            return {text, expansion.macros, expansion.macrosHash};
+        }
+        this->_errors.erase(this->_errors.begin() + errorCount, this->_errors.end());
+    }
+
+    QString text;
+    Expansion expansion = this->expandContent(file, content, macros, stack, &text);
+    expansion.contentHash = contentHash;
+    QStringList includes;
+    for(const Include &include: qAsConst(expansion.includes)){
+        includes.append(include.file);
+    }
+    this->_includes.insert(file, includes);
+    this->_errors.append(expansion.errors);
+    this->_cache[file].insert(macrosHash, expansion);
+    return {text, expansion.macros, expansion.macrosHash};
+}
+
+Preprocessor::Expansion Preprocessor::expandContent(const QString &file, const QString &content, const Macros &macros, const QStringList &stack, QString *text){
+    Expansion expansion;
+    Macros currentMacros = macros;
+    QString segment = this->lineMarker(1, file);
+    QList<Condition> conditions;
+    bool inComment = false;
+    const auto addError = [&](int line, const QString &error){
+        expansion.errors.append({file, line, error});
+    };
+
+    const QStringList lines = content.split('\n');
+    for(int i = 0; i < lines.length(); i++){
+        const int lineNumber = i + 1;
+        const bool active = conditions.isEmpty() || conditions.last().active;
+        QString line = lines[i];
+
+        //Directives, directives are always handled even in branches that aren't taken in order to find the matching #endif
+        if(!inComment && line.trimmed().startsWith('#')){
+            int lastLine = i;
+            while(line.endsWith('\\') && lastLine + 1 < lines.length()){
+                line.chop(1);
+                line += lines[++lastLine];
+            }
+            const int lineCount = lastLine - i + 1;
+            i = lastLine;
+
+            const QString directive = stripComments(line.trimmed().mid(1), &inComment).trimmed();
+            const int nameLength = directive.indexOf(QRegularExpression("[^A-Za-z0-9_]"));
+            const QString name = directive.left(nameLength);
+            const QString argument = (nameLength < 0) ? "" : directive.mid(nameLength).trimmed();
+            const QString firstWord = argument.section(QRegularExpression("\\s+"), 0, 0);
+
+            if(name == "if" || name == "ifdef" || name == "ifndef"){
+                bool value = false;
+                if(active && name == "if"){
+                    bool ok = true;
+                    value = evaluate(argument, currentMacros, &ok);
+                    if(!ok){
+                        addError(lineNumber, QObject::tr("Invalid expression in #if: %1").arg(argument));
+                    }
+                }
+                else if(active){
+                    value = (currentMacros.contains(firstWord) == (name == "ifdef"));
+                    if(firstWord.isEmpty()){
+                        addError(lineNumber, QObject::tr("Expected a macro name after #%1.").arg(name));
+                    }
+                }
+                conditions.append({active && value, !active || value, false, lineNumber});
+            }
+            else if(name == "elif" || name == "else"){
+                if(conditions.isEmpty() || conditions.last().elseSeen){
+                    addError(lineNumber, QObject::tr("#%1 without #if.").arg(name));
+                }
+                else{
+                    Condition &condition = conditions.last();
+                    bool value = true;
+                    if(!condition.taken && name == "elif"){
+                        bool ok = true;
+                        value = evaluate(argument, currentMacros, &ok);
+                        if(!ok){
+                            addError(lineNumber, QObject::tr("Invalid expression in #elif: %1").arg(argument));
+                        }
+                    }
+                    condition.active = !condition.taken && value;
+                    condition.taken |= condition.active;
+                    condition.elseSeen = (name == "else");
+                }
+            }
+            else if(name == "endif"){
+                if(conditions.isEmpty()){
+                    addError(lineNumber, QObject::tr("#endif without #if."));
+                }
+                else{
+                    conditions.removeLast();
+                }
+            }
+            else if(!active || name.isEmpty()){
+                //Other directives don't do anything in branches that aren't taken, and neither does a # alone
+            }
+            else if(name == "define"){
+                static const QRegularExpression defineRegex("^([A-Za-z_][A-Za-z0-9_]*)(\\(([^)]*)\\))?(.*)$", QRegularExpression::DotMatchesEverythingOption);
+                const QRegularExpressionMatch match = defineRegex.match(argument);
+                if(!match.hasMatch()){
+                    addError(lineNumber, QObject::tr("Invalid macro name in #define."));
+                }
+                else{
+                    Macro macro;
+                    macro.functionLike = !match.captured(2).isEmpty();
+                    for(const QString &parameter: match.captured(3).split(',', Qt::SkipEmptyParts)){
+                        macro.parameters.append(parameter.trimmed());
+                    }
+                    macro.body = match.captured(4).trimmed();
+                    currentMacros.insert(match.captured(1), macro);
+                }
+            }
+            else if(name == "undef"){
+                currentMacros.remove(firstWord);
+            }
+            else if(name == "include"){
+                static const QRegularExpression includeRegex("^(?:\"([^\"]+)\"|<([^>]+)>)");
+                const QRegularExpressionMatch match = includeRegex.match(argument);
+                const QString includedName = match.captured(1) + match.captured(2);
+                const QString includedFile = match.hasMatch() ? this->resolveInclude(includedName, file) : "";
+                if(!match.hasMatch()){
+                    addError(lineNumber, QObject::tr("Expected a file name after #include."));
+                }
+                else if(includedFile.isEmpty()){
+                    addError(lineNumber, QObject::tr("Could not find file %1.").arg(includedName));
+                }
+                else if(includedFile == file || stack.contains(includedFile)){
+                    addError(lineNumber, QObject::tr("The file %1 includes itself.").arg(includedName));
+                }
+                else if(!currentMacros.contains("#once " + includedFile)){
+                    expansion.segments.append(segment);
+                    text->append(segment);
+                    const Result included = this->expandFile(includedFile, currentMacros, stack + QStringList(file));
+                    text->append(included.text);
+                    expansion.includes.append({includedFile, currentMacros, included.macrosHash});
+                    currentMacros = included.macros;
+                    segment = this->lineMarker(lastLine + 2, file);
+                    continue;
+                }
+            }
+            else if(name == "pragma"){
+                //#pragma once is stored like a macro that can't be written in a file, so that it's part of the macros used to cache the expansions
+                if(firstWord == "once"){
+                    currentMacros.insert("#once " + file, Macro{false, {}, ""});
+                }
+            }
+            else if(name == "error"){
+                addError(lineNumber, argument);
+            }
+            else if(name != "line" && name != "warning"){
+                addError(lineNumber, QObject::tr("Unknown directive #%1.").arg(name));
+            }
+            segment += QString(lineCount, '\n');    //Keep the line numbers of the following lines
+            continue;
+        }
+
+        if(!active){
+            stripComments(line, &inComment);    //Only to know whether the next line is in a comment
+            segment += '\n';
+            continue;
+        }
+
+        //If the arguments of a macro continue on the next lines, expand all of these lines at once
+        const bool commentBefore = inComment;
+        bool incomplete = false;
+        QString expanded = expandMacros(line, currentMacros, QSet<QString>(), &inComment, &incomplete);
+        int lastLine = i;
+        while(incomplete && lastLine + 1 < lines.length() && !lines[lastLine + 1].trimmed().startsWith('#')){
+            line += "\n" + lines[++lastLine];
+            inComment = commentBefore;
+            incomplete = false;
+            expanded = expandMacros(line, currentMacros, QSet<QString>(), &inComment, &incomplete);
+        }
+        if(incomplete){
+            addError(lineNumber, QObject::tr("Unterminated argument list."));
+        }
+        segment += expanded + "\n";
+        if(lastLine > i){
+            segment += this->lineMarker(lastLine + 2, file);
+            i = lastLine;
+        }
+    }
+    for(const Condition &condition: qAsConst(conditions)){
+        addError(condition.line, QObject::tr("#if without #endif."));
+    }
+
+    expansion.segments.append(segment);
+    text->append(segment);
+    expansion.macros = currentMacros;
+    expansion.macrosHash = hash(currentMacros);
+    return expansion;
+}
+
+bool Preprocessor::readFile(const QString &file, QString *content) const{
+    if(this->_unsavedContents.contains(file)){
+        *content = this->_unsavedContents[file];
+    }
+    else{
+        QFile f(file);
+        if(!f.open(QFile::ReadOnly)){
+            return false;
+        }
+        *content = QString::fromUtf8(f.readAll());
+    }
+    content->replace("\r\n", "\n");
+    return true;
+}
+
+QString Preprocessor::resolveInclude(const QString &name, const QString &includingFile) const{
+    //Like the C preprocessor, look next to the file containing the #include first, then in the project folder
+    const QStringList candidates = {QFileInfo(includingFile).dir().absoluteFilePath(name), QFileInfo(this->_mainFile).dir().absoluteFilePath(name)};
+    for(const QString &candidate: candidates){
+        if(this->_unsavedContents.contains(QDir::cleanPath(candidate)) || QFileInfo(candidate).isFile()){
+            return QDir::cleanPath(candidate);
+        }
+    }
+    return "";
+}
+
+QString Preprocessor::lineMarker(int line, const QString &file) const{
+    return "# " + QString::number(line) + " \"" + QFileInfo(this->_mainFile).dir().relativeFilePath(file) + "\"\n";
+}
+
+QString Preprocessor::expandMacros(const QString &text, const Macros &macros, const QSet<QString> &disabled, bool *inComment, bool *incomplete){
+    QString result;
+    result.reserve(text.length());
+    int i = 0;
+    while(i < text.length()){
+        const QChar c = text[i];
+        const QChar next = (i + 1 < text.length()) ? text[i + 1] : QChar();
+
+        //Comments and strings are copied as they are
+        if(*inComment){
+            const int end = text.indexOf("*/", i);
+            if(end < 0){
+                result += text.midRef(i);
+                break;
+            }
+            result += text.midRef(i, end + 2 - i);
+            i = end + 2;
+            *inComment = false;
+        }
+        else if(c == '/' && next == '/'){
+            const int end = (text.indexOf('\n', i) < 0) ? text.length() : text.indexOf('\n', i);
+            result += text.midRef(i, end - i);
+            i = end;
+        }
+        else if(c == '/' && next == '*'){
+            result += "/*";
+            i += 2;
+            *inComment = true;
+        }
+        else if(c == '"'){
+            int end = i + 1;
+            while(end < text.length() && text[end] != '"' && text[end] != '\n'){
+                end += (text[end] == '\\') ? 2 : 1;
+            }
+            end = qMin(end + 1, text.length());
+            result += text.midRef(i, end - i);
+            i = end;
+        }
+        else if(c.isDigit()){
+            int end = i + 1;
+            while(end < text.length() && (text[end].isLetterOrNumber() || text[end] == '_' || text[end] == '.')){
+                end++;
+            }
+            result += text.midRef(i, end - i);
+            i = end;
+        }
+        else if(c.isLetter() || c == '_'){
+            int end = i + 1;
+            while(end < text.length() && (text[end].isLetterOrNumber() || text[end] == '_')){
+                end++;
+            }
+            const QString name = text.mid(i, end - i);
+            const Macros::const_iterator macro = macros.constFind(name);
+            if(macro == macros.constEnd() || disabled.contains(name)){
+                result += name;
+                i = end;
+                continue;
+            }
+
+            //A macro isn't expanded again inside its own expansion
+            QSet<QString> nowDisabled = disabled;
+            nowDisabled.insert(name);
+            bool commentInBody = false;
+            if(!macro->functionLike){
+                result += expandMacros(macro->body, macros, nowDisabled, &commentInBody);
+                i = end;
+                continue;
+            }
+
+            int open = end;
+            while(open < text.length() && text[open].isSpace()){
+                open++;
+            }
+            if(open >= text.length() || text[open] != '('){
+                result += name;    //The name of a function-like macro without arguments is left as it is
+                i = end;
+                continue;
+            }
+            QStringList arguments;
+            const int close = parseArguments(text, open, &arguments);
+            if(close < 0){
+                if(incomplete != nullptr){
+                    *incomplete = true;
+                }
+                result += text.midRef(i);
+                break;
+            }
+            result += expandMacros(substituteArguments(*macro, arguments, macros, disabled), macros, nowDisabled, &commentInBody);
+            i = close;
+        }
+        else{
+            result += c;
+            i++;
+        }
+    }
+    return result;
+}
+
+QString Preprocessor::substituteArguments(const Macro &macro, const QStringList &arguments, const Macros &macros, const QSet<QString> &disabled){
+    QStringList parameters = macro.parameters;
+    QStringList values = arguments;
+    if(parameters.isEmpty() && values.length() == 1 && values[0].trimmed().isEmpty()){
+        values.clear();    //MACRO() has no arguments rather than one empty argument
+    }
+    if(!parameters.isEmpty() && parameters.last() == "..."){
+        const int fixedParameters = parameters.length() - 1;
+        parameters.last() = "__VA_ARGS__";
+        const QString variadicArguments = values.mid(fixedParameters).join(",");
+        values = values.mid(0, fixedParameters);
+        values.append(variadicArguments);
+    }
+    while(values.length() < parameters.length()){
+        values.append("");
+    }
+
+    //Split the body into tokens so that only complete identifiers are replaced
+    static const QRegularExpression tokenRegex("[A-Za-z_][A-Za-z0-9_]*|##|\"(?:\\\\.|[^\"\\\\])*\"|\\s+|.", QRegularExpression::DotMatchesEverythingOption);
+    QStringList tokens;
+    QRegularExpressionMatchIterator iterator = tokenRegex.globalMatch(macro.body);
+    while(iterator.hasNext()){
+        tokens.append(iterator.next().captured());
+    }
+    const auto neighbour = [&tokens](int i, int direction){
+        for(int j = i + direction; j >= 0 && j < tokens.length(); j += direction){
+            if(!tokens[j].trimmed().isEmpty()){
+                return j;
+            }
+        }
+        return -1;
+    };
+
+    QString result;
+    for(int i = 0; i < tokens.length(); i++){
+        const QString &token = tokens[i];
+        const int previous = neighbour(i, -1);
+        const int next = neighbour(i, 1);
+        const int parameter = parameters.indexOf(token);
+        if(token == "#" && next >= 0 && parameters.contains(tokens[next])){
+            //#parameter is replaced by the argument as a string
+            result += "\"" + QString(values[parameters.indexOf(tokens[next])].trimmed()).replace("\\", "\\\\").replace("\"", "\\\"") + "\"";
+            i = next;
+        }
+        else if(parameter >= 0 && ((previous >= 0 && tokens[previous] == "##") || (next >= 0 && tokens[next] == "##"))){
+            result += values[parameter].trimmed();    //Arguments next to ## are pasted without expanding them
+        }
+        else if(parameter >= 0){
+            bool inComment = false;
+            result += expandMacros(values[parameter], macros, disabled, &inComment);
+        }
+        else if(token == "##"){
+            while(!result.isEmpty() && result.back().isSpace()){
+                result.chop(1);
+            }
+            i = (next >= 0) ? next - 1 : tokens.length();
+        }
+        else{
+            result += token;
+        }
+    }
+    return result;
+}
+
+int Preprocessor::parseArguments(const QString &text, int start, QStringList *arguments){
+    int depth = 0;
+    QString argument;
+    for(int i = start; i < text.length(); i++){
+        const QChar c = text[i];
+        if(c == '"'){
+            int end = i + 1;
+            while(end < text.length() && text[end] != '"'){
+                end += (text[end] == '\\') ? 2 : 1;
+            }
+            argument += text.midRef(i, qMin(end + 1, text.length()) - i);
+            i = end;
+            continue;
+        }
+        else if(c == '(' && depth++ == 0){
+            continue;
+        }
+        else if(c == ')' && --depth == 0){
+            arguments->append(argument);
+            return i + 1;
+        }
+        else if(c == ',' && depth == 1){
+            arguments->append(argument);
+            argument.clear();
+            continue;
+        }
+        argument += c;
+    }
+    return -1;
+}
+
+QString Preprocessor::stripComments(const QString &text, bool *inComment){
+    QString result;
+    int i = 0;
+    while(i < text.length()){
+        if(*inComment){
+            const int end = text.indexOf("*/", i);
+            if(end < 0){
+                break;
+            }
+            i = end + 2;
+            *inComment = false;
+            result += ' ';
+        }
+        else if(text.midRef(i, 2) == QLatin1String("//")){
+            break;
+        }
+        else if(text.midRef(i, 2) == QLatin1String("/*")){
+            i += 2;
+            *inComment = true;
+        }
+        else if(text[i] == '"'){
+            int end = i + 1;
+            while(end < text.length() && text[end] != '"'){
+                end += (text[end] == '\\') ? 2 : 1;
+            }
+            end = qMin(end + 1, text.length());
+            result += text.midRef(i, end - i);
+            i = end;
+        }
+        else{
+            result += text[i++];
+        }
+    }
+    return result;
+}
+
+bool Preprocessor::evaluate(const QString &expression, const Macros &macros, bool *ok){
+    //Replace defined(MACRO) before expanding the macros, otherwise MACRO itself would be expanded
+    static const QRegularExpression definedRegex("\\bdefined\\s*(?:\\(\\s*([A-Za-z_][A-Za-z0-9_]*)\\s*\\)|([A-Za-z_][A-Za-z0-9_]*))");
+    QString replaced;
+    int last = 0;
+    QRegularExpressionMatchIterator iterator = definedRegex.globalMatch(expression);
+    while(iterator.hasNext()){
+        const QRegularExpressionMatch match = iterator.next();
+        replaced += expression.midRef(last, match.capturedStart() - last);
+        replaced += macros.contains(match.captured(1) + match.captured(2)) ? " 1 " : " 0 ";
+        last = match.capturedEnd();
+    }
+    replaced += expression.midRef(last);
+
+    bool inComment = false;
+    ExpressionParser parser(expandMacros(replaced, macros, QSet<QString>(), &inComment));
+    return parser.parse(ok) != 0;
+}
+
+QByteArray Preprocessor::hash(const Macros &macros){
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for(Macros::const_iterator i = macros.constBegin(); i != macros.constEnd(); i++){
+        hash.addData((i.key() + (i->functionLike ? "(" + i->parameters.join(',') + ")" : QString()) + " " + i->body + "\n").toUtf8());
+    }
+    return hash.result();
+}
@@ -0,0 +1,88 @@
+#ifndef PREPROCESSOR_H
+#define PREPROCESSOR_H
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+//Expands the #include, #define and #if directives of .pnml files without running an external C preprocessor
+//The expanded text contains "# <line> "<file>"" line markers, which make the NML compiler report errors at their position in the original files
+class Preprocessor{
+public:
+    struct Error{
+        QString file;
+        int line;
+        QString text;
+
+        QString toString() const;    //Returns the error in the same format as the messages of the compiler, for example 'pnml error: "MyProject.pnml", line 3: Could not find file a.pnml.'
+    };
+
+    Preprocessor(const QString &mainFile);
+
+    QString preprocess();    //Returns the expanded main file, files that didn't change since the last call are not expanded again
+    bool preprocessToFile(const QString &outputFile);    //Returns false if there were errors or if the file couldn't be written
+    QList<Error> errors() const;    //The errors of the last call to preprocess()
+
+    QStringList includedFiles() const;    //Returns every file included by the main file directly or indirectly, in the order they are first included
+    QStringList includes(const QString &file) const;    //Returns the files directly included by the file
+    void setUnsavedContents(const QMap<QString, QString> &contents);    //Files in this map are read from the map instead of from the disk, for example files with unsaved changes
+
+    static bool isPreprocessed(const QString &nmlFile);    //Returns true if the file needs to be preprocessed before compiling, i.e. if it is a .pnml file
+    static QString outputFile(const QString &nmlFile);    //Returns the file that the expanded text is written to before compiling, for example "C:/MyProject/.nmlcreator/MyProject.nml"
+
+private:
+    struct Macro{
+        bool functionLike;
+        QStringList parameters;
+        QString body;
+    };
+    typedef QMap<QString, Macro> Macros;
+
+    //The expansion of a file without the files it includes, so that only the files that changed need to be expanded again
+    struct Include{
+        QString file;
+        Macros macros;    //The macros defined before the file is included
+        QByteArray resultHash;    //The hash of the macros defined after the file is included
+    };
+    struct Expansion{
+        QByteArray contentHash;
+        QStringList segments;    //The expanded text between the includes, there is one more segment than there are includes
+        QList<Include> includes;
+        Macros macros;    //The macros defined at the end of the file
+        QByteArray macrosHash;
+        QList<Error> errors;
+    };
+    struct Result{
+        QString text;
+        Macros macros;
+        QByteArray macrosHash;
+    };
+    struct Condition{
+        bool active;
+        bool taken;    //True if one of the branches was already taken, so that the next #elif and #else are skipped
+        bool elseSeen;
+        int line;
+    };
+
+    Result expandFile(const QString &file, const Macros &macros, const QStringList &stack);
+    Expansion expandContent(const QString &file, const QString &content, const Macros &macros, const QStringList &stack, QString *text);
+    bool readFile(const QString &file, QString *content) const;
+    QString resolveInclude(const QString &name, const QString &includingFile) const;
+    QString lineMarker(int line, const QString &file) const;
+
+    static QString expandMacros(const QString &text, const Macros &macros, const QSet<QString> &disabled, bool *inComment, bool *incomplete = nullptr);
+    static QString substituteArguments(const Macro &macro, const QStringList &arguments, const Macros &macros, const QSet<QString> &disabled);
+    static int parseArguments(const QString &text, int start, QStringList *arguments);    //Returns the position after the closing parenthesis, or -1 if there is none
+    static QString stripComments(const QString &text, bool *inComment);
+    static bool evaluate(const QString &expression, const Macros &macros, bool *ok);
+    static QByteArray hash(const Macros &macros);
+
+    const QString _mainFile;
+    QHash<QString, QHash<QByteArray, Expansion>> _cache;    //The expansions of each file, for each set of macros it was included with
+    QHash<QString, QStringList> _includes;
+    QMap<QString, QString> _unsavedContents;
+    QList<Error> _errors;
+};
+
+#endif // PREPROCESSOR_H
@@ -0,0 +1,107 @@
+#include <QFile>
+#include <QRegularExpression>
+#include "processsampler.h"
+
+#ifdef Q_OS_LINUX
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+ProcessSampler::ProcessSampler(int interval, QObject *parent):
+    QObject(parent),
+    _pid(0),
+    _peakMemory(-1),
+    _cpuTime(-1),
+    _childrenCpuTime(-1),
+    _alone(false)
+{
+    this->_timer.setInterval(interval);
+    QObject::connect(&this->_timer, &QTimer::timeout, this, &ProcessSampler::sample);
+}
+
+ProcessSampler::~ProcessSampler(){
+    running().removeOne(this);
+}
+
+void ProcessSampler::start(qint64 pid){
+    this->_pid = pid;
+    this->_peakMemory = -1;
+    this->_cpuTime = -1;
+    if(isSupported() && pid > 0){
+        //The children reaped while another sampled process runs would be counted for both, so only a process that ran alone uses getrusage()
+        for(ProcessSampler *sampler: qAsConst(running())){
+            sampler->_alone = false;
+        }
+        this->_alone = running().isEmpty();
+        this->_childrenCpuTime = childrenCpuTime();
+        running().append(this);
+
+        this->sample();
+        this->_timer.start();
+    }
+}
+
+void ProcessSampler::stop(){
+    this->_timer.stop();
+    this->_pid = 0;
+
+    //The last interval before the process exited can't be read from /proc, but the process was reaped before QProcess::finished, so its whole CPU time is in getrusage()
+    if(running().removeOne(this) && this->_alone && this->_childrenCpuTime >= 0){
+        this->_cpuTime = qMax(this->_cpuTime, childrenCpuTime() - this->_childrenCpuTime);
+    }
+}
+
+qint64 ProcessSampler::peakMemory() const{
+    return this->_peakMemory;
+}
+
+qint64 ProcessSampler::cpuTime() const{
+    return this->_cpuTime;
+}
+
+bool ProcessSampler::isSupported(){
+    #ifdef Q_OS_LINUX
+        return true;
+    #else
+        return false;
+    #endif
+}
+
+qint64 ProcessSampler::childrenCpuTime(){
+    #ifdef Q_OS_LINUX
+        struct rusage usage;
+        if(getrusage(RUSAGE_CHILDREN, &usage) == 0){
+            return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+        }
+    #endif
+    return -1;
+}
+
+QList<ProcessSampler*> &ProcessSampler::running(){
+    static QList<ProcessSampler*> running;
+    return running;
+}
+
+void ProcessSampler::sample(){
+    #ifdef Q_OS_LINUX
+        //The kernel keeps track of the peak resident set size itself (VmHWM), so sampling it doesn't miss short peaks
+        QFile status("/proc/" + QString::number(this->_pid) + "/status");
+        if(status.open(QFile::ReadOnly)){
+            const QRegularExpressionMatch match = QRegularExpression("^VmHWM:\\s*([0-9]+)\\s*kB", QRegularExpression::MultilineOption).match(QString::fromLatin1(status.readAll()));
+            if(match.hasMatch()){
+                this->_peakMemory = qMax(this->_peakMemory, match.captured(1).toLongLong());
+            }
+        }
+
+        //The name of the command in /proc/<pid>/stat can contain spaces, so start counting the fields after it
+        QFile stat("/proc/" + QString::number(this->_pid) + "/stat");
+        if(stat.open(QFile::ReadOnly)){
+            const QString content = QString::fromLatin1(stat.readAll());
+            const QStringList fields = content.mid(content.lastIndexOf(')') + 2).split(' ');
+            if(fields.length() > 12){
+                const qint64 ticks = fields[11].toLongLong() + fields[12].toLongLong();    //utime and stime
+                this->_cpuTime = qMax(this->_cpuTime, ticks * 1000 / sysconf(_SC_CLK_TCK));
+            }
+        }
+    #endif
+}
@@ -0,0 +1,38 @@
+#ifndef PROCESSSAMPLER_H
+#define PROCESSSAMPLER_H
+
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+//Measures the peak memory and CPU time of a process started with QProcess, by reading /proc while it runs
+//The CPU time of the end of the run is taken from getrusage() when stop() is called after the process was reaped, which is only possible if no other sampled process ran at the same time
+class ProcessSampler : public QObject{
+    Q_OBJECT
+
+public:
+    ProcessSampler(int interval = 20, QObject *parent = nullptr);    //interval is in milliseconds
+    ~ProcessSampler();
+
+    void start(qint64 pid);
+    void stop();    //Must be called once the process finished, in the slot of QProcess::finished
+
+    qint64 peakMemory() const;    //The peak resident set size in kilobytes, or -1 if it couldn't be measured
+    qint64 cpuTime() const;    //The user and system CPU time in milliseconds, or -1 if it couldn't be measured, a lower bound if other sampled processes ran at the same time
+
+    static bool isSupported();
+
+private:
+    void sample();
+    static qint64 childrenCpuTime();    //The CPU time of all the child processes that were reaped, in milliseconds, -1 if it isn't supported
+    static QList<ProcessSampler*> &running();
+
+    QTimer _timer;
+    qint64 _pid;
+    qint64 _peakMemory;
+    qint64 _cpuTime;
+    qint64 _childrenCpuTime;    //childrenCpuTime() when the process started
+    bool _alone;    //Whether no other sampled process ran since this one started
+};
+
+#endif // PROCESSSAMPLER_H
@@ -0,0 +1,126 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QTimer>
+#include "projectbuilder.h"
+#include "preprocessor.h"
+#include "tablegenerator.h"
+#include "spritepalette.h"
+
+ProjectBuilder::ProjectBuilder(const QString &nmlFile, const QList<BuildConfiguration> &configurations, BuildPool *pool, QObject *parent):
+    QObject(parent),
+    _nmlFile(nmlFile),
+    _configurations(configurations),
+    _pool(pool),
+    _runningCompilers(0),
+    _finished(false),
+    _duration(0)
+{}
+
+const QString &ProjectBuilder::nmlFile() const{
+    return this->_nmlFile;
+}
+
+const QList<NMLCompiler*> &ProjectBuilder::compilers() const{
+    return this->_compilers;
+}
+
+QStringList ProjectBuilder::errors() const{
+    return this->_errors;
+}
+
+bool ProjectBuilder::isFinished() const{
+    return this->_finished;
+}
+
+bool ProjectBuilder::succeeded() const{
+    if(!this->_finished || !this->_errors.isEmpty() || this->_compilers.isEmpty()){
+        return false;
+    }
+    for(NMLCompiler *compiler: this->_compilers){
+        if(compiler->result() != NMLCompiler::Success){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProjectBuilder::compilerNotFound() const{
+    for(NMLCompiler *compiler: this->_compilers){
+        if(compiler->result() == NMLCompiler::CompilerNotFound){
+            return true;
+        }
+    }
+    return false;
+}
+
+qint64 ProjectBuilder::duration() const{
+    return this->_finished ? this->_duration : this->_timer.elapsed();
+}
+
+void ProjectBuilder::start(){
+    this->_timer.start();
+
+    //Do the same as saving all the files in the GUI: make sure every sprite uses the OpenTTD palette before compiling
+    this->applyPaletteToSprites();
+
+    //The code generated from the tables must be up to date before preprocessing
+    TableGenerator tableGenerator(this->_nmlFile);
+    if(!tableGenerator.generate()){
+        for(const Preprocessor::Error &error: tableGenerator.errors()){
+            this->_errors.append(error.toString());
+        }
+    }
+
+    //The compiler doesn't understand the #include and #define directives of .pnml files, so it compiles the expanded file instead
+    const QString inputFile = Preprocessor::isPreprocessed(this->_nmlFile) ? Preprocessor::outputFile(this->_nmlFile) : this->_nmlFile;
+    if(this->_errors.isEmpty() && Preprocessor::isPreprocessed(this->_nmlFile)){
+        Preprocessor preprocessor(this->_nmlFile);
+        if(!preprocessor.preprocessToFile(inputFile)){
+            for(const Preprocessor::Error &error: preprocessor.errors()){
+                this->_errors.append(error.toString());
+            }
+        }
+    }
+
+    if(!this->_errors.isEmpty() || this->_configurations.isEmpty()){
+        if(this->_configurations.isEmpty()){
+            this->_errors.append(QObject::tr("There is no enabled build configuration for the project %1.").arg(this->_nmlFile));
+        }
+        QTimer::singleShot(0, this, [this](){
+            this->_finished = true;
+            this->_duration = this->_timer.elapsed();
+            emit this->finished(this);
+        });
+        return;
+    }
+
+    for(const BuildConfiguration &configuration: this->_configurations){
+        NMLCompiler *compiler = new NMLCompiler(this->_nmlFile, configuration, this);
+        compiler->setInputFile(inputFile);
+        QObject::connect(compiler, &NMLCompiler::finished, this, [this](NMLCompiler *compiler){
+            emit this->compilerFinished(compiler);
+            this->_runningCompilers--;
+            if(this->_runningCompilers == 0){
+                this->_finished = true;
+                this->_duration = this->_timer.elapsed();
+                emit this->finished(this);
+            }
+        });
+        this->_compilers.append(compiler);
+    }
+    this->_runningCompilers = this->_compilers.length();
+    for(NMLCompiler *compiler: qAsConst(this->_compilers)){
+        this->_pool->enqueue(compiler);
+    }
+}
+
+bool ProjectBuilder::applyPaletteToSprites(){
+    const QDir gfxDir(QFileInfo(this->_nmlFile).dir().path() + "/gfx");
+    const QStringList spriteFiles = gfxDir.entryList({"*.png"}, QDir::Files);
+    for(const QString &spriteFile: spriteFiles){
+        if(!SpritePalette::applyToFile(gfxDir.path() + "/" + spriteFile)){
+            this->_errors.append(QObject::tr("The file %1 is not a valid image file or could not be saved.").arg(gfxDir.path() + "/" + spriteFile));
+        }
+    }
+    return this->_errors.isEmpty();
+}
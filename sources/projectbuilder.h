@@ -0,0 +1,45 @@
+#ifndef PROJECTBUILDER_H
+#define PROJECTBUILDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include "buildpool.h"
+
+//Builds a project without opening it in a window, for example from the command line
+class ProjectBuilder : public QObject{
+    Q_OBJECT
+
+public:
+    ProjectBuilder(const QString &nmlFile, const QList<BuildConfiguration> &configurations, BuildPool *pool, QObject *parent = nullptr);
+
+    const QString &nmlFile() const;
+    const QList<NMLCompiler*> &compilers() const;
+    QStringList errors() const;    //Errors that prevented the project from being compiled, for example a sprite that couldn't be read
+
+    bool isFinished() const;
+    bool succeeded() const;
+    bool compilerNotFound() const;
+    qint64 duration() const;    //In milliseconds
+
+public slots:
+    void start();
+
+signals:
+    void compilerFinished(NMLCompiler *compiler);
+    void finished(ProjectBuilder *builder);
+
+private:
+    bool applyPaletteToSprites();
+
+    const QString _nmlFile;
+    const QList<BuildConfiguration> _configurations;
+    BuildPool *const _pool;
+    QList<NMLCompiler*> _compilers;
+    QStringList _errors;
+    QElapsedTimer _timer;
+    int _runningCompilers;
+    bool _finished;
+    qint64 _duration;
+};
+
+#endif // PROJECTBUILDER_H
@@ -0,0 +1,112 @@
+#include <QVector>
+#include <cstring>
+#include "rastertools.h"
+
+QRect RasterTools::drawLine(QImage *image, const QPoint &from, const QPoint &to, uchar index){
+    if(image->format() != QImage::Format_Indexed8){
+        return QRect();
+    }
+
+    //Bresenham's algorithm, so that a fast mouse movement still draws a continuous line
+    const QRect bounds = image->rect();
+    const int dx = qAbs(to.x() - from.x()), dy = -qAbs(to.y() - from.y());
+    const int stepX = (from.x() < to.x()) ? 1 : -1, stepY = (from.y() < to.y()) ? 1 : -1;
+    int x = from.x(), y = from.y(), error = dx + dy;
+    while(true){
+        if(bounds.contains(x, y)){
+            image->scanLine(y)[x] = index;
+        }
+        if(x == to.x() && y == to.y()){
+            break;
+        }
+        const int doubleError = 2 * error;
+        if(doubleError >= dy){
+            error += dy;
+            x += stepX;
+        }
+        if(doubleError <= dx){
+            error += dx;
+            y += stepY;
+        }
+    }
+    return QRect(from, to).normalized().intersected(bounds);
+}
+
+QRect RasterTools::drawRectangle(QImage *image, const QRect &rect, uchar index, bool filled){
+    if(image->format() != QImage::Format_Indexed8){
+        return QRect();
+    }
+    const QRect normalized = rect.normalized();
+    const QRect clipped = normalized.intersected(image->rect());
+    if(clipped.isEmpty()){
+        return QRect();
+    }
+
+    for(int y = clipped.top(); y <= clipped.bottom(); y++){
+        uchar *line = image->scanLine(y);
+        if(filled || y == normalized.top() || y == normalized.bottom()){
+            std::memset(line + clipped.left(), index, clipped.width());
+            continue;
+        }
+        //The sides are only drawn if they are inside the image
+        if(normalized.left() == clipped.left()){
+            line[clipped.left()] = index;
+        }
+        if(normalized.right() == clipped.right()){
+            line[clipped.right()] = index;
+        }
+    }
+    return clipped;
+}
+
+QRect RasterTools::floodFill(QImage *image, const QPoint &start, uchar index){
+    if(image->format() != QImage::Format_Indexed8 || !image->rect().contains(start)){
+        return QRect();
+    }
+    const uchar target = image->constScanLine(start.y())[start.x()];
+    if(target == index){
+        return QRect();
+    }
+
+    //Scanline fill: each seed is extended to the whole span of target pixels on its line, then the lines above and below the span get one seed per span of target pixels
+    //Every pixel is filled once and looked at a few times, so the time only depends on the size of the area
+    const int width = image->width(), height = image->height();
+    int left = start.x(), right = start.x(), top = start.y(), bottom = start.y();
+    QVector<QPoint> seeds;
+    seeds.reserve(256);
+    seeds.append(start);
+    while(!seeds.isEmpty()){
+        const QPoint seed = seeds.takeLast();
+        uchar *line = image->scanLine(seed.y());
+        if(line[seed.x()] != target){
+            continue;    //Already filled through another seed
+        }
+        int spanLeft = seed.x(), spanRight = seed.x();
+        while(spanLeft > 0 && line[spanLeft - 1] == target){
+            spanLeft--;
+        }
+        while(spanRight < width - 1 && line[spanRight + 1] == target){
+            spanRight++;
+        }
+        std::memset(line + spanLeft, index, spanRight - spanLeft + 1);
+        left = qMin(left, spanLeft);
+        right = qMax(right, spanRight);
+        top = qMin(top, seed.y());
+        bottom = qMax(bottom, seed.y());
+
+        for(const int y: {seed.y() - 1, seed.y() + 1}){
+            if(y < 0 || y >= height){
+                continue;
+            }
+            const uchar *neighbour = image->constScanLine(y);
+            bool inSpan = false;
+            for(int x = spanLeft; x <= spanRight; x++){
+                if(neighbour[x] == target && !inSpan){
+                    seeds.append(QPoint(x, y));
+                }
+                inSpan = (neighbour[x] == target);
+            }
+        }
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
@@ -0,0 +1,17 @@
+#ifndef RASTERTOOLS_H
+#define RASTERTOOLS_H
+
+#include <QImage>
+
+//Drawing operations on 8-bit images, which write the palette index directly to the scanlines of the image
+//Each operation returns the rectangle of the pixels it may have changed, so that only that part of the image has to be painted again
+class RasterTools{
+public:
+    enum Tool{Pencil, Line, Rectangle, FilledRectangle, FloodFill};
+
+    static QRect drawLine(QImage *image, const QPoint &from, const QPoint &to, uchar index);    //Both ends are included, parts outside the image are ignored
+    static QRect drawRectangle(QImage *image, const QRect &rect, uchar index, bool filled);
+    static QRect floodFill(QImage *image, const QPoint &start, uchar index);    //Fills the area of pixels with the same index as the start pixel that are connected horizontally or vertically
+};
+
+#endif // RASTERTOOLS_H
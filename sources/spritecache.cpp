@@ -0,0 +1,288 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLockFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QSettings>
+#include <algorithm>
+#include "spritecache.h"
+#include "spritecachereader.h"
+
+const QString SpriteCache::usageFile = "nmlcreator-usage.json";
+
+namespace{
+    //The usage file is read and written by every window and every NMLCreator process using the same cache folder, for example batch builds, so they take turns with a lock file
+    const QString usageLockFile = "nmlcreator-usage.lock";
+    const int usageLockTimeout = 10000;    //In milliseconds, the usage isn't updated and the cache isn't pruned if the lock can't be taken in time
+
+    //The usage file contains when each cache folder and each sprite in it was last used, older versions only contained the folders
+    QJsonObject readUsage(const QString &budgetDirectory){
+        QFile file(budgetDirectory + "/" + SpriteCache::usageFile);
+        if(!file.open(QFile::ReadOnly)){
+            return QJsonObject();
+        }
+        const QJsonObject usage = QJsonDocument::fromJson(file.readAll()).object();
+        return usage.contains("directories") ? usage : QJsonObject({{"directories", usage}});
+    }
+
+    void writeUsage(const QString &budgetDirectory, const QJsonObject &usage){
+        QDir(budgetDirectory).mkpath(".");
+        QSaveFile file(budgetDirectory + "/" + SpriteCache::usageFile);
+        if(file.open(QFile::WriteOnly)){
+            file.write(QJsonDocument(usage).toJson(QJsonDocument::Compact));
+            file.commit();
+        }
+    }
+
+    QString hashedKey(const QString &key){
+        return QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();    //The keys contain the whole description of the sprite, which would make the usage file large
+    }
+
+    //Rewrites a .cache file and its .cacheindex file without the given sprites, returns the number of bytes this saved
+    qint64 removeSprites(const QString &indexFile, const QSet<QString> &keys){
+        const QString cacheFile = SpriteCacheReader::cacheFile(indexFile);
+        const qint64 previousSize = QFileInfo(indexFile).size() + QFileInfo(cacheFile).size();
+        QFile index(indexFile), cache(cacheFile);
+        if(!index.open(QFile::ReadOnly) || !cache.open(QFile::ReadOnly)){
+            return 0;
+        }
+        const QJsonDocument document = QJsonDocument::fromJson(index.readAll());
+        index.close();
+        const uchar *cacheData = (cache.size() > 0) ? cache.map(0, cache.size()) : nullptr;
+        const QDateTime cacheTime = QFileInfo(cache).lastModified();
+
+        //The offsets of the remaining sprites change since they're moved to fill the gaps
+        QJsonArray sprites;
+        QByteArray data;
+        for(const QJsonValue &value: document.isArray() ? document.array() : document.object()["index"].toArray()){
+            QJsonObject sprite = value.toObject();
+            const qint64 offset = sprite["offset"].toVariant().toLongLong(), size = sprite["size"].toVariant().toLongLong();
+            if(keys.contains(SpriteCacheReader::key(indexFile, sprite)) || cacheData == nullptr || offset < 0 || size < 0 || offset + size > cache.size()){
+                continue;
+            }
+            sprite["offset"] = data.size();
+            data.append(reinterpret_cast<const char*>(cacheData) + offset, size);
+            sprites.append(sprite);
+        }
+        cache.close();
+
+        QJsonDocument newDocument;
+        if(document.isArray()){
+            newDocument.setArray(sprites);
+        }
+        else{
+            QJsonObject object = document.object();
+            object["index"] = sprites;
+            newDocument.setObject(object);
+        }
+
+        //Both files are completely written before either of them replaces the old one, since the offsets in the index only match the new .cache file
+        QSaveFile newCache(cacheFile), newIndex(indexFile);
+        if(!newCache.open(QFile::WriteOnly) || newCache.write(data) < 0 || !newIndex.open(QFile::WriteOnly) || newIndex.write(newDocument.toJson(QJsonDocument::Compact)) < 0){
+            return 0;
+        }
+        if(!newCache.commit()){
+            return 0;
+        }
+        if(!newIndex.commit()){
+            QFile::remove(indexFile);    //The compiler ignores a .cache file without an index, which is better than reading the sprites at the wrong offsets
+        }
+
+        //The compiler compares the time of the .cache file with the source files, so the rewritten file must not make sprites that were already outdated look up to date
+        QFile cacheTimeFile(cacheFile);
+        if(cacheTimeFile.open(QFile::ReadWrite)){
+            cacheTimeFile.setFileTime(cacheTime, QFileDevice::FileModificationTime);
+            cacheTimeFile.close();
+        }
+        return previousSize - QFileInfo(indexFile).size() - QFileInfo(cacheFile).size();
+    }
+}
+
+bool SpriteCache::isEnabled(){
+    return QSettings("OpenTTD", "NMLCreator").value("compiler/enableCache", true).toBool();
+}
+
+QString SpriteCache::rootDirectory(const QString &nmlFile){
+    const QSettings settings("OpenTTD", "NMLCreator");
+    const QDir projectDir = QFileInfo(nmlFile).absoluteDir();
+    const QString sharedDir = settings.value("compiler/sharedCacheDir", "").toString();
+    if(!sharedDir.isEmpty()){
+        //Every project gets its own folder in the shared cache, the compiler would otherwise mix up sprites with the same file name from different projects
+        const QString projectKey = QCryptographicHash::hash(projectDir.absolutePath().toUtf8(), QCryptographicHash::Md5).toHex().left(8);
+        return QDir::cleanPath(QDir(sharedDir).absoluteFilePath(QFileInfo(nmlFile).completeBaseName() + "-" + projectKey));
+    }
+    return QDir::cleanPath(projectDir.absoluteFilePath(settings.value("compiler/cacheDir", ".nmlcache").toString()));
+}
+
+QString SpriteCache::budgetDirectory(const QString &nmlFile){
+    const QString sharedDir = QSettings("OpenTTD", "NMLCreator").value("compiler/sharedCacheDir", "").toString();
+    return sharedDir.isEmpty() ? rootDirectory(nmlFile) : QDir::cleanPath(QDir(sharedDir).absolutePath());
+}
+
+QString SpriteCache::directory(const QString &nmlFile, const BuildConfiguration &configuration){
+    if(configuration.cacheSubfolder().isEmpty()){
+        return rootDirectory(nmlFile);
+    }
+    return rootDirectory(nmlFile) + "/" + configuration.cacheSubfolder();
+}
+
+qint64 SpriteCache::budget(){
+    return QSettings("OpenTTD", "NMLCreator").value("compiler/cacheBudget", 0).toLongLong() * 1024 * 1024;
+}
+
+QSet<QString> SpriteCache::entries(const QString &directory){
+    QSet<QString> entries;
+    const QStringList indexFiles = QDir(directory).entryList({"*.cacheindex"}, QDir::Files);
+    for(const QString &indexFile: indexFiles){
+        const SpriteCacheReader reader(directory + "/" + indexFile);
+        for(const SpriteCacheReader::Entry &entry: reader.entries()){
+            entries.insert(entry.key);
+        }
+    }
+    return entries;
+}
+
+qint64 SpriteCache::size(const QString &directory){
+    qint64 size = 0;
+    const QFileInfoList files = QDir(directory).entryInfoList({"*.cache", "*.cacheindex"}, QDir::Files);
+    for(const QFileInfo &file: files){
+        size += file.size();
+    }
+    return size;
+}
+
+void SpriteCache::markUsed(const QString &budgetDirectory, const QString &directory, const QString &sourceDirectory){
+    QDir(budgetDirectory).mkpath(".");
+    QLockFile lock(budgetDirectory + "/" + usageLockFile);
+    if(!lock.tryLock(usageLockTimeout)){
+        return;
+    }
+    QJsonObject usage = readUsage(budgetDirectory);
+    const QString key = QDir(budgetDirectory).relativeFilePath(directory);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QJsonObject directories = usage["directories"].toObject();
+    directories[key] = now;
+    usage["directories"] = directories;
+
+    //The compiler keeps the sprites it didn't use in the cache, so the sprites that are still up to date count as used and the others keep the time they were last up to date
+    QJsonObject allSprites = usage["sprites"].toObject();
+    const QJsonObject previousSprites = allSprites[key].toObject();
+    QJsonObject sprites;
+    for(const QString &indexFile: QDir(directory).entryList({"*.cacheindex"}, QDir::Files)){
+        const SpriteCacheReader reader(directory + "/" + indexFile, sourceDirectory);
+        for(const SpriteCacheReader::Entry &entry: reader.entries()){
+            const QString spriteKey = hashedKey(entry.key);
+            sprites[spriteKey] = (entry.status == SpriteCacheReader::UpToDate) ? now : previousSprites[spriteKey].toVariant().toLongLong();
+        }
+    }
+    allSprites[key] = sprites;
+    usage["sprites"] = allSprites;
+    writeUsage(budgetDirectory, usage);
+}
+
+qint64 SpriteCache::prune(const QString &budgetDirectory, qint64 budget, const QStringList &keep){
+    struct Cache{
+        QString directory;
+        qint64 size;
+        qint64 lastUsed;
+    };
+
+    QDir(budgetDirectory).mkpath(".");
+    QLockFile lock(budgetDirectory + "/" + usageLockFile);
+    if(!lock.tryLock(usageLockTimeout)){
+        return 0;
+    }
+    QJsonObject usage = readUsage(budgetDirectory);
+    QJsonObject directoryUsage = usage["directories"].toObject(), spriteUsage = usage["sprites"].toObject();
+
+    //Find every folder containing a cache, folders that were never built by NMLCreator count as used when they were last modified
+    QList<Cache> caches;
+    qint64 totalSize = 0;
+    QDirIterator iterator(budgetDirectory, {"*.cacheindex"}, QDir::Files, QDirIterator::Subdirectories);
+    QSet<QString> directories;
+    while(iterator.hasNext()){
+        directories.insert(QFileInfo(iterator.next()).absolutePath());
+    }
+    for(const QString &directory: qAsConst(directories)){
+        const QString key = QDir(budgetDirectory).relativeFilePath(directory);
+        const qint64 lastUsed = directoryUsage.contains(key) ? directoryUsage[key].toVariant().toLongLong() : QFileInfo(directory).lastModified().toMSecsSinceEpoch();
+        caches.append({directory, size(directory), lastUsed});
+        totalSize += caches.last().size;
+    }
+    if(budget <= 0 || totalSize <= budget){
+        return 0;
+    }
+
+    //First delete the whole caches of the build configurations that weren't just built
+    std::sort(caches.begin(), caches.end(), [](const Cache &a, const Cache &b){
+        return a.lastUsed < b.lastUsed;
+    });
+    qint64 deleted = 0;
+    QList<Cache> keptCaches;
+    for(const Cache &cache: qAsConst(caches)){
+        if(keep.contains(QDir::cleanPath(cache.directory))){
+            keptCaches.append(cache);
+            continue;
+        }
+        if(totalSize - deleted <= budget){
+            continue;
+        }
+        const QFileInfoList files = QDir(cache.directory).entryInfoList({"*.cache", "*.cacheindex"}, QDir::Files);
+        for(const QFileInfo &cacheFile: files){
+            const qint64 fileSize = cacheFile.size();
+            if(QFile::remove(cacheFile.filePath())){
+                deleted += fileSize;
+            }
+        }
+        const QString key = QDir(budgetDirectory).relativeFilePath(cache.directory);
+        directoryUsage.remove(key);
+        spriteUsage.remove(key);
+    }
+
+    //If that isn't enough, remove the least recently used sprites from the caches that were just built, so that even a project with a single cache stays under the limit
+    if(totalSize - deleted > budget){
+        struct Sprite{
+            QString indexFile;
+            QString key;
+            qint64 size;
+            qint64 lastUsed;
+        };
+        QList<Sprite> sprites;
+        for(const Cache &cache: qAsConst(keptCaches)){
+            const QJsonObject usedSprites = spriteUsage[QDir(budgetDirectory).relativeFilePath(cache.directory)].toObject();
+            for(const QString &indexFile: QDir(cache.directory).entryList({"*.cacheindex"}, QDir::Files)){
+                const SpriteCacheReader reader(cache.directory + "/" + indexFile);
+                for(const SpriteCacheReader::Entry &entry: reader.entries()){
+                    sprites.append({cache.directory + "/" + indexFile, entry.key, entry.size, usedSprites[hashedKey(entry.key)].toVariant().toLongLong()});
+                }
+            }
+        }
+        std::sort(sprites.begin(), sprites.end(), [](const Sprite &a, const Sprite &b){
+            return a.lastUsed < b.lastUsed;
+        });
+        QMap<QString, QSet<QString>> removedSprites;
+        qint64 removedSize = 0;
+        for(const Sprite &sprite: qAsConst(sprites)){
+            if(totalSize - deleted - removedSize <= budget){
+                break;
+            }
+            removedSprites[sprite.indexFile].insert(sprite.key);
+            removedSize += sprite.size;
+        }
+        for(auto i = removedSprites.constBegin(); i != removedSprites.constEnd(); i++){
+            deleted += removeSprites(i.key(), i.value());
+        }
+    }
+
+    usage["directories"] = directoryUsage;
+    usage["sprites"] = spriteUsage;
+    writeUsage(budgetDirectory, usage);
+    return deleted;
+}
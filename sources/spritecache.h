@@ -0,0 +1,29 @@
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "buildconfiguration.h"
+
+//Manages the folders where the NML compiler caches its encoded sprites (.cache and .cacheindex files)
+class SpriteCache{
+public:
+    static bool isEnabled();
+    static QString rootDirectory(const QString &nmlFile);    //Returns the absolute path of the folder containing the caches of the project, which is inside the shared cache folder if there is one
+    static QString budgetDirectory(const QString &nmlFile);    //Returns the folder the size limit applies to, which is the shared cache folder if there is one and the root folder of the project otherwise
+    static QString directory(const QString &nmlFile, const BuildConfiguration &configuration);    //Returns the absolute path passed to the compiler with --cache-dir
+    static qint64 budget();    //In bytes, 0 if the size of the cache isn't limited
+
+    static QSet<QString> entries(const QString &directory);    //Returns a key for every sprite cached in the folder, two sprites encoded the same way have the same key
+    static qint64 size(const QString &directory);    //Returns the size in bytes of the cache files directly in the folder
+
+    //The caches of the build configurations that weren't just built are deleted first, least recently used first, then the least recently used sprites of the caches that were just built
+    static void markUsed(const QString &budgetDirectory, const QString &directory, const QString &sourceDirectory);    //sourceDirectory is the project folder, the sprites whose source files didn't change since they were cached count as used
+    //No compiler may be using the caches in the folder, so in the application it must only be called when the build pool is idle
+    static qint64 prune(const QString &budgetDirectory, qint64 budget, const QStringList &keep);    //Deletes caches and sprites until the folder is smaller than budget, returns the number of bytes deleted
+
+    static const QString usageFile;
+};
+
+#endif // SPRITECACHE_H
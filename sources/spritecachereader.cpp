@@ -0,0 +1,119 @@
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include "spritecachereader.h"
+
+SpriteCacheReader::SpriteCacheReader(const QString &indexFile, const QString &sourceDirectory):
+    _indexFile(indexFile),
+    _cacheFile(cacheFile(indexFile)),
+    _indexData(nullptr),
+    _cacheData(nullptr),
+    _sourceDirectory(sourceDirectory),
+    _valid(false)
+{
+    if(!this->_indexFile.open(QFile::ReadOnly) || !this->_cacheFile.open(QFile::ReadOnly) || this->_indexFile.size() == 0){
+        return;
+    }
+    this->_indexData = this->_indexFile.map(0, this->_indexFile.size());
+    this->_cacheData = (this->_cacheFile.size() > 0) ? this->_cacheFile.map(0, this->_cacheFile.size()) : nullptr;
+    if(this->_indexData == nullptr || (this->_cacheData == nullptr && this->_cacheFile.size() > 0)){
+        return;
+    }
+
+    //Depending on the version of the compiler, the index is either a list of sprites or an object containing that list
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(this->_indexData), this->_indexFile.size()), &error);
+    if(error.error != QJsonParseError::NoError){
+        return;
+    }
+    const QJsonArray sprites = document.isArray() ? document.array() : document.object()["index"].toArray();
+
+    //The compiler drops the sprites whose source files are newer than the .cache file when it reads the cache
+    const QDateTime cacheTime = QFileInfo(this->_cacheFile).lastModified();
+    const auto rect = [](const QJsonValue &value){
+        const QJsonArray array = value.toArray();
+        return (array.size() == 4) ? QRect(array[0].toInt(), array[1].toInt(), array[2].toInt(), array[3].toInt()) : QRect();
+    };
+    for(const QJsonValue &sprite: sprites){
+        const QJsonObject object = sprite.toObject();
+        Entry entry;
+        entry.rgbFile = object["rgb_file"].toString();
+        entry.rgbRect = rect(object["rgb_rect"]);
+        entry.maskFile = object["mask_file"].toString();
+        entry.maskRect = rect(object["mask_rect"]);
+        entry.offset = object["offset"].toVariant().toLongLong();
+        entry.size = object["size"].toVariant().toLongLong();
+        entry.key = key(indexFile, object);
+
+        entry.status = Unknown;
+        if(entry.offset < 0 || entry.size < 0 || entry.offset + entry.size > this->_cacheFile.size()){
+            entry.status = Stale;    //The compiler can't use an entry that isn't in the .cache file
+        }
+        else if(!this->_sourceDirectory.isEmpty()){
+            entry.status = qMax(this->sourceStatus(entry.rgbFile, cacheTime), this->sourceStatus(entry.maskFile, cacheTime));
+        }
+        this->_entries.append(entry);
+    }
+    this->_valid = true;
+}
+
+bool SpriteCacheReader::isValid() const{
+    return this->_valid;
+}
+
+const QList<SpriteCacheReader::Entry> &SpriteCacheReader::entries() const{
+    return this->_entries;
+}
+
+qint64 SpriteCacheReader::encodedSize() const{
+    qint64 size = 0;
+    for(const Entry &entry: this->_entries){
+        size += entry.size;
+    }
+    return size;
+}
+
+QByteArray SpriteCacheReader::encodedData(const Entry &entry) const{
+    if(this->_cacheData == nullptr || entry.offset < 0 || entry.size < 0 || entry.offset + entry.size > this->_cacheFile.size()){
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(this->_cacheData) + entry.offset, entry.size);
+}
+
+QString SpriteCacheReader::cacheFile(const QString &indexFile){
+    return QFileInfo(indexFile).path() + "/" + QFileInfo(indexFile).completeBaseName() + ".cache";
+}
+
+QString SpriteCacheReader::key(const QString &indexFile, const QJsonObject &sprite){
+    QJsonObject key = sprite;
+    key.remove("offset");    //Where the sprite is in the .cache file changes whenever another sprite is added or removed
+    key.remove("size");
+    return QFileInfo(indexFile).fileName() + ":" + QJsonDocument(key).toJson(QJsonDocument::Compact);
+}
+
+QString SpriteCacheReader::statusText(Status status){
+    switch(status){
+        case UpToDate:
+            return QObject::tr("Up to date");
+        case Stale:
+            return QObject::tr("Will be encoded again");
+        case SourceMissing:
+            return QObject::tr("Source file not found");
+        default:
+            return QObject::tr("Unknown");
+    }
+}
+
+SpriteCacheReader::Status SpriteCacheReader::sourceStatus(const QString &file, const QDateTime &cacheTime){
+    if(file.isEmpty()){
+        return UpToDate;
+    }
+    if(!this->_sourceStatus.contains(file)){
+        const QFileInfo source(QDir(this->_sourceDirectory).absoluteFilePath(file));
+        this->_sourceStatus.insert(file, !source.exists() ? SourceMissing : (source.lastModified() > cacheTime) ? Stale : UpToDate);
+    }
+    return this->_sourceStatus[file];
+}
@@ -0,0 +1,55 @@
+#ifndef SPRITECACHEREADER_H
+#define SPRITECACHEREADER_H
+
+#include <QFile>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QRect>
+
+//Reads the sprites cached by the NML compiler in a .cacheindex file and the .cache file next to it
+//Both files are memory-mapped instead of being read, so that large caches can be inspected without copying them
+class SpriteCacheReader{
+public:
+    enum Status{
+        Unknown,    //The source files weren't checked
+        UpToDate,
+        Stale,    //A source file was modified after the cache was written, so the next compilation encodes the sprite again
+        SourceMissing
+    };
+
+    struct Entry{
+        QString rgbFile;    //Exactly as written in the .nml file, relative to the folder the compiler runs in
+        QRect rgbRect;
+        QString maskFile;    //Empty if the sprite doesn't have a mask
+        QRect maskRect;
+        qint64 offset;    //Where the encoded sprite is in the .cache file
+        qint64 size;    //The size of the encoded sprite in bytes, which is roughly its size in the .grf file
+        QString key;    //Two sprites encoded the same way have the same key, even in different versions of the cache
+        Status status;
+    };
+
+    SpriteCacheReader(const QString &indexFile, const QString &sourceDirectory = QString());    //If sourceDirectory is empty, the status of every entry is Unknown
+
+    bool isValid() const;    //Returns false if the files don't exist or can't be parsed
+    const QList<Entry> &entries() const;
+    qint64 encodedSize() const;    //The sum of the sizes of all the entries
+    QByteArray encodedData(const Entry &entry) const;    //Points into the mapped .cache file, so it is only valid as long as the reader exists
+
+    static QString cacheFile(const QString &indexFile);
+    static QString key(const QString &indexFile, const QJsonObject &sprite);    //The key of an entry from its object in the .cacheindex file
+    static QString statusText(Status status);
+
+private:
+    Status sourceStatus(const QString &file, const QDateTime &cacheTime);
+
+    QFile _indexFile, _cacheFile;
+    const uchar *_indexData, *_cacheData;
+    const QString _sourceDirectory;
+    QList<Entry> _entries;
+    QHash<QString, Status> _sourceStatus;    //The status of every source file that was already checked, a sprite sheet is usually used by many entries
+    bool _valid;
+};
+
+#endif // SPRITECACHEREADER_H
@@ -1,283 +1,42 @@
+#include <QActionGroup>
+#include <QComboBox>
 #include <QDialog>
 #include <QGridLayout>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QSettings>
 #include <QToolButton>
+#include <QtMath>
 #include "spriteeditor.h"
-
-const QVector<QRgb> SpriteEditor::_palette = QVector<QRgb>({
-    QColor(0, 0, 255).rgb(),
-    QColor(16, 16, 16).rgb(),
-    QColor(32, 32, 32).rgb(),
-    QColor(48, 48, 48).rgb(),
-    QColor(64, 64, 64).rgb(),
-    QColor(80, 80, 80).rgb(),
-    QColor(100, 100, 100).rgb(),
-    QColor(116, 116, 116).rgb(),
-    QColor(132, 132, 132).rgb(),
-    QColor(148, 148, 148).rgb(),
-    QColor(168, 168, 168).rgb(),
-    QColor(184, 184, 184).rgb(),
-    QColor(200, 200, 200).rgb(),
-    QColor(216, 216, 216).rgb(),
-    QColor(232, 232, 232).rgb(),
-    QColor(252, 252, 252).rgb(),
-    QColor(52, 60, 72).rgb(),
-    QColor(68, 76, 92).rgb(),
-    QColor(88, 96, 112).rgb(),
-    QColor(108, 116, 132).rgb(),
-    QColor(132, 140, 152).rgb(),
-    QColor(156, 160, 172).rgb(),
-    QColor(176, 184, 196).rgb(),
-    QColor(204, 208, 220).rgb(),
-    QColor(48, 44, 4).rgb(),
-    QColor(64, 60, 12).rgb(),
-    QColor(80, 76, 20).rgb(),
-    QColor(96, 92, 28).rgb(),
-    QColor(120, 120, 64).rgb(),
-    QColor(148, 148, 100).rgb(),
-    QColor(176, 176, 132).rgb(),
-    QColor(204, 204, 168).rgb(),
-    QColor(72, 44, 4).rgb(),
-    QColor(88, 60, 20).rgb(),
-    QColor(104, 80, 44).rgb(),
-    QColor(124, 104, 72).rgb(),
-    QColor(152, 132, 92).rgb(),
-    QColor(184, 160, 120).rgb(),
-    QColor(212, 188, 148).rgb(),
-    QColor(244, 220, 176).rgb(),
-    QColor(64, 0, 4).rgb(),
-    QColor(88, 4, 16).rgb(),
-    QColor(112, 16, 32).rgb(),
-    QColor(136, 32, 52).rgb(),
-    QColor(160, 56, 76).rgb(),
-    QColor(188, 84, 108).rgb(),
-    QColor(204, 104, 124).rgb(),
-    QColor(220, 132, 144).rgb(),
-    QColor(236, 156, 164).rgb(),
-    QColor(252, 188, 192).rgb(),
-    QColor(252, 208, 0).rgb(),
-    QColor(252, 232, 60).rgb(),
-    QColor(252, 252, 128).rgb(),
-    QColor(76, 40, 0).rgb(),
-    QColor(96, 60, 8).rgb(),
-    QColor(116, 88, 28).rgb(),
-    QColor(136, 116, 56).rgb(),
-    QColor(156, 136, 80).rgb(),
-    QColor(176, 156, 108).rgb(),
-    QColor(196, 180, 136).rgb(),
-    QColor(68, 24, 0).rgb(),
-    QColor(96, 44, 4).rgb(),
-    QColor(128, 68, 8).rgb(),
-    QColor(156, 96, 16).rgb(),
-    QColor(184, 120, 24).rgb(),
-    QColor(212, 156, 32).rgb(),
-    QColor(232, 184, 16).rgb(),
-    QColor(252, 212, 0).rgb(),
-    QColor(252, 248, 128).rgb(),
-    QColor(252, 252, 192).rgb(),
-    QColor(32, 4, 0).rgb(),
-    QColor(64, 20, 8).rgb(),
-    QColor(84, 28, 16).rgb(),
-    QColor(108, 44, 28).rgb(),
-    QColor(128, 56, 40).rgb(),
-    QColor(148, 72, 56).rgb(),
-    QColor(168, 92, 76).rgb(),
-    QColor(184, 108, 88).rgb(),
-    QColor(196, 128, 108).rgb(),
-    QColor(212, 148, 128).rgb(),
-    QColor(8, 52, 0).rgb(),
-    QColor(16, 64, 0).rgb(),
-    QColor(32, 80, 4).rgb(),
-    QColor(48, 96, 4).rgb(),
-    QColor(64, 112, 12).rgb(),
-    QColor(84, 132, 20).rgb(),
-    QColor(104, 148, 28).rgb(),
-    QColor(128, 168, 44).rgb(),
-    QColor(28, 52, 24).rgb(),
-    QColor(44, 68, 32).rgb(),
-    QColor(60, 88, 48).rgb(),
-    QColor(80, 104, 60).rgb(),
-    QColor(104, 124, 76).rgb(),
-    QColor(128, 148, 92).rgb(),
-    QColor(152, 176, 108).rgb(),
-    QColor(180, 204, 124).rgb(),
-    QColor(16, 52, 24).rgb(),
-    QColor(32, 72, 44).rgb(),
-    QColor(56, 96, 72).rgb(),
-    QColor(76, 116, 88).rgb(),
-    QColor(96, 136, 108).rgb(),
-    QColor(120, 164, 136).rgb(),
-    QColor(152, 192, 168).rgb(),
-    QColor(184, 220, 200).rgb(),
-    QColor(32, 24, 0).rgb(),
-    QColor(56, 28, 0).rgb(),
-    QColor(72, 40, 4).rgb(),
-    QColor(88, 52, 12).rgb(),
-    QColor(104, 64, 24).rgb(),
-    QColor(124, 84, 44).rgb(),
-    QColor(140, 108, 64).rgb(),
-    QColor(160, 128, 88).rgb(),
-    QColor(76, 40, 16).rgb(),
-    QColor(96, 52, 24).rgb(),
-    QColor(116, 68, 40).rgb(),
-    QColor(136, 84, 56).rgb(),
-    QColor(164, 96, 64).rgb(),
-    QColor(184, 112, 80).rgb(),
-    QColor(204, 128, 96).rgb(),
-    QColor(212, 148, 112).rgb(),
-    QColor(224, 168, 128).rgb(),
-    QColor(236, 188, 148).rgb(),
-    QColor(80, 28, 4).rgb(),
-    QColor(100, 40, 20).rgb(),
-    QColor(120, 56, 40).rgb(),
-    QColor(140, 76, 64).rgb(),
-    QColor(160, 100, 96).rgb(),
-    QColor(184, 136, 136).rgb(),
-    QColor(36, 40, 68).rgb(),
-    QColor(48, 52, 84).rgb(),
-    QColor(64, 64, 100).rgb(),
-    QColor(80, 80, 116).rgb(),
-    QColor(100, 100, 136).rgb(),
-    QColor(132, 132, 164).rgb(),
-    QColor(172, 172, 192).rgb(),
-    QColor(212, 212, 224).rgb(),
-    QColor(40, 20, 112).rgb(),
-    QColor(64, 44, 144).rgb(),
-    QColor(88, 64, 172).rgb(),
-    QColor(104, 76, 196).rgb(),
-    QColor(120, 88, 224).rgb(),
-    QColor(140, 104, 252).rgb(),
-    QColor(160, 136, 252).rgb(),
-    QColor(188, 168, 252).rgb(),
-    QColor(0, 24, 108).rgb(),
-    QColor(0, 36, 132).rgb(),
-    QColor(0, 52, 160).rgb(),
-    QColor(0, 72, 184).rgb(),
-    QColor(0, 96, 212).rgb(),
-    QColor(24, 120, 220).rgb(),
-    QColor(56, 144, 232).rgb(),
-    QColor(88, 168, 240).rgb(),
-    QColor(128, 196, 252).rgb(),
-    QColor(188, 224, 252).rgb(),
-    QColor(16, 64, 96).rgb(),
-    QColor(24, 80, 108).rgb(),
-    QColor(40, 96, 120).rgb(),
-    QColor(52, 112, 132).rgb(),
-    QColor(80, 140, 160).rgb(),
-    QColor(116, 172, 192).rgb(),
-    QColor(156, 204, 220).rgb(),
-    QColor(204, 240, 252).rgb(),
-    QColor(172, 52, 52).rgb(),
-    QColor(212, 52, 52).rgb(),
-    QColor(252, 52, 52).rgb(),
-    QColor(252, 100, 88).rgb(),
-    QColor(252, 144, 124).rgb(),
-    QColor(252, 184, 160).rgb(),
-    QColor(252, 216, 200).rgb(),
-    QColor(252, 244, 236).rgb(),
-    QColor(72, 20, 112).rgb(),
-    QColor(92, 44, 140).rgb(),
-    QColor(112, 68, 168).rgb(),
-    QColor(140, 100, 196).rgb(),
-    QColor(168, 136, 224).rgb(),
-    QColor(200, 176, 248).rgb(),
-    QColor(208, 184, 255).rgb(),
-    QColor(232, 208, 252).rgb(),
-    QColor(60, 0, 0).rgb(),
-    QColor(92, 0, 0).rgb(),
-    QColor(128, 0, 0).rgb(),
-    QColor(160, 0, 0).rgb(),
-    QColor(196, 0, 0).rgb(),
-    QColor(224, 0, 0).rgb(),
-    QColor(252, 0, 0).rgb(),
-    QColor(252, 80, 0).rgb(),
-    QColor(252, 108, 0).rgb(),
-    QColor(252, 136, 0).rgb(),
-    QColor(252, 164, 0).rgb(),
-    QColor(252, 192, 0).rgb(),
-    QColor(252, 220, 0).rgb(),
-    QColor(252, 252, 0).rgb(),
-    QColor(204, 136, 8).rgb(),
-    QColor(228, 144, 4).rgb(),
-    QColor(252, 156, 0).rgb(),
-    QColor(252, 176, 48).rgb(),
-    QColor(252, 196, 100).rgb(),
-    QColor(252, 216, 152).rgb(),
-    QColor(8, 24, 88).rgb(),
-    QColor(12, 36, 104).rgb(),
-    QColor(20, 52, 124).rgb(),
-    QColor(28, 68, 140).rgb(),
-    QColor(40, 92, 164).rgb(),
-    QColor(56, 120, 188).rgb(),
-    QColor(72, 152, 216).rgb(),
-    QColor(100, 172, 224).rgb(),
-    QColor(92, 156, 52).rgb(),
-    QColor(108, 176, 64).rgb(),
-    QColor(124, 200, 76).rgb(),
-    QColor(144, 224, 92).rgb(),
-    QColor(224, 244, 252).rgb(),
-    QColor(200, 236, 248).rgb(),
-    QColor(180, 220, 236).rgb(),
-    QColor(132, 188, 216).rgb(),
-    QColor(88, 152, 172).rgb(),
-    QColor(244, 0, 244).rgb(),
-    QColor(245, 0, 245).rgb(),
-    QColor(246, 0, 246).rgb(),
-    QColor(247, 0, 247).rgb(),
-    QColor(248, 0, 248).rgb(),
-    QColor(249, 0, 249).rgb(),
-    QColor(250, 0, 250).rgb(),
-    QColor(251, 0, 251).rgb(),
-    QColor(252, 0, 252).rgb(),
-    QColor(253, 0, 253).rgb(),
-    QColor(254, 0, 254).rgb(),
-    QColor(255, 0, 255).rgb(),
-    QColor(76, 24, 8).rgb(),
-    QColor(108, 44, 24).rgb(),
-    QColor(144, 72, 52).rgb(),
-    QColor(176, 108, 84).rgb(),
-    QColor(210, 146, 126).rgb(),
-    QColor(252, 60, 0).rgb(),
-    QColor(252, 84, 0).rgb(),
-    QColor(252, 104, 0).rgb(),
-    QColor(252, 124, 0).rgb(),
-    QColor(252, 148, 0).rgb(),
-    QColor(252, 172, 0).rgb(),
-    QColor(252, 196, 0).rgb(),
-    QColor(64, 0, 0).rgb(),
-    QColor(255, 0, 0).rgb(),
-    QColor(48, 48, 0).rgb(),
-    QColor(64, 64, 0).rgb(),
-    QColor(80, 80, 0).rgb(),
-    QColor(255, 255, 0).rgb(),
-    QColor(32, 68, 112).rgb(),
-    QColor(36, 72, 116).rgb(),
-    QColor(40, 76, 120).rgb(),
-    QColor(44, 80, 124).rgb(),
-    QColor(48, 84, 128).rgb(),
-    QColor(72, 100, 144).rgb(),
-    QColor(100, 132, 168).rgb(),
-    QColor(216, 244, 252).rgb(),
-    QColor(96, 128, 164).rgb(),
-    QColor(68, 96, 140).rgb(),
-    QColor(255, 255, 255).rgb()
-});
+#include "spritepalette.h"
 
 SpriteEditor::SpriteEditor(const QString &fileName):
+    SpriteEditor(SpriteLoader::decode(fileName))
+{}
+
+SpriteEditor::SpriteEditor(const SpriteLoader::Sprite &sprite):
     _toolBar(QObject::tr("&Image tools")),
-    _image(QImage(fileName).convertToFormat(QImage::Format_Indexed8, _palette)),
-    _previousImage(_image),
+    _image(sprite.image),
     _zoomIn(new QAction(QIcon(":/icons/zoom-in.svg"), QObject::tr("Zoom &in"))),
     _zoomOut(new QAction(QIcon(":/icons/zoom-out.svg"), QObject::tr("Zoom &out"))),
+    _showGrid(new QAction(QIcon(":/icons/grid.svg"), QObject::tr("Pixel &grid"))),
+    _animatePalette(new QAction(QIcon(":/icons/animate.svg"), QObject::tr("&Animate palette"))),
+    _companyColor(PaletteAnimation::DarkBlue),
+    _animationCounter(0),
     _zoom(1),
-    _currentColor(_palette[0]),
+    _currentColor(0),
+    _tool(RasterTools::Pencil),
     _currentlyPressed(false),
-    _hasUnsavedChanges(false)
+    _revision(0),
+    _hasUnsavedChanges(false),
+    _fileIsPalettized(sprite.fileIsPalettized)
 {
     //Insert the image
-    this->updateImage();
+    this->updateZoom();
 
     //Set the cursor
-    this->setCursor(QCursor(QPixmap::fromImage(QImage(":/icons/pencil.svg")).scaledToHeight(32), 0, 32));
+    this->viewport()->setCursor(QCursor(QPixmap::fromImage(QImage(":/icons/pencil.svg")).scaledToHeight(32), 0, 32));
 
     //Create the toolbar
     this->_toolBar.addAction(this->_zoomIn);
@@ -285,18 +44,82 @@ SpriteEditor::SpriteEditor(const QString &fileName):
 
     QObject::connect(this->_zoomIn, &QAction::triggered, [this](){
         this->_zoom = qBound(1, this->_zoom + 1, 10);
-        this->updateImage();
+        this->updateZoom();
     });
 
     QObject::connect(this->_zoomOut, &QAction::triggered, [this](){
         this->_zoom = qBound(1, this->_zoom - 1, 10);
-        this->updateImage();
+        this->updateZoom();
+    });
+
+    this->_showGrid->setCheckable(true);
+    this->_showGrid->setChecked(QSettings("OpenTTD", "NMLCreator").value("spriteEditor/showGrid", false).toBool());
+    this->_showGrid->setWhatsThis(QObject::tr("Shows the borders between the pixels when the image is zoomed in at least 4 times."));
+    this->_toolBar.addAction(this->_showGrid);
+    QObject::connect(this->_showGrid, &QAction::toggled, [this](bool checked){
+        QSettings("OpenTTD", "NMLCreator").setValue("spriteEditor/showGrid", checked);
+        this->viewport()->update();
+    });
+
+    //The company colors and the animated colors are previewed by changing the color table the visible pixels are painted with, the pixels themselves don't change
+    QComboBox *companyColor = new QComboBox;
+    for(int i = 0; i < PaletteAnimation::companyColorCount; i++){
+        QPixmap colorPixmap(16, 16);
+        colorPixmap.fill(QColor(PaletteAnimation::color(PaletteAnimation::CompanyColor(i))));
+        companyColor->addItem(QIcon(colorPixmap), PaletteAnimation::name(PaletteAnimation::CompanyColor(i)));
+    }
+    this->_companyColor = PaletteAnimation::CompanyColor(qBound(0, QSettings("OpenTTD", "NMLCreator").value("spriteEditor/companyColor", 0).toInt(), PaletteAnimation::companyColorCount - 1));
+    companyColor->setCurrentIndex(this->_companyColor);
+    companyColor->setToolTip(QObject::tr("Company color"));
+    companyColor->setWhatsThis(QObject::tr("Shows the company colors (0xC6 to 0xCD) as they look for a company with this color in the game. The image itself isn't changed."));
+    this->_toolBar.addWidget(companyColor);
+    QObject::connect(companyColor, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index){
+        this->_companyColor = PaletteAnimation::CompanyColor(index);
+        QSettings("OpenTTD", "NMLCreator").setValue("spriteEditor/companyColor", index);
+        this->updateColorTable();
     });
 
+    this->_animatePalette->setCheckable(true);
+    this->_animatePalette->setWhatsThis(QObject::tr("Cycles the animated colors (0xE3 to 0xFE), such as water, fire and lights, at the speed of the game."));
+    this->_toolBar.addAction(this->_animatePalette);
+    this->_animationTimer.setInterval(PaletteAnimation::tickDuration);
+    QObject::connect(this->_animatePalette, &QAction::toggled, [this](bool checked){
+        if(checked && this->isVisible()){
+            this->_animationTimer.start();
+        }
+        else{
+            this->_animationTimer.stop();
+        }
+        this->updateColorTable();
+    });
+    QObject::connect(&this->_animationTimer, &QTimer::timeout, [this](){
+        this->_animationCounter += PaletteAnimation::counterStep;
+        this->updateColorTable();
+    });
+    this->_colorTable = PaletteAnimation::colorTable(this->_companyColor);
+
+    this->_toolBar.addSeparator();
+
+    QActionGroup *tools = new QActionGroup(&this->_toolBar);
+    const auto addTool = [this, tools](RasterTools::Tool tool, const QString &icon, const QString &text){
+        QAction *action = this->_toolBar.addAction(QIcon(icon), text);
+        action->setCheckable(true);
+        action->setChecked(tool == this->_tool);
+        tools->addAction(action);
+        QObject::connect(action, &QAction::triggered, [this, tool](){
+            this->_tool = tool;
+        });
+    };
+    addTool(RasterTools::Pencil, ":/icons/pencil.svg", QObject::tr("&Pencil"));
+    addTool(RasterTools::Line, ":/icons/line.svg", QObject::tr("&Line"));
+    addTool(RasterTools::Rectangle, ":/icons/rectangle.svg", QObject::tr("&Rectangle"));
+    addTool(RasterTools::FilledRectangle, ":/icons/filled-rectangle.svg", QObject::tr("F&illed rectangle"));
+    addTool(RasterTools::FloodFill, ":/icons/fill.svg", QObject::tr("&Fill"));
+
     this->_toolBar.addSeparator();
 
     QPixmap colorPixmap(24, 24);
-    colorPixmap.fill(QColor(this->_currentColor));
+    colorPixmap.fill(QColor(SpritePalette::colors[this->_currentColor]));
     QToolButton *colorPicker = new QToolButton;
     colorPicker->setIcon(QIcon(colorPixmap));
     colorPicker->setText(QObject::tr("Color picker..."));
@@ -310,16 +133,16 @@ SpriteEditor::SpriteEditor(const QString &fileName):
         layout.setSizeConstraint(QLayout::SetFixedSize);
         layout.setSpacing(2);
         layout.setMargin(2);
-        for(int i = 0; i < this->_palette.length(); i++){
+        for(int i = 0; i < SpritePalette::colors.length(); i++){
             QToolButton *colorButton = new QToolButton;
             colorButton->setFixedSize(24, 24);
-            colorButton->setStyleSheet("QToolButton{background:" + QColor(this->_palette[i]).name() + ((this->_palette[i] == this->_currentColor) ? ";" : ";border:none}QToolButton:hover{") + "border:3px inset gray}");
+            colorButton->setStyleSheet("QToolButton{background:" + QColor(SpritePalette::colors[i]).name() + ((i == this->_currentColor) ? ";" : ";border:none}QToolButton:hover{") + "border:3px inset gray}");
             layout.addWidget(colorButton, i / 32, i % 32);
 
             QObject::connect(colorButton, &QToolButton::pressed, [this, colorPicker, i, &dialog](){
-                this->_currentColor = this->_palette[i];
+                this->_currentColor = i;
                 QPixmap colorPixmap(24, 24);
-                colorPixmap.fill(QColor(this->_currentColor));
+                colorPixmap.fill(QColor(SpritePalette::colors[i]));
                 colorPicker->setIcon(QIcon(colorPixmap));
                 dialog.accept();
             });
@@ -336,26 +159,45 @@ QToolBar *SpriteEditor::toolBar(){
 }
 
 bool SpriteEditor::save(const QString &fileName){
-    if(!this->_image.save(fileName, "png")){
+    if(!SpritePalette::save(this->_image, fileName, SpritePalette::compressionLevel())){
         return false;
     }
-    this->_hasUnsavedChanges = false;
+    this->markAsSaved(this->_revision);
     return true;
 }
 
+void SpriteEditor::markAsSaved(quint64 revision){
+    this->_fileIsPalettized = true;
+    if(revision == this->_revision){
+        this->_hasUnsavedChanges = false;
+    }
+}
+
+quint64 SpriteEditor::revision() const{
+    return this->_revision;
+}
+
 bool SpriteEditor::hasUnsavedChanges() const{
     return this->_hasUnsavedChanges;
 }
 
+bool SpriteEditor::matchesFile() const{
+    return !this->_hasUnsavedChanges && this->_fileIsPalettized;
+}
+
+const QImage &SpriteEditor::image() const{
+    return this->_image;
+}
+
 void SpriteEditor::undo(){
     if(!this->undoIsAvailable()){
         return;
     }
 
-    this->_redoHistory.append(this->_image);
-    this->_image = this->_undoHistory.last();
-    this->_undoHistory.removeLast();
-    this->updateImage();
+    this->updatePixels(this->_history.undo(&this->_image));
+    this->_revision++;
+    this->_hasUnsavedChanges = true;    //Only sprites with unsaved changes are saved, so undoing a saved change must be saved too
+    emit this->imageChanged();
 
     emit this->undoAvailable(this->undoIsAvailable());
     emit this->redoAvailable(this->redoIsAvailable());
@@ -366,57 +208,198 @@ void SpriteEditor::redo(){
         return;
     }
 
-    this->_undoHistory.append(this->_image);
-    this->_image = this->_redoHistory.last();
-    this->_redoHistory.removeLast();
-    this->updateImage();
+    this->updatePixels(this->_history.redo(&this->_image));
+    this->_revision++;
+    this->_hasUnsavedChanges = true;
+    emit this->imageChanged();
 
     emit this->undoAvailable(this->undoIsAvailable());
     emit this->redoAvailable(this->redoIsAvailable());
 }
 
 bool SpriteEditor::undoIsAvailable() const{
-    return this->_undoHistory.length() > 0;
+    return this->_history.undoIsAvailable();
 }
 
 bool SpriteEditor::redoIsAvailable() const{
-    return this->_redoHistory.length() > 0;
+    return this->_history.redoIsAvailable();
 }
 
 void SpriteEditor::mousePressEvent(QMouseEvent *event){
     this->_currentlyPressed = true;
-    this->mouseMoveEvent(event);
+    this->_pressedPixel = this->_lastPixel = this->pixelAt(event->pos());
+    this->_shapeRect = QRect();
+    if(this->_tool == RasterTools::FloodFill){
+        //The filled area is only known after filling, so a shallow copy keeps the pixels before the fill, the image is detached from it when the fill writes to it
+        const QImage previous = this->_image;
+        const QRect filled = RasterTools::floodFill(&this->_image, this->_pressedPixel, this->_currentColor);
+        this->_history.save(previous, filled);
+        this->updatePixels(filled);
+    }
+    else{
+        this->mouseMoveEvent(event);
+    }
 }
 
 void SpriteEditor::mouseReleaseEvent(QMouseEvent*){
+    if(!this->_currentlyPressed){
+        return;
+    }
     this->_currentlyPressed = false;
+    if(!this->_history.commit(this->_image)){
+        return;
+    }
+    this->_revision++;
     this->_hasUnsavedChanges = true;
     emit this->imageChanged();
 
-    this->_undoHistory.append(this->_previousImage);
-    this->_previousImage = this->_image;
-    this->updateImage();
-
     emit this->undoAvailable(this->undoIsAvailable());
     emit this->redoAvailable(this->redoIsAvailable());
 }
 
 void SpriteEditor::mouseMoveEvent(QMouseEvent *event){
-    if(this->_currentlyPressed){
-        this->_image.setPixel(event->x() / this->_zoom, event->y() / this->_zoom, this->_palette.indexOf(this->_currentColor));
-        this->updateImage();
+    if(!this->_currentlyPressed){
+        return;
     }
+    const QPoint pixel = this->pixelAt(event->pos());
+    switch(this->_tool){
+    case RasterTools::Pencil:
+        //Mouse events can be several pixels apart, so the pixels in between are drawn too
+        this->_history.save(this->_image, QRect(this->_lastPixel, pixel));
+        this->updatePixels(RasterTools::drawLine(&this->_image, this->_lastPixel, pixel, this->_currentColor));
+        break;
+    case RasterTools::Line:
+    case RasterTools::Rectangle:
+    case RasterTools::FilledRectangle:
+        this->drawShape(pixel);
+        break;
+    default:
+        break;
+    }
+    this->_lastPixel = pixel;
 }
 
 void SpriteEditor::wheelEvent(QWheelEvent *event){
     const int delta = event->angleDelta().y() / 120;
-    this->_zoom = qBound(1, this->_zoom + delta, 10);
-    this->updateImage();
+    const int zoom = qBound(1, this->_zoom + delta, 10);
+    if(zoom == this->_zoom){
+        return;
+    }
+
+    //Keep the pixel under the mouse where it is
+    const QPoint position = event->position().toPoint();
+    const QPointF pixel = QPointF(position + this->offset()) / this->_zoom;
+    this->_zoom = zoom;
+    this->updateZoom();
+    this->horizontalScrollBar()->setValue(qRound(pixel.x() * zoom) - position.x());
+    this->verticalScrollBar()->setValue(qRound(pixel.y() * zoom) - position.y());
+}
+
+void SpriteEditor::paintEvent(QPaintEvent *event){
+    //Only the pixels under the rectangle that has to be painted are converted and scaled, so that painting depends neither on the size of the image nor on the zoom
+    const QPoint offset = this->offset();
+    const QRect area = event->rect().translated(offset);
+    const QRect pixels = QRect(QPoint(area.left() / this->_zoom, area.top() / this->_zoom), QPoint(area.right() / this->_zoom, area.bottom() / this->_zoom)).intersected(this->_image.rect());
+    if(pixels.isEmpty()){
+        return;
+    }
+    const QRect target(pixels.topLeft() * this->_zoom - offset, pixels.size() * this->_zoom);
+    QPainter painter(this->viewport());
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+    QImage visiblePixels = this->_image.copy(pixels);
+    visiblePixels.setColorTable(this->_colorTable);
+    painter.drawImage(target, visiblePixels.convertToFormat(QImage::Format_RGB32));
+
+    //The grid is drawn with lines instead of being part of the image, so it's always one pixel wide
+    if(this->_showGrid->isChecked() && this->_zoom >= 4){
+        QVector<QLine> lines;
+        lines.reserve(pixels.width() + pixels.height() + 2);
+        for(int x = 0; x <= pixels.width(); x++){
+            lines.append(QLine(target.left() + x * this->_zoom, target.top(), target.left() + x * this->_zoom, target.bottom()));
+        }
+        for(int y = 0; y <= pixels.height(); y++){
+            lines.append(QLine(target.left(), target.top() + y * this->_zoom, target.right(), target.top() + y * this->_zoom));
+        }
+        painter.setPen(QColor(128, 128, 128, 128));
+        painter.drawLines(lines);
+    }
+}
+
+void SpriteEditor::resizeEvent(QResizeEvent*){
+    this->updateScrollBars();
+}
+
+void SpriteEditor::scrollContentsBy(int dx, int dy){
+    this->viewport()->scroll(dx, dy);
+}
+
+void SpriteEditor::showEvent(QShowEvent*){
+    if(this->_animatePalette->isChecked()){
+        this->_animationTimer.start();
+    }
+}
+
+void SpriteEditor::hideEvent(QHideEvent*){
+    this->_animationTimer.stop();    //The sprites that aren't visible don't need to be animated
 }
 
-void SpriteEditor::updateImage(){
+void SpriteEditor::updateZoom(){
     this->_zoomIn->setDisabled(this->_zoom >= 10);
     this->_zoomOut->setDisabled(this->_zoom <= 1);
-    this->setPixmap(QPixmap::fromImage(this->_image).scaled(this->_image.width() * this->_zoom, this->_image.height() * this->_zoom));
-    this->setFixedSize(this->_image.width() * this->_zoom, this->_image.height() * this->_zoom);
+    this->updateScrollBars();
+    this->viewport()->update();
+}
+
+void SpriteEditor::updateScrollBars(){
+    const QSize size = this->_image.size() * this->_zoom;
+    const QSize viewportSize = this->viewport()->size();
+    this->horizontalScrollBar()->setRange(0, qMax(0, size.width() - viewportSize.width()));
+    this->horizontalScrollBar()->setPageStep(viewportSize.width());
+    this->horizontalScrollBar()->setSingleStep(this->_zoom * 4);
+    this->verticalScrollBar()->setRange(0, qMax(0, size.height() - viewportSize.height()));
+    this->verticalScrollBar()->setPageStep(viewportSize.height());
+    this->verticalScrollBar()->setSingleStep(this->_zoom * 4);
+}
+
+QPoint SpriteEditor::offset() const{
+    return QPoint(this->horizontalScrollBar()->value(), this->verticalScrollBar()->value());
+}
+
+QPoint SpriteEditor::pixelAt(const QPoint &position) const{
+    //Round towards minus infinity, so that positions just left of or above the image aren't in the first column or row
+    const QPoint point = position + this->offset();
+    return QPoint(qFloor(point.x() / double(this->_zoom)), qFloor(point.y() / double(this->_zoom)));
+}
+
+void SpriteEditor::drawShape(const QPoint &to){
+    //Remove the shape drawn for the previous position of the mouse
+    this->_history.restore(&this->_image, this->_shapeRect);
+    this->_history.save(this->_image, QRect(this->_pressedPixel, to));
+    const QRect previousRect = this->_shapeRect;
+    if(this->_tool == RasterTools::Line){
+        this->_shapeRect = RasterTools::drawLine(&this->_image, this->_pressedPixel, to, this->_currentColor);
+    }
+    else{
+        this->_shapeRect = RasterTools::drawRectangle(&this->_image, QRect(this->_pressedPixel, to), this->_currentColor, this->_tool == RasterTools::FilledRectangle);
+    }
+    this->updatePixels(previousRect | this->_shapeRect);
+}
+
+void SpriteEditor::updateColorTable(){
+    QVector<QRgb> colorTable = PaletteAnimation::colorTable(this->_companyColor);
+    if(this->_animatePalette->isChecked()){
+        PaletteAnimation::animate(&colorTable, this->_animationCounter);
+    }
+    //Most ticks don't change any color, since each cycle only moves every few ticks
+    if(colorTable != this->_colorTable){
+        this->_colorTable = colorTable;
+        this->viewport()->update();
+    }
+}
+
+void SpriteEditor::updatePixels(const QRect &rect){
+    const QRect pixels = rect.intersected(this->_image.rect());
+    if(!pixels.isEmpty()){
+        this->viewport()->update(QRect(pixels.topLeft() * this->_zoom - this->offset(), pixels.size() * this->_zoom));
+    }
 }
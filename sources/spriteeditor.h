@@ -1,21 +1,32 @@
 #ifndef SPRITEEDITOR_H
 #define SPRITEEDITOR_H
 
-#include <QLabel>
+#include <QAbstractScrollArea>
 #include <QImage>
+#include <QTimer>
 #include <QToolBar>
 #include <QMouseEvent>
+#include "paletteanimation.h"
+#include "rastertools.h"
+#include "spritehistory.h"
+#include "spriteloader.h"
 
-class SpriteEditor : public QLabel{
+//Only the 8-bit image is kept in memory: the pixels visible in the viewport are converted and scaled each time they are painted, so the memory doesn't depend on the zoom
+class SpriteEditor : public QAbstractScrollArea{
     Q_OBJECT
 
 public:
     SpriteEditor(const QString &fileName);
+    SpriteEditor(const SpriteLoader::Sprite &sprite);    //For a file that was already decoded, for example by a SpriteLoader
 
     QToolBar *toolBar();
 
     bool save(const QString &fileName);
+    void markAsSaved(quint64 revision);    //For an image saved by someone else, the changes made after the revision that was saved stay unsaved
+    quint64 revision() const;    //Changes each time the image changes
     bool hasUnsavedChanges() const;
+    bool matchesFile() const;    //Returns false if the image has unsaved changes or if the file doesn't use the OpenTTD palette yet
+    const QImage &image() const;
 
     void undo();
     void redo();
@@ -34,21 +45,39 @@ protected:
     void mouseReleaseEvent(QMouseEvent*) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void wheelEvent(QWheelEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void showEvent(QShowEvent*) override;
+    void hideEvent(QHideEvent*) override;
 
 private:
-    void updateImage();
+    void updateZoom();
+    void updateScrollBars();
+    void updatePixels(const QRect &rect);    //Only paints the pixels in the rectangle again, in image coordinates
+    void updateColorTable();    //Paints the image again if the company color or the animation changed its colors
+    QPoint offset() const;    //The position of the viewport in the zoomed image
+    QPoint pixelAt(const QPoint &position) const;    //Returns the pixel of the image under a position in the viewport, which can be outside the image
+    void drawShape(const QPoint &to);    //Draws the line or rectangle of the current tool from the position where the mouse was pressed
 
     QToolBar _toolBar;
-    QImage _image, _previousImage;
-    QList<QImage> _undoHistory, _redoHistory;
-    QAction *const _zoomIn, *const _zoomOut;
+    QImage _image;
+    SpriteHistory _history;
+    QAction *const _zoomIn, *const _zoomOut, *const _showGrid, *const _animatePalette;
+    QVector<QRgb> _colorTable;    //The colors the image is shown with, the image itself always keeps the OpenTTD palette
+    PaletteAnimation::CompanyColor _companyColor;
+    QTimer _animationTimer;
+    uint _animationCounter;
 
     int _zoom;
-    QRgb _currentColor;
+    uchar _currentColor;    //The index of the color in the palette
+    RasterTools::Tool _tool;
+    QPoint _pressedPixel, _lastPixel;
+    QRect _shapeRect;    //The pixels changed by the line or rectangle that is being drawn, which are restored from the history when the mouse moves
     bool _currentlyPressed;
+    quint64 _revision;
     bool _hasUnsavedChanges;
-
-    static const QVector<QRgb> _palette;
+    bool _fileIsPalettized;
 };
 
 #endif // SPRITEEDITOR_H
@@ -0,0 +1,263 @@
+#include <QSettings>
+#include <cstring>
+#include "spritehistory.h"
+
+SpriteHistory::SpriteHistory():
+    _size(0)
+{
+    shared().histories.append(this);
+}
+
+SpriteHistory::~SpriteHistory(){
+    shared().totalSize -= this->_size;
+    shared().histories.removeOne(this);
+}
+
+void SpriteHistory::save(const QImage &image, const QRect &rect){
+    const QRect clipped = rect.normalized().intersected(image.rect());
+    if(clipped.isEmpty()){
+        return;
+    }
+    const int tilesPerRow = (image.width() + tileSize - 1) / tileSize;
+    for(int y = clipped.top() / tileSize; y <= clipped.bottom() / tileSize; y++){
+        for(int x = clipped.left() / tileSize; x <= clipped.right() / tileSize; x++){
+            const int index = y * tilesPerRow + x;
+            if(!this->_savedTiles.contains(index)){
+                this->_savedTiles.insert(index, readTile(image, index));
+            }
+        }
+    }
+}
+
+void SpriteHistory::restore(QImage *image, const QRect &rect) const{
+    const QRect clipped = rect.normalized().intersected(image->rect());
+    if(clipped.isEmpty()){
+        return;
+    }
+    const int tilesPerRow = (image->width() + tileSize - 1) / tileSize;
+    for(int y = clipped.top() / tileSize; y <= clipped.bottom() / tileSize; y++){
+        for(int x = clipped.left() / tileSize; x <= clipped.right() / tileSize; x++){
+            const auto tile = this->_savedTiles.constFind(y * tilesPerRow + x);
+            if(tile == this->_savedTiles.constEnd()){
+                continue;
+            }
+            const QRect rect = tileRect(*image, tile.key());
+            const QRect part = rect.intersected(clipped);
+            for(int row = part.top(); row <= part.bottom(); row++){
+                std::memcpy(image->scanLine(row) + part.left(), tile.value().constData() + (row - rect.top()) * rect.width() + (part.left() - rect.left()), part.width());
+            }
+        }
+    }
+}
+
+bool SpriteHistory::commit(const QImage &image){
+    Entry entry{{}, 0, 0};
+    for(auto tile = this->_savedTiles.constBegin(); tile != this->_savedTiles.constEnd(); tile++){
+        if(readTile(image, tile.key()) != tile.value()){
+            const QByteArray data = compress(reinterpret_cast<const uchar*>(tile.value().constData()), tile.value().size());
+            entry.tiles.append({tile.key(), data});
+            entry.size += data.size();
+        }
+    }
+    this->_savedTiles.clear();
+    if(entry.tiles.isEmpty()){
+        return false;
+    }
+
+    //A new change makes the changes that were undone unreachable
+    while(!this->_redoEntries.isEmpty()){
+        this->removeFirst(&this->_redoEntries);
+    }
+    this->append(&this->_undoEntries, entry);
+    enforceBudgets(this);
+    return true;
+}
+
+QRect SpriteHistory::undo(QImage *image){
+    return this->swap(image, &this->_undoEntries, &this->_redoEntries);
+}
+
+QRect SpriteHistory::redo(QImage *image){
+    return this->swap(image, &this->_redoEntries, &this->_undoEntries);
+}
+
+bool SpriteHistory::undoIsAvailable() const{
+    return !this->_undoEntries.isEmpty();
+}
+
+bool SpriteHistory::redoIsAvailable() const{
+    return !this->_redoEntries.isEmpty();
+}
+
+qint64 SpriteHistory::size() const{
+    return this->_size;
+}
+
+qint64 SpriteHistory::totalSize(){
+    return shared().totalSize;
+}
+
+void SpriteHistory::setBudgets(qint64 spriteBudget, qint64 totalBudget){
+    shared().spriteBudget = spriteBudget;
+    shared().totalBudget = totalBudget;
+    enforceBudgets(nullptr);
+}
+
+QByteArray SpriteHistory::compress(const uchar *data, int length){
+    //A header byte n < 128 is followed by n + 1 literal bytes, a header byte n >= 128 by one byte that is repeated 257 - n times
+    QByteArray result;
+    result.reserve(length / 4 + 2);
+    int i = 0;
+    while(i < length){
+        int run = 1;
+        while(i + run < length && run < 129 && data[i + run] == data[i]){
+            run++;
+        }
+        if(run >= 2){
+            result.append(char(257 - run));
+            result.append(char(data[i]));
+            i += run;
+            continue;
+        }
+
+        //Collect literal bytes until the next run of at least 3 bytes, since a run of 2 bytes doesn't make the literal shorter
+        int literal = 1;
+        while(i + literal < length && literal < 128 && !(i + literal + 2 < length && data[i + literal] == data[i + literal + 1] && data[i + literal] == data[i + literal + 2])){
+            literal++;
+        }
+        result.append(char(literal - 1));
+        result.append(reinterpret_cast<const char*>(data + i), literal);
+        i += literal;
+    }
+    return result;
+}
+
+void SpriteHistory::decompress(const QByteArray &data, uchar *result, int length){
+    const uchar *input = reinterpret_cast<const uchar*>(data.constData());
+    const uchar *end = input + data.size();
+    int position = 0;
+    while(input < end && position < length){
+        const int header = *input++;
+        if(header < 128){
+            const int count = qMin(header + 1, qMin(int(end - input), length - position));
+            std::memcpy(result + position, input, count);
+            input += count;
+            position += count;
+        }
+        else if(input < end){
+            const int count = qMin(257 - header, length - position);
+            std::memset(result + position, *input++, count);
+            position += count;
+        }
+    }
+}
+
+SpriteHistory::Shared &SpriteHistory::shared(){
+    static Shared shared{
+        QSettings("OpenTTD", "NMLCreator").value("spriteEditor/undoBudget", 64).toLongLong() * 1024 * 1024,
+        QSettings("OpenTTD", "NMLCreator").value("spriteEditor/totalUndoBudget", 256).toLongLong() * 1024 * 1024,
+        0,
+        0,
+        {}
+    };
+    return shared;
+}
+
+QRect SpriteHistory::tileRect(const QImage &image, int index){
+    const int tilesPerRow = (image.width() + tileSize - 1) / tileSize;
+    return QRect((index % tilesPerRow) * tileSize, (index / tilesPerRow) * tileSize, tileSize, tileSize).intersected(image.rect());
+}
+
+QByteArray SpriteHistory::readTile(const QImage &image, int index){
+    const QRect rect = tileRect(image, index);
+    QByteArray data(rect.width() * rect.height(), Qt::Uninitialized);
+    for(int y = 0; y < rect.height(); y++){
+        std::memcpy(data.data() + y * rect.width(), image.constScanLine(rect.top() + y) + rect.left(), rect.width());
+    }
+    return data;
+}
+
+void SpriteHistory::writeTile(QImage *image, int index, const QByteArray &data){
+    const QRect rect = tileRect(*image, index);
+    for(int y = 0; y < rect.height(); y++){
+        std::memcpy(image->scanLine(rect.top() + y) + rect.left(), data.constData() + y * rect.width(), rect.width());
+    }
+}
+
+QRect SpriteHistory::swap(QImage *image, QList<Entry> *from, QList<Entry> *to){
+    if(from->isEmpty()){
+        return QRect();
+    }
+    const Entry entry = from->last();
+    this->_size -= entry.size;
+    shared().totalSize -= entry.size;
+    from->removeLast();
+
+    Entry reverse{{}, 0, entry.serial};
+    reverse.tiles.reserve(entry.tiles.length());
+    QRect changed;
+    QByteArray tile;
+    for(const Tile &saved: entry.tiles){
+        const QByteArray current = readTile(*image, saved.index);
+        const QByteArray data = compress(reinterpret_cast<const uchar*>(current.constData()), current.size());
+        reverse.tiles.append({saved.index, data});
+        reverse.size += data.size();
+
+        tile.resize(current.size());
+        decompress(saved.data, reinterpret_cast<uchar*>(tile.data()), tile.size());
+        writeTile(image, saved.index, tile);
+        changed |= tileRect(*image, saved.index);
+    }
+    this->append(to, reverse);
+    enforceBudgets(this);
+    return changed;
+}
+
+void SpriteHistory::append(QList<Entry> *entries, const Entry &entry){
+    entries->append(entry);
+    if(entries->last().serial == 0){
+        entries->last().serial = ++shared().nextSerial;
+    }
+    this->_size += entry.size;
+    shared().totalSize += entry.size;
+}
+
+void SpriteHistory::removeFirst(QList<Entry> *entries){
+    this->_size -= entries->first().size;
+    shared().totalSize -= entries->first().size;
+    entries->removeFirst();
+}
+
+void SpriteHistory::enforceBudgets(SpriteHistory *current){
+    //The oldest changes are forgotten first, but the last change of a sprite can always be undone
+    const Shared &budgets = shared();
+    //The redo entries aren't forgotten, they are removed anyway by the next change
+    const auto trim = [](SpriteHistory *history, qint64 budget){
+        while(history->_size > budget && history->_undoEntries.length() > 1){
+            history->removeFirst(&history->_undoEntries);
+        }
+    };
+    if(budgets.spriteBudget > 0){
+        if(current != nullptr){
+            trim(current, budgets.spriteBudget);
+        }
+        else{
+            for(SpriteHistory *history: budgets.histories){
+                trim(history, budgets.spriteBudget);
+            }
+        }
+    }
+
+    while(budgets.totalBudget > 0 && budgets.totalSize > budgets.totalBudget){
+        SpriteHistory *oldest = nullptr;
+        for(SpriteHistory *history: budgets.histories){
+            if(history->_undoEntries.length() > 1 && (oldest == nullptr || history->_undoEntries.first().serial < oldest->_undoEntries.first().serial)){
+                oldest = history;
+            }
+        }
+        if(oldest == nullptr){
+            break;
+        }
+        oldest->removeFirst(&oldest->_undoEntries);
+    }
+}
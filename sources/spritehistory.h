@@ -0,0 +1,68 @@
+#ifndef SPRITEHISTORY_H
+#define SPRITEHISTORY_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QVector>
+
+//The undo and redo history of a sprite editor, which only stores the tiles of the image that a change modified, compressed with run-length encoding
+//Before pixels are changed, save() keeps a copy of the tiles they are in, and commit() turns the tiles that really changed into an undo entry
+//The oldest entries are forgotten when the history of a sprite or the histories of all the sprites together use more memory than their budget, except the last change of each sprite
+class SpriteHistory{
+public:
+    static const int tileSize = 32;
+
+    SpriteHistory();
+    ~SpriteHistory();
+
+    void save(const QImage &image, const QRect &rect);    //Must be called before the pixels in the rectangle are changed
+    void restore(QImage *image, const QRect &rect) const;    //Restores the pixels in the rectangle to what they were before the change, they must have been saved
+    bool commit(const QImage &image);    //Ends the change, returns false if no pixel changed
+
+    QRect undo(QImage *image);    //Returns the rectangle of the pixels that may have changed
+    QRect redo(QImage *image);
+    bool undoIsAvailable() const;
+    bool redoIsAvailable() const;
+
+    qint64 size() const;    //The memory used by the entries, in bytes
+    static qint64 totalSize();
+    static void setBudgets(qint64 spriteBudget, qint64 totalBudget);    //In bytes, 0 means unlimited
+
+    static QByteArray compress(const uchar *data, int length);    //PackBits run-length encoding
+    static void decompress(const QByteArray &data, uchar *result, int length);
+
+private:
+    struct Tile{
+        int index;
+        QByteArray data;
+    };
+    struct Entry{
+        QVector<Tile> tiles;
+        qint64 size;
+        quint64 serial;    //Entries with smaller serials are older, also between sprites
+    };
+    struct Shared{
+        qint64 spriteBudget;
+        qint64 totalBudget;
+        qint64 totalSize;
+        quint64 nextSerial;
+        QList<SpriteHistory*> histories;
+    };
+
+    static Shared &shared();
+    static QRect tileRect(const QImage &image, int index);
+    static QByteArray readTile(const QImage &image, int index);
+    static void writeTile(QImage *image, int index, const QByteArray &data);
+
+    QRect swap(QImage *image, QList<Entry> *from, QList<Entry> *to);    //Restores the last entry of from and moves the current pixels of its tiles to to
+    void append(QList<Entry> *entries, const Entry &entry);
+    void removeFirst(QList<Entry> *entries);
+    static void enforceBudgets(SpriteHistory *current);
+
+    QHash<int, QByteArray> _savedTiles;    //The uncompressed tiles before the change, by index
+    QList<Entry> _undoEntries, _redoEntries;
+    qint64 _size;
+};
+
+#endif // SPRITEHISTORY_H
@@ -0,0 +1,91 @@
+#include <QtConcurrent>
+#include "spriteloader.h"
+#include "spritepalette.h"
+
+SpriteLoader::SpriteLoader(QObject *parent):
+    QObject(parent),
+    _done(0),
+    _total(0)
+{
+    //The files are decoded on their own pool, so that the conversion of each image can still split it into bands on the global thread pool
+    this->_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+void SpriteLoader::load(const QString &fileName, bool urgent){
+    if(this->_running.contains(fileName)){
+        return;
+    }
+    if(this->_queue.contains(fileName)){
+        if(urgent){
+            this->_queue.removeOne(fileName);
+            this->_queue.prepend(fileName);
+        }
+        return;
+    }
+
+    if(urgent){
+        this->_queue.prepend(fileName);
+    }
+    else{
+        this->_queue.append(fileName);
+    }
+    this->_total++;
+    emit this->progress(this->_done, this->_total);
+    this->startNext();
+}
+
+void SpriteLoader::cancel(){
+    this->_queue.clear();
+    for(QFutureWatcher<Sprite> *watcher: qAsConst(this->_running)){
+        watcher->disconnect(this);
+        watcher->deleteLater();
+    }
+    this->_running.clear();
+    this->_done = 0;
+    this->_total = 0;
+    emit this->progress(0, 0);
+}
+
+bool SpriteLoader::isLoading(const QString &fileName) const{
+    return this->_running.contains(fileName) || this->_queue.contains(fileName);
+}
+
+bool SpriteLoader::isIdle() const{
+    return this->_running.isEmpty() && this->_queue.isEmpty();
+}
+
+SpriteLoader::Sprite SpriteLoader::decode(const QString &fileName){
+    const QImage image(fileName);
+    return {SpritePalette::convert(image), SpritePalette::isPalettized(image)};
+}
+
+void SpriteLoader::startNext(){
+    //The queue is kept here instead of in the thread pool, so that the order of the files that haven't started can still change
+    while(!this->_queue.isEmpty() && this->_running.size() < this->_threadPool.maxThreadCount()){
+        const QString fileName = this->_queue.takeFirst();
+        QFutureWatcher<Sprite> *watcher = new QFutureWatcher<Sprite>(this);
+        QObject::connect(watcher, &QFutureWatcher<Sprite>::finished, this, [this, fileName](){
+            this->finish(fileName);
+        });
+        watcher->setFuture(QtConcurrent::run(&this->_threadPool, &SpriteLoader::decode, fileName));
+        this->_running.insert(fileName, watcher);
+    }
+}
+
+void SpriteLoader::finish(const QString &fileName){
+    QFutureWatcher<Sprite> *watcher = this->_running.take(fileName);
+    if(watcher == nullptr){
+        return;
+    }
+    const Sprite sprite = watcher->result();
+    watcher->deleteLater();
+
+    this->_done++;
+    emit this->loaded(fileName, sprite);
+    if(this->isIdle()){
+        this->_done = 0;
+        this->_total = 0;
+    }
+    emit this->progress(this->_done, this->_total);
+    this->startNext();
+}
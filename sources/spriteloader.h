@@ -0,0 +1,46 @@
+#ifndef SPRITELOADER_H
+#define SPRITELOADER_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QMap>
+#include <QStringList>
+#include <QThreadPool>
+
+//Decodes image files and converts them to the OpenTTD palette on a thread pool, and delivers the results on the thread the loader lives in
+//The files are started in the order they were added, except the ones that are needed urgently, for example because the user opened them
+class SpriteLoader : public QObject{
+    Q_OBJECT
+
+public:
+    struct Sprite{
+        QImage image;    //8-bit with the OpenTTD palette, null if the file couldn't be read
+        bool fileIsPalettized;    //Whether the file itself already uses the OpenTTD palette
+    };
+
+    SpriteLoader(QObject *parent = nullptr);
+
+    void load(const QString &fileName, bool urgent = false);    //If the file is already waiting, urgent moves it to the front of the queue
+    void cancel();    //Forgets the waiting files, the files that are being decoded finish but aren't delivered
+    bool isLoading(const QString &fileName) const;    //Returns true if the file is waiting or being decoded
+    bool isIdle() const;
+
+    static Sprite decode(const QString &fileName);    //Decodes the file on the calling thread
+
+signals:
+    void loaded(const QString &fileName, const SpriteLoader::Sprite &sprite);
+    void progress(int done, int total);    //The files delivered and added since the loader was last idle
+
+private:
+    void startNext();
+    void finish(const QString &fileName);
+
+    QThreadPool _threadPool;
+    QStringList _queue;
+    QMap<QString, QFutureWatcher<Sprite>*> _running;
+    int _done;
+    int _total;
+};
+
+#endif // SPRITELOADER_H
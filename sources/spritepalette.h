@@ -0,0 +1,19 @@
+#ifndef SPRITEPALETTE_H
+#define SPRITEPALETTE_H
+
+#include <QImage>
+#include <QVector>
+
+class SpritePalette{
+public:
+    static QImage convert(const QImage &image);    //Returns the image as an 8-bit image using the OpenTTD palette, with the options of PaletteQuantizer in the settings
+    static bool isPalettized(const QImage &image);
+    static bool fileIsPalettized(const QString &fileName);    //Only reads the header and the palette of a PNG file, not the pixels, gives the same result as isPalettized() on the decoded file
+    static bool applyToFile(const QString &fileName);    //Converts the file to the OpenTTD palette if it isn't already, returns false if the file can't be read or written
+    static bool save(const QImage &image, const QString &fileName, int compressionLevel);    //Writes the image as an 8-bit PNG file with the OpenTTD palette, the file is only replaced once it's completely written
+    static int compressionLevel();    //The zlib compression level of the saved sprites in the settings, from 0 (fastest) to 9 (smallest)
+
+    static const QVector<QRgb> colors;
+};
+
+#endif // SPRITEPALETTE_H
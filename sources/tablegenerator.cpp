@@ -0,0 +1,246 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include "tablegenerator.h"
+
+TableGenerator::TableGenerator(const QString &nmlFile):
+    _nmlFile(nmlFile),
+    _rows(0),
+    _renderedRows(0)
+{}
+
+bool TableGenerator::generate(){
+    this->_errors.clear();
+    this->_writtenFiles.clear();
+    this->_rows = 0;
+    this->_renderedRows = 0;
+
+    const QList<Table> tables = TableGenerator::tables(this->_nmlFile);
+    QStringList tableFiles;
+    for(const Table &table: tables){
+        tableFiles.append(table.tableFile);
+        this->generateTable(table);
+    }
+
+    //Forget the tables that were removed
+    for(const QString &tableFile: this->_cache.keys()){
+        if(!tableFiles.contains(tableFile)){
+            this->_cache.remove(tableFile);
+        }
+    }
+    return this->_errors.isEmpty();
+}
+
+QList<Preprocessor::Error> TableGenerator::errors() const{
+    return this->_errors;
+}
+
+QStringList TableGenerator::writtenFiles() const{
+    return this->_writtenFiles;
+}
+
+int TableGenerator::rows() const{
+    return this->_rows;
+}
+
+int TableGenerator::renderedRows() const{
+    return this->_renderedRows;
+}
+
+QList<TableGenerator::Table> TableGenerator::tables(const QString &nmlFile){
+    const QDir projectDir = QFileInfo(nmlFile).absoluteDir();
+    const QDir tablesDir(projectDir.filePath("tables"));
+    QList<Table> tables;
+    for(const QFileInfo &tableFile: tablesDir.entryInfoList({"*.csv", "*.tsv"}, QDir::Files, QDir::Name)){
+        tables.append({tableFile.absoluteFilePath(), tablesDir.filePath(tableFile.completeBaseName() + ".template"), projectDir.filePath("generated/" + tableFile.completeBaseName() + ".pnml")});
+    }
+    return tables;
+}
+
+QList<QStringList> TableGenerator::parse(const QString &text, QChar separator, QList<int> *lines, QStringList *records){
+    QList<QStringList> rows;
+    QStringList row;
+    QString field;
+    bool quoted = false, fieldStarted = false;
+    int line = 1, rowLine = 1, rowStart = 0;
+
+    const auto endRow = [&](int end){
+        row.append(field);
+        //Lines that are completely empty aren't rows
+        if(row.length() > 1 || !row.first().isEmpty() || fieldStarted){
+            rows.append(row);
+            if(lines != nullptr){
+                lines->append(rowLine);
+            }
+            if(records != nullptr){
+                records->append(text.mid(rowStart, end - rowStart));
+            }
+        }
+        row.clear();
+        field.clear();
+        fieldStarted = false;
+    };
+
+    for(int i = 0; i < text.length(); i++){
+        const QChar c = text[i];
+        if(quoted){
+            if(c == '"' && i + 1 < text.length() && text[i + 1] == '"'){
+                field += '"';
+                i++;
+            }
+            else if(c == '"'){
+                quoted = false;
+            }
+            else{
+                line += (c == '\n');
+                field += c;
+            }
+        }
+        else if(c == '"' && field.isEmpty()){
+            quoted = true;
+            fieldStarted = true;
+        }
+        else if(c == separator){
+            row.append(field);
+            field.clear();
+            fieldStarted = true;
+        }
+        else if(c == '\n' || c == '\r'){
+            endRow(i);
+            if(c == '\r' && i + 1 < text.length() && text[i + 1] == '\n'){
+                i++;
+            }
+            line++;
+            rowLine = line;
+            rowStart = i + 1;
+        }
+        else{
+            field += c;
+        }
+    }
+    if(!field.isEmpty() || !row.isEmpty() || fieldStarted){
+        endRow(text.length());
+    }
+    return rows;
+}
+
+bool TableGenerator::generateTable(const Table &table){
+    const auto readFile = [this](const QString &fileName, QString *content){
+        QFile file(fileName);
+        if(!file.open(QFile::ReadOnly)){
+            this->_errors.append({fileName, 0, QObject::tr("Could not open file %1.").arg(fileName)});
+            return false;
+        }
+        *content = QString::fromUtf8(file.readAll());
+        return true;
+    };
+    if(!QFileInfo::exists(table.templateFile)){
+        this->_errors.append({table.tableFile, 0, QObject::tr("The table %1 doesn't have a template, please create the file %2.").arg(QFileInfo(table.tableFile).fileName(), table.templateFile)});
+        return false;
+    }
+    QString tableText, templateText;
+    if(!readFile(table.tableFile, &tableText) || !readFile(table.templateFile, &templateText)){
+        return false;
+    }
+
+    QList<int> lines;
+    QStringList records;
+    const QList<QStringList> rows = parse(tableText, (QFileInfo(table.tableFile).suffix().toLower() == "tsv") ? '\t' : ',', &lines, &records);
+    if(rows.isEmpty()){
+        this->_errors.append({table.tableFile, 0, QObject::tr("The table %1 doesn't contain the names of the columns.").arg(QFileInfo(table.tableFile).fileName())});
+        return false;
+    }
+    QStringList header;
+    for(const QString &name: rows.first()){
+        header.append(name.trimmed());
+    }
+
+    //The generated code of the rows can only be reused if the template and the columns didn't change
+    Cache &cache = this->_cache[table.tableFile];
+    if(cache.templateText != templateText || cache.header != header){
+        cache.templateText = templateText;
+        cache.header = header;
+        cache.rows.clear();
+    }
+    Template compiledTemplate;
+    if(!this->compileTemplate(table, templateText, header, &compiledTemplate)){
+        cache.templateText.clear();
+        return false;
+    }
+
+    const QString tableName = QFileInfo(table.tableFile).fileName();
+    QHash<QString, QString> usedRows;
+    QString output = "// " + QObject::tr("Generated by NMLCreator from %1 and %2, changes to this file are overwritten.").arg(tableName, QFileInfo(table.templateFile).fileName()) + "\n";
+    bool failed = false;
+    for(int i = 1; i < rows.length(); i++){
+        const QStringList &row = rows[i];
+        if(row.length() != header.length()){
+            this->_errors.append({table.tableFile, lines[i], QObject::tr("This row has %1 columns instead of %2.").arg(row.length()).arg(header.length())});
+            failed = true;
+            continue;
+        }
+
+        //Rows are found by their text, so a row that only moved to another line is reused too
+        auto cached = cache.rows.constFind(records[i]);
+        QString code;
+        if(cached != cache.rows.constEnd()){
+            code = cached.value();
+        }
+        else{
+            code = compiledTemplate.literals.first();
+            for(int j = 0; j < compiledTemplate.columns.length(); j++){
+                code += row[compiledTemplate.columns[j]] + compiledTemplate.literals[j + 1];
+            }
+            this->_renderedRows++;
+        }
+        usedRows.insert(records[i], code);
+        output += "\n// " + tableName + ", " + QObject::tr("line %1").arg(lines[i]) + "\n" + code;
+        if(!code.endsWith("\n")){
+            output += "\n";
+        }
+    }
+    this->_rows += rows.length() - 1;
+    cache.rows = usedRows;
+    if(failed){
+        return false;
+    }
+
+    //Only write the file if it changed, so that the preprocessor and the compiler can reuse what they did with it before
+    const QByteArray data = output.toUtf8();
+    QFile existingFile(table.outputFile);
+    if(existingFile.open(QFile::ReadOnly) && existingFile.size() == data.size() && existingFile.readAll() == data){
+        return true;
+    }
+    existingFile.close();
+    QDir(QFileInfo(table.outputFile).path()).mkpath(".");
+    QSaveFile outputFile(table.outputFile);
+    if(!outputFile.open(QFile::WriteOnly) || outputFile.write(data) != data.size() || !outputFile.commit()){
+        this->_errors.append({table.outputFile, 0, QObject::tr("Could not write the file %1.").arg(table.outputFile)});
+        return false;
+    }
+    this->_writtenFiles.append(table.outputFile);
+    return true;
+}
+
+bool TableGenerator::compileTemplate(const Table &table, const QString &text, const QStringList &header, Template *result){
+    const QRegularExpression placeholder("\\{\\{\\s*([^{}]*?)\\s*\\}\\}");
+    QRegularExpressionMatchIterator matches = placeholder.globalMatch(text);
+    int position = 0;
+    bool ok = true;
+    while(matches.hasNext()){
+        const QRegularExpressionMatch match = matches.next();
+        const int column = header.indexOf(match.captured(1));
+        if(column < 0){
+            this->_errors.append({table.templateFile, text.leftRef(match.capturedStart()).count('\n') + 1, QObject::tr("The table %1 doesn't have a column named %2.").arg(QFileInfo(table.tableFile).fileName(), match.captured(1))});
+            ok = false;
+        }
+        result->literals.append(text.mid(position, match.capturedStart() - position));
+        result->columns.append(column);
+        position = match.capturedEnd();
+    }
+    result->literals.append(text.mid(position));
+    return ok;
+}
@@ -0,0 +1,53 @@
+#ifndef TABLEGENERATOR_H
+#define TABLEGENERATOR_H
+
+#include <QHash>
+#include <QStringList>
+#include "preprocessor.h"
+
+//Generates NML code from the tables in the "tables" folder of a project: each row of tables/X.csv (or tables/X.tsv) is written with the template tables/X.template to generated/X.pnml, which can be included with #include
+//In the template, {{column}} is replaced by the value of the column in the row, the first row of the table contains the names of the columns
+//The rows that didn't change since the previous generation aren't written again, and the generated file is only written if its contents changed
+class TableGenerator{
+public:
+    struct Table{
+        QString tableFile;
+        QString templateFile;
+        QString outputFile;
+    };
+
+    TableGenerator(const QString &nmlFile);
+
+    bool generate();    //Generates the files of all the tables, returns false if there were errors
+    QList<Preprocessor::Error> errors() const;    //The errors of the last call to generate(), in the same format as the errors of the preprocessor
+    QStringList writtenFiles() const;    //The generated files that changed during the last call to generate()
+    int rows() const;    //The number of rows in all the tables during the last call to generate()
+    int renderedRows() const;    //The number of rows that had to be written with their template again during the last call to generate()
+
+    static QList<Table> tables(const QString &nmlFile);
+    static QList<QStringList> parse(const QString &text, QChar separator, QList<int> *lines = nullptr, QStringList *records = nullptr);    //Parses a CSV or TSV file, lines receives the line each row starts on and records the text of each row
+
+private:
+    //The template split at the placeholders, literals has one more element than columns
+    struct Template{
+        QStringList literals;
+        QList<int> columns;
+    };
+    struct Cache{
+        QString templateText;
+        QStringList header;
+        QHash<QString, QString> rows;    //The generated code of each row, by the text of the row
+    };
+
+    bool generateTable(const Table &table);
+    bool compileTemplate(const Table &table, const QString &text, const QStringList &header, Template *result);
+
+    const QString _nmlFile;
+    QHash<QString, Cache> _cache;    //By table file
+    QList<Preprocessor::Error> _errors;
+    QStringList _writtenFiles;
+    int _rows;
+    int _renderedRows;
+};
+
+#endif // TABLEGENERATOR_H
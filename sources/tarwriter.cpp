@@ -0,0 +1,98 @@
+#include <QObject>
+#include <cstring>
+#include "tarwriter.h"
+
+TarWriter::TarWriter(QIODevice *device):
+    _device(device)
+{}
+
+bool TarWriter::addDirectory(const QString &name, const QDateTime &modified){
+    return this->writeHeader(name.endsWith("/") ? name : name + "/", '5', 0, modified);
+}
+
+bool TarWriter::addFile(const QString &name, QIODevice *source, qint64 size, const QDateTime &modified, const std::function<void(const QByteArray&)> &inspect){
+    if(!this->writeHeader(name, '0', size, modified)){
+        return false;
+    }
+
+    qint64 remaining = size;
+    while(remaining > 0){
+        const QByteArray block = source->read(qMin<qint64>(remaining, 64 * 1024));
+        if(block.isEmpty()){
+            this->_errorString = QObject::tr("Could not read the file %1.").arg(name);
+            return false;
+        }
+        if(inspect){
+            inspect(block);
+        }
+        if(!this->write(block)){
+            return false;
+        }
+        remaining -= block.size();
+    }
+
+    //The contents of each file are padded to a multiple of 512 bytes
+    return this->write(QByteArray((512 - size % 512) % 512, '\0'));
+}
+
+bool TarWriter::finish(){
+    return this->write(QByteArray(1024, '\0'));    //The archive ends with two empty blocks
+}
+
+QString TarWriter::errorString() const{
+    return this->_errorString;
+}
+
+bool TarWriter::writeHeader(const QString &name, char type, qint64 size, const QDateTime &modified){
+    QByteArray header(512, '\0');
+    char *data = header.data();
+
+    //Long names are split between the prefix and the name fields at a slash
+    const QByteArray path = name.toUtf8();
+    QByteArray prefix, fileName = path;
+    if(path.size() > 100){
+        const int slash = path.lastIndexOf('/', qMin(155, path.size() - 2));
+        if(slash <= 0 || path.size() - slash - 1 > 100){
+            this->_errorString = QObject::tr("The file name %1 is too long.").arg(name);
+            return false;
+        }
+        prefix = path.left(slash);
+        fileName = path.mid(slash + 1);
+    }
+
+    std::memcpy(data, fileName.constData(), fileName.size());
+    writeOctal(data + 100, 8, (type == '5') ? 0755 : 0644);    //Mode
+    writeOctal(data + 108, 8, 0);    //Owner
+    writeOctal(data + 116, 8, 0);    //Group
+    writeOctal(data + 124, 12, size);
+    writeOctal(data + 136, 12, modified.toSecsSinceEpoch());
+    std::memset(data + 148, ' ', 8);    //The checksum is computed with its own field filled with spaces
+    data[156] = type;
+    std::memcpy(data + 257, "ustar", 6);
+    std::memcpy(data + 263, "00", 2);
+    std::memcpy(data + 345, prefix.constData(), prefix.size());
+
+    unsigned int checksum = 0;
+    for(int i = 0; i < header.size(); i++){
+        checksum += static_cast<unsigned char>(header[i]);
+    }
+    writeOctal(data + 148, 7, checksum);
+    data[155] = ' ';
+
+    return this->write(header);
+}
+
+bool TarWriter::write(const QByteArray &data){
+    if(this->_device->write(data) != data.size()){
+        this->_errorString = this->_device->errorString();
+        return false;
+    }
+    return true;
+}
+
+void TarWriter::writeOctal(char *field, int length, qint64 value){
+    //The value is written with leading zeros and followed by a null byte
+    const QByteArray octal = QByteArray::number(value, 8).rightJustified(length - 1, '0');
+    std::memcpy(field, octal.constData(), length - 1);
+    field[length - 1] = '\0';
+}
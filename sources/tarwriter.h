@@ -0,0 +1,30 @@
+#ifndef TARWRITER_H
+#define TARWRITER_H
+
+#include <QIODevice>
+#include <QDateTime>
+#include <functional>
+
+//Writes a tar archive in the ustar format, which is the format OpenTTD and BaNaNaS read
+//Files are copied to the archive in small blocks as they are read, so the archive is never kept in memory
+class TarWriter{
+public:
+    TarWriter(QIODevice *device);    //device must already be open for writing
+
+    bool addDirectory(const QString &name, const QDateTime &modified);
+    //Copies size bytes of source to the archive, inspect is called with every block that is copied, for example to compute a checksum
+    bool addFile(const QString &name, QIODevice *source, qint64 size, const QDateTime &modified, const std::function<void(const QByteArray&)> &inspect = nullptr);
+    bool finish();    //Writes the end of the archive, the device isn't closed
+
+    QString errorString() const;
+
+private:
+    bool writeHeader(const QString &name, char type, qint64 size, const QDateTime &modified);
+    bool write(const QByteArray &data);
+    static void writeOctal(char *field, int length, qint64 value);
+
+    QIODevice *const _device;
+    QString _errorString;
+};
+
+#endif // TARWRITER_H
@@ -1,6 +1,7 @@
 #include <QSettings>
 #include <QMimeData>
 #include <QScrollBar>
+#include <QToolTip>
 #include <QRegularExpression>
 #include "texteditor.h"
 
@@ -73,6 +74,13 @@ void TextEditor::removeWarning(int line){
     this->highlightCurrentLine();
 }
 
+void TextEditor::setHotSpots(const QMap<int, QString> &hotSpots){
+    if(hotSpots != this->_hotSpots){
+        this->_hotSpots = hotSpots;
+        this->_lineNumberArea.update();
+    }
+}
+
 void TextEditor::removeAllErrors(){
     this->_linesWithErrors.clear();
     this->highlightCurrentLine();
@@ -122,6 +130,9 @@ void TextEditor::LineNumberArea::paintEvent(QPaintEvent *event){
 
     while(block.isValid() && top <= event->rect().bottom()){
         if(block.isVisible() && bottom >= event->rect().top()){
+            if(this->_textEditor->_hotSpots.contains(blockNumber + 1)){
+                painter.fillRect(0, top, 3, bottom - top, QColor(255, 128, 0));
+            }
             painter.setPen(Qt::black);
             painter.drawText(0, top, this->width(), this->_textEditor->fontMetrics().height(), Qt::AlignRight, QString::number(blockNumber + 1));
             const int imageSize = qMin(this->_textEditor->lineNumberAreaWidth(), this->_textEditor->fontMetrics().height());
@@ -141,6 +152,22 @@ void TextEditor::LineNumberArea::paintEvent(QPaintEvent *event){
     }
 }
 
+bool TextEditor::LineNumberArea::event(QEvent *event){
+    if(event->type() == QEvent::ToolTip){
+        const QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+        const int line = this->_textEditor->cursorForPosition(QPoint(0, helpEvent->pos().y())).blockNumber() + 1;
+        if(this->_textEditor->_hotSpots.contains(line)){
+            QToolTip::showText(helpEvent->globalPos(), this->_textEditor->_hotSpots[line], this);
+        }
+        else{
+            QToolTip::hideText();
+            event->ignore();
+        }
+        return true;
+    }
+    return QWidget::event(event);
+}
+
 void TextEditor::keyPressEvent(QKeyEvent *event){
     if(event->key() == Qt::Key_Home){
         //When pressing Home, go to the first non-space character of the line instead of the beginning of the line
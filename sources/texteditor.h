@@ -19,6 +19,7 @@ class TextEditor : public QPlainTextEdit{
 
     protected:
         void paintEvent(QPaintEvent *event) override;
+        bool event(QEvent *event) override;
 
     private:
         TextEditor *_textEditor;
@@ -35,6 +36,8 @@ public:
     void removeError(int line);
     void removeWarning(int line);
 
+    void setHotSpots(const QMap<int, QString> &hotSpots);    //Marks lines in the line number area, the description of each line is shown when hovering the mark
+
 public slots:
     void removeAllErrors();
     void removeAllWarnings();
@@ -50,6 +53,7 @@ protected:
 private:
     LineNumberArea _lineNumberArea;
     QList<int> _linesWithErrors, _linesWithWarnings;
+    QMap<int, QString> _hotSpots;
     SyntaxHighlighter _syntaxHighligher;
 };
 
@@ -78,6 +78,10 @@ TextEditor *TextEditorList::textEditorFromFileName(const QString &fileName) cons
     return this->_textEditors[fileName];
 }
 
+QString TextEditorList::fileNameFromTextEditor(TextEditor *editor) const{
+    return this->_textEditors.key(editor);
+}
+
 bool TextEditorList::undoEnabled(TextEditor *editor) const{
     return this->_undoEnabled[editor];
 }
@@ -20,6 +20,7 @@ public:
     bool removeTextEditor(const QString &fileName);
 
     TextEditor *textEditorFromFileName(const QString &fileName) const;
+    QString fileNameFromTextEditor(TextEditor *editor) const;
     bool undoEnabled(TextEditor *editor) const;
     bool undoEnabled(const QString &fileName) const;
     bool redoEnabled(TextEditor *editor) const;
@@ -0,0 +1,98 @@
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include "thumbnailcache.h"
+#include "spriteloader.h"
+
+ThumbnailCache::ThumbnailCache(const QString &nmlFile, QObject *parent):
+    QObject(parent),
+    _directory(QFileInfo(nmlFile).absoluteDir().filePath(".nmlcreator/thumbnails"))
+{
+    //Thumbnails are less important than the sprites the user is waiting for, so they only use half the processor cores
+    this->_threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+}
+
+QImage ThumbnailCache::thumbnail(const QString &fileName){
+    const QString thumbnailFile = this->thumbnailFile(fileName);
+    if(thumbnailFile.isEmpty()){
+        return QImage();
+    }
+    const QImage thumbnail(thumbnailFile);
+    if(thumbnail.isNull()){
+        this->generate(fileName, thumbnailFile, QImage());
+    }
+    return thumbnail;
+}
+
+void ThumbnailCache::update(const QString &fileName, const QImage &image){
+    const QString thumbnailFile = this->thumbnailFile(fileName);
+    if(!thumbnailFile.isEmpty()){
+        this->generate(fileName, thumbnailFile, image);
+    }
+}
+
+void ThumbnailCache::removeUnused(const QStringList &fileNames){
+    QSet<QString> used;
+    for(const QString &fileName: fileNames){
+        used.insert(QFileInfo(this->thumbnailFile(fileName)).fileName());
+    }
+    for(const QString &thumbnailFile: this->_directory.entryList({"*.png"}, QDir::Files)){
+        if(!used.contains(thumbnailFile) && !this->_pending.contains(this->_directory.filePath(thumbnailFile))){
+            this->_directory.remove(thumbnailFile);
+        }
+    }
+}
+
+QImage ThumbnailCache::createThumbnail(const QImage &image){
+    if(image.isNull()){
+        return QImage();
+    }
+
+    //Index 0 is transparent in OpenTTD, so it's shown as transparent instead of blue
+    QImage transparent = image;
+    if(transparent.format() == QImage::Format_Indexed8 && transparent.colorCount() > 0){
+        transparent.setColor(0, qRgba(0, 0, 0, 0));
+    }
+    //Small sprites are enlarged without smoothing, so that their pixels stay sharp instead of being blurred
+    const bool enlarged = image.width() < size && image.height() < size;
+    return transparent.convertToFormat(QImage::Format_ARGB32).scaled(size, size, Qt::KeepAspectRatio, enlarged ? Qt::FastTransformation : Qt::SmoothTransformation);
+}
+
+QString ThumbnailCache::thumbnailFile(const QString &fileName) const{
+    const QFileInfo file(fileName);
+    if(!file.exists()){
+        return QString();
+    }
+    const QByteArray key = file.absoluteFilePath().toUtf8() + "\n" + QByteArray::number(file.size()) + "\n" + QByteArray::number(file.lastModified().toMSecsSinceEpoch());
+    return this->_directory.filePath(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex() + ".png");
+}
+
+void ThumbnailCache::generate(const QString &fileName, const QString &thumbnailFile, const QImage &image){
+    if(this->_pending.contains(thumbnailFile)){
+        return;
+    }
+    this->_pending.insert(thumbnailFile);
+    this->_directory.mkpath(".");
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    QObject::connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, fileName, thumbnailFile](){
+        this->_pending.remove(thumbnailFile);
+        const QImage thumbnail = watcher->result();
+        watcher->deleteLater();
+        if(!thumbnail.isNull()){
+            emit this->thumbnailReady(fileName, thumbnail);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(&this->_threadPool, [fileName, thumbnailFile, image](){
+        const QImage thumbnail = createThumbnail(image.isNull() ? SpriteLoader::decode(fileName).image : image);
+        if(!thumbnail.isNull()){
+            QSaveFile file(thumbnailFile);
+            if(file.open(QFile::WriteOnly) && thumbnail.save(&file, "png")){
+                file.commit();
+            }
+        }
+        return thumbnail;
+    }));
+}
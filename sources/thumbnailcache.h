@@ -0,0 +1,39 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <QObject>
+#include <QDir>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QSet>
+#include <QThreadPool>
+
+//Small previews of the sprites of a project with the OpenTTD palette, stored in .nmlcreator/thumbnails so that they don't have to be generated again when the project is opened
+//A thumbnail is found by the path, the size and the modification time of its sprite file, so a sprite that changed gets a new thumbnail
+class ThumbnailCache : public QObject{
+    Q_OBJECT
+
+public:
+    static const int size = 32;    //In pixels, the thumbnails keep the aspect ratio of the sprites
+
+    ThumbnailCache(const QString &nmlFile, QObject *parent = nullptr);
+
+    QImage thumbnail(const QString &fileName);    //Returns the cached thumbnail, or a null image and generates it in the background
+    void update(const QString &fileName, const QImage &image);    //Generates the thumbnail of a file that was just saved from an image that is already decoded
+    void removeUnused(const QStringList &fileNames);    //Deletes the thumbnails of the files that don't exist anymore or changed since
+
+    static QImage createThumbnail(const QImage &image);    //Takes an image with the OpenTTD palette
+
+signals:
+    void thumbnailReady(const QString &fileName, const QImage &thumbnail);
+
+private:
+    QString thumbnailFile(const QString &fileName) const;    //Empty if the file doesn't exist
+    void generate(const QString &fileName, const QString &thumbnailFile, const QImage &image);
+
+    const QDir _directory;
+    QThreadPool _threadPool;
+    QSet<QString> _pending;    //The thumbnail files that are being generated
+};
+
+#endif // THUMBNAILCACHE_H
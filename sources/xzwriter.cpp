@@ -0,0 +1,100 @@
+#include <QThread>
+#include "xzwriter.h"
+
+XzWriter::XzWriter(QIODevice *target, QObject *parent):
+    QIODevice(parent),
+    _target(target),
+    _buffer(64 * 1024, '\0'),
+    _failed(false)
+{
+    const lzma_stream stream = LZMA_STREAM_INIT;
+    this->_stream = stream;
+}
+
+XzWriter::~XzWriter(){
+    if(this->isOpen()){
+        this->finish();
+    }
+    lzma_end(&this->_stream);
+}
+
+bool XzWriter::open(OpenMode mode){
+    if(mode != QIODevice::WriteOnly){
+        this->setErrorString(QObject::tr("A compressed file can only be written."));
+        return false;
+    }
+
+    //Each block is compressed by another thread, blocks of the default size (3 times the dictionary size) keep the compression ratio of a single-threaded encoder
+    lzma_mt options = {};
+    options.threads = qMax(1, QThread::idealThreadCount());
+    options.preset = LZMA_PRESET_DEFAULT;
+    options.check = LZMA_CHECK_CRC64;
+    if(lzma_stream_encoder_mt(&this->_stream, &options) != LZMA_OK){
+        this->setErrorString(QObject::tr("Could not start the compression."));
+        return false;
+    }
+    this->_failed = false;
+    return QIODevice::open(mode);
+}
+
+void XzWriter::close(){
+    this->finish();
+}
+
+bool XzWriter::finish(){
+    if(!this->isOpen()){
+        return !this->_failed;
+    }
+    if(!this->_failed){
+        this->_stream.next_in = nullptr;
+        this->_stream.avail_in = 0;
+        this->_failed = !this->encode(LZMA_FINISH);
+    }
+    QIODevice::close();
+    return !this->_failed;
+}
+
+bool XzWriter::isSequential() const{
+    return true;
+}
+
+qint64 XzWriter::readData(char*, qint64){
+    return -1;
+}
+
+qint64 XzWriter::writeData(const char *data, qint64 size){
+    if(this->_failed){
+        return -1;
+    }
+    this->_stream.next_in = reinterpret_cast<const uint8_t*>(data);
+    this->_stream.avail_in = size;
+    if(!this->encode(LZMA_RUN)){
+        this->_failed = true;
+        return -1;
+    }
+    return size;
+}
+
+bool XzWriter::encode(lzma_action action){
+    while(true){
+        this->_stream.next_out = reinterpret_cast<uint8_t*>(this->_buffer.data());
+        this->_stream.avail_out = this->_buffer.size();
+        const lzma_ret result = lzma_code(&this->_stream, action);
+
+        const qint64 compressedSize = this->_buffer.size() - this->_stream.avail_out;
+        if(compressedSize > 0 && this->_target->write(this->_buffer.constData(), compressedSize) != compressedSize){
+            this->setErrorString(this->_target->errorString());
+            return false;
+        }
+        if(result == LZMA_STREAM_END){
+            return true;
+        }
+        else if(result != LZMA_OK){
+            this->setErrorString(QObject::tr("The compression failed (liblzma error %1).").arg(result));
+            return false;
+        }
+        else if(action == LZMA_RUN && this->_stream.avail_in == 0 && this->_stream.avail_out > 0){
+            return true;    //The threads took all the data, the rest of the compressed data is written by the next calls
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef XZWRITER_H
+#define XZWRITER_H
+
+#include <QIODevice>
+#include <lzma.h>
+
+//Compresses everything written to it in the .xz format and writes the result to another device
+//The compression runs on several threads of liblzma, this device only passes the data to them
+class XzWriter : public QIODevice{
+public:
+    XzWriter(QIODevice *target, QObject *parent = nullptr);    //target must already be open for writing and is not closed by this device
+    ~XzWriter() override;
+
+    bool open(OpenMode mode) override;    //Only QIODevice::WriteOnly is supported
+    void close() override;
+    bool finish();    //Writes the end of the .xz stream and closes the device, returns false if something couldn't be compressed or written
+    bool isSequential() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    bool encode(lzma_action action);
+
+    QIODevice *const _target;
+    lzma_stream _stream;
+    QByteArray _buffer;
+    bool _failed;
+};
+
+#endif // XZWRITER_H